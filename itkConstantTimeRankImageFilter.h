@@ -0,0 +1,153 @@
+#ifndef __itkConstantTimeRankImageFilter_h
+#define __itkConstantTimeRankImageFilter_h
+
+#include "itkBoxImageFilter.h"
+#include <vector>
+
+namespace itk {
+
+/**
+ * \class ConstantTimeRankImageFilter
+ * \brief Rank filter with a box kernel and a cost independent of the radius
+ *
+ * This filter produces the same output as RankImageFilter with a box
+ * kernel, but uses the algorithm described by Perreault and Hebert in
+ * "Median Filtering in Constant Time" (IEEE Transactions on Image
+ * Processing, 2007). One histogram is kept for each column of the image.
+ * When moving to the next line, each column histogram is updated with
+ * one added and one removed pixel. The histogram of the kernel is then
+ * moved along the line by adding and removing whole column histograms.
+ * The cost per pixel doesn't depend on the radius, so this filter is
+ * interesting for large radii, where RankImageFilter has to update its
+ * histogram with 2*r+1 pixels at each step.
+ *
+ * The histograms are split in a coarse level of 16 bins and a fine level
+ * of 16 bins per coarse bin. Only the coarse level of the kernel
+ * histogram is updated at each pixel. The fine level of a coarse bin is
+ * only updated when the rank value falls in that bin.
+ *
+ * This filter only supports 2D images with an 8 bit integer pixel type
+ * (char, signed char or unsigned char). An exception is thrown for the
+ * other images. The neighborhood is cropped at the image boundary, as in
+ * RankImageFilter.
+ *
+ * \sa RankImageFilter, FastApproxRankImageFilter
+ */
+
+template<class TInputImage, class TOutputImage>
+class ITK_EXPORT ConstantTimeRankImageFilter :
+public BoxImageFilter<TInputImage, TOutputImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef ConstantTimeRankImageFilter Self;
+  typedef BoxImageFilter<TInputImage,TOutputImage>  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(ConstantTimeRankImageFilter,
+               BoxImageFilter);
+
+  /** Image related typedefs. */
+  typedef TInputImage InputImageType;
+  typedef typename TInputImage::RegionType RegionType ;
+  typedef typename TInputImage::SizeType SizeType ;
+  typedef typename TInputImage::IndexType IndexType ;
+  typedef typename TInputImage::OffsetType OffsetType ;
+  typedef typename TInputImage::PixelType InputPixelType ;
+
+  typedef TOutputImage OutputImageType;
+  typedef typename TOutputImage::PixelType OutputPixelType ;
+  typedef typename TOutputImage::RegionType OutputImageRegionType ;
+
+  /** Image related typedefs. */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+  /** n-dimensional Kernel radius. */
+  typedef typename TInputImage::SizeType RadiusType ;
+
+  itkSetMacro(Rank, float)
+  itkGetMacro(Rank, float)
+
+protected:
+  ConstantTimeRankImageFilter();
+  ~ConstantTimeRankImageFilter() {};
+
+  /** Check that the image is supported */
+  void BeforeThreadedGenerateData();
+
+  void ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+                            int threadId);
+
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+private:
+  ConstantTimeRankImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  // the number of pixels of a bin can't be larger than the number of
+  // pixels in the kernel
+  typedef unsigned int CountType;
+
+  // 256 bins for the 8 bit values, in 16 coarse bins
+  enum { Bins = 256, CoarseBins = 16, FineBins = 16, CoarseShift = 4 };
+
+  static inline unsigned int ToBin( const InputPixelType & p )
+    {
+    return (unsigned int)( p - NumericTraits< InputPixelType >::NonpositiveMin() );
+    }
+
+  // update the histograms of the columns with a line of the image
+  static inline void AddLine( CountType * fine, CountType * coarse,
+                              const InputPixelType * line, long nbColumns )
+    {
+    for( long c=0; c<nbColumns; c++, fine += Bins, coarse += CoarseBins )
+      {
+      unsigned int bin = ToBin( line[c] );
+      fine[bin]++;
+      coarse[bin >> CoarseShift]++;
+      }
+    }
+
+  static inline void RemoveLine( CountType * fine, CountType * coarse,
+                                 const InputPixelType * line, long nbColumns )
+    {
+    for( long c=0; c<nbColumns; c++, fine += Bins, coarse += CoarseBins )
+      {
+      unsigned int bin = ToBin( line[c] );
+      fine[bin]--;
+      coarse[bin >> CoarseShift]--;
+      }
+    }
+
+  // add or remove n bins of src to dest
+  static inline void AddBins( CountType * dest, const CountType * src, unsigned int n )
+    {
+    for( unsigned int i=0; i<n; i++ )
+      {
+      dest[i] += src[i];
+      }
+    }
+
+  static inline void RemoveBins( CountType * dest, const CountType * src, unsigned int n )
+    {
+    for( unsigned int i=0; i<n; i++ )
+      {
+      dest[i] -= src[i];
+      }
+    }
+
+  float m_Rank;
+};
+
+}
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkConstantTimeRankImageFilter.txx"
+#endif
+
+#endif
@@ -0,0 +1,211 @@
+#ifndef __itkConstantTimeRankImageFilter_txx
+#define __itkConstantTimeRankImageFilter_txx
+
+#include "itkConstantTimeRankImageFilter.h"
+#include "itkProgressReporter.h"
+#include "itkNumericTraits.h"
+#include <algorithm>
+
+namespace itk {
+
+template <class TInputImage, class TOutputImage>
+ConstantTimeRankImageFilter<TInputImage, TOutputImage>
+::ConstantTimeRankImageFilter()
+{
+  m_Rank = 0.5;
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+ConstantTimeRankImageFilter<TInputImage, TOutputImage>
+::BeforeThreadedGenerateData()
+{
+  if( ImageDimension != 2 )
+    {
+    itkExceptionMacro( << "ConstantTimeRankImageFilter only supports 2D images." );
+    }
+  if( sizeof( InputPixelType ) != 1 || !NumericTraits< InputPixelType >::is_integer )
+    {
+    itkExceptionMacro( << "ConstantTimeRankImageFilter only supports 8 bit integer pixel types." );
+    }
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+ConstantTimeRankImageFilter<TInputImage, TOutputImage>
+::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+                       int threadId)
+{
+  if( outputRegionForThread.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+  ProgressReporter progress(this, threadId, outputRegionForThread.GetSize()[1]);
+
+  const InputImageType * inputImage = this->GetInput();
+  OutputImageType * outputImage = this->GetOutput();
+  const RegionType & inputRegion = inputImage->GetRequestedRegion();
+  const long rx = this->GetRadius()[0];
+  const long ry = this->GetRadius()[1];
+
+  // the bounds, all included, of the input, of the output region and
+  // of the columns which can be in the kernel
+  const long inX0 = inputRegion.GetIndex()[0];
+  const long inX1 = inX0 + (long)inputRegion.GetSize()[0] - 1;
+  const long inY0 = inputRegion.GetIndex()[1];
+  const long inY1 = inY0 + (long)inputRegion.GetSize()[1] - 1;
+  const long x0 = outputRegionForThread.GetIndex()[0];
+  const long x1 = x0 + (long)outputRegionForThread.GetSize()[0] - 1;
+  const long y0 = outputRegionForThread.GetIndex()[1];
+  const long y1 = y0 + (long)outputRegionForThread.GetSize()[1] - 1;
+  const long cx0 = std::max( x0 - rx, inX0 );
+  const long cx1 = std::min( x1 + rx, inX1 );
+  const long nbColumns = cx1 - cx0 + 1;
+
+  // the column histograms, indexed from cx0
+  std::vector< CountType > colFine( nbColumns * Bins, 0 );
+  std::vector< CountType > colCoarse( nbColumns * CoarseBins, 0 );
+  CountType * fine = &colFine[0];
+  CountType * coarse = &colCoarse[0];
+
+  // the kernel histogram. The fine level of the coarse bin b is the one
+  // of the kernel centered on the column fineColumn[b] of the current
+  // line.
+  CountType kernelCoarse[CoarseBins];
+  CountType kernelFine[Bins];
+  long fineColumn[CoarseBins];
+
+  // a line of the input, starting at column cx0
+  IndexType idx;
+  idx[0] = cx0;
+  const InputPixelType * inBuffer = inputImage->GetBufferPointer();
+  OutputPixelType * outBuffer = outputImage->GetBufferPointer();
+
+  // initialize the column histograms for the first line
+  for( long y = std::max( y0 - ry, inY0 ); y <= std::min( y0 + ry, inY1 ); y++ )
+    {
+    idx[1] = y;
+    AddLine( fine, coarse, inBuffer + inputImage->ComputeOffset( idx ), nbColumns );
+    }
+
+  for( long y=y0; y<=y1; y++ )
+    {
+    if( y > y0 )
+      {
+      // move the column histograms one line down
+      if( y + ry <= inY1 )
+        {
+        idx[1] = y + ry;
+        AddLine( fine, coarse, inBuffer + inputImage->ComputeOffset( idx ), nbColumns );
+        }
+      if( y - ry - 1 >= inY0 )
+        {
+        idx[1] = y - ry - 1;
+        RemoveLine( fine, coarse, inBuffer + inputImage->ComputeOffset( idx ), nbColumns );
+        }
+      }
+    const unsigned long nbLines = std::min( y + ry, inY1 ) - std::max( y - ry, inY0 ) + 1;
+
+    // the kernel histogram at the start of the line. The fine levels
+    // are marked as too old to be updated incrementally.
+    std::fill( kernelCoarse, kernelCoarse + CoarseBins, 0 );
+    for( long c = std::max( x0 - rx, inX0 ); c <= std::min( x0 + rx, inX1 ); c++ )
+      {
+      AddBins( kernelCoarse, coarse + ( c - cx0 ) * CoarseBins, CoarseBins );
+      }
+    for( unsigned int b=0; b<CoarseBins; b++ )
+      {
+      fineColumn[b] = x0 - 2 * rx - 2;
+      }
+
+    // idx stays on column cx0 for the column histograms
+    IndexType outIdx;
+    outIdx[0] = x0;
+    outIdx[1] = y;
+    OutputPixelType * outPtr = outBuffer + outputImage->ComputeOffset( outIdx );
+    for( long x=x0; x<=x1; x++, outPtr++ )
+      {
+      if( x > x0 )
+        {
+        if( x + rx <= inX1 )
+          {
+          AddBins( kernelCoarse, coarse + ( x + rx - cx0 ) * CoarseBins, CoarseBins );
+          }
+        if( x - rx - 1 >= inX0 )
+          {
+          RemoveBins( kernelCoarse, coarse + ( x - rx - 1 - cx0 ) * CoarseBins, CoarseBins );
+          }
+        }
+
+      // same target as the moving histogram rank filters
+      const unsigned long nbPixels = ( std::min( x + rx, inX1 ) - std::max( x - rx, inX0 ) + 1 ) * nbLines;
+      const unsigned long target = (unsigned long)( m_Rank * ( nbPixels - 1 ) ) + 1;
+
+      // find the coarse bin of the rank value
+      unsigned long total = 0;
+      unsigned int b = 0;
+      while( total + kernelCoarse[b] < target )
+        {
+        total += kernelCoarse[b];
+        b++;
+        }
+
+      // bring its fine level up to date, from scratch if the kernel has
+      // moved by more than its size since its last update
+      CountType * kf = kernelFine + b * FineBins;
+      const unsigned int offset = b * FineBins;
+      if( x - fineColumn[b] > 2 * rx + 1 )
+        {
+        std::fill( kf, kf + FineBins, 0 );
+        for( long c = std::max( x - rx, inX0 ); c <= std::min( x + rx, inX1 ); c++ )
+          {
+          AddBins( kf, fine + ( c - cx0 ) * Bins + offset, FineBins );
+          }
+        }
+      else
+        {
+        for( long c = fineColumn[b] + 1; c <= x; c++ )
+          {
+          if( c + rx <= inX1 )
+            {
+            AddBins( kf, fine + ( c + rx - cx0 ) * Bins + offset, FineBins );
+            }
+          if( c - rx - 1 >= inX0 )
+            {
+            RemoveBins( kf, fine + ( c - rx - 1 - cx0 ) * Bins + offset, FineBins );
+            }
+          }
+        }
+      fineColumn[b] = x;
+
+      unsigned int f = 0;
+      total += kf[0];
+      while( total < target )
+        {
+        f++;
+        total += kf[f];
+        }
+
+      *outPtr = static_cast< OutputPixelType >( (InputPixelType)( offset + f + NumericTraits< InputPixelType >::NonpositiveMin() ) );
+      }
+    progress.CompletedPixel();
+    }
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+ConstantTimeRankImageFilter<TInputImage, TOutputImage>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Rank: " << static_cast<typename NumericTraits< float >::PrintType>( m_Rank ) << std::endl;
+}
+
+}
+
+
+#endif
@@ -3,9 +3,6 @@
 
 #include "itkBoxImageFilter.h"
 #include "itkMaskedRankImageFilter.h"
-#include "itkNotImageFilter.h"
-#include "itkMaskNegatedImageFilter.h"
-#include "itkMaskImageFilter.h"
 
 namespace itk {
 
@@ -21,6 +18,15 @@ namespace itk {
  * the mask, based on values inside the mask. i.e if (i,j) is not
  * in the mask, but some of the pixels in the kernel centred on (i,j)
  * are, then output pixel (i,j) will be the median of those pixels.
+ *
+ * The mask is packed once with one bit per pixel (see PackedMask) and
+ * shared by all the stages of the filter. When WriteInsideMask is off,
+ * each stage passes its output mask to the next one in the same packed
+ * form, so no mask image is allocated for the intermediate stages.
+ * The last stage writes directly in the output: only the pixels of its
+ * output mask (ReturnUnion) or out of the input mask (the default) get
+ * their value, the others are set to zero, without any pass over the
+ * image after the rank filters.
  * \author Richard Beare
  */
 
@@ -103,6 +109,9 @@ protected:
   FastApproxMaskRankImageFilter();
   ~FastApproxMaskRankImageFilter() {};
 
+  /** The mask is read on the same region as the input */
+  void GenerateInputRequestedRegion();
+
   void GenerateData();
 
 private:
@@ -134,15 +143,20 @@ private:
 								   TInputImage, 
 								   KernelType> ERankType1;
 
-  typename ERankType1::Pointer m_EFilts[TInputImage::ImageDimension];
+  typename ERankType1::Pointer m_EFilts[TInputImage::ImageDimension - 1];
+  // the last stage writes in the output
+  typename RankType1::Pointer m_LastEFilt;
+
+  // the mask shared by all the stages
+  typedef typename ERankType1::PackedMaskType PackedMaskType;
+  PackedMaskType m_PackedMask;
 
-  typedef typename itk::MaskNegatedImageFilter<TInputImage, TMaskImage, TOutputImage> NegMaskType;
-  typedef typename itk::MaskImageFilter<TInputImage, TMaskImage, TOutputImage> MaskType;
+  // the pixels out of the mask, written by the last stage when
+  // ReturnUnion is off
+  PackedMaskType m_PackedOutsideMask;
 
 /*  typedef typename itk::ImageFileWriter<TMaskImage> WriterType;
   typename WriterType::Pointer m_Writer;*/
-  typename MaskType::Pointer m_MaskFilt;
-  typename NegMaskType::Pointer m_NegMaskFilt;
   
 };
 
@@ -18,13 +18,12 @@ FastApproxMaskRankImageFilter<TInputImage, TMaskImage, TOutputImage>
     {
     m_otherFilts[i] = RankType2::New();
     }
-  for (unsigned i = 0; i < TInputImage::ImageDimension; i++)
+  for (unsigned i = 0; i < TInputImage::ImageDimension - 1; i++)
     {
     m_EFilts[i] = ERankType1::New();
-    m_EFilts[i]->SetGenerateOutputMask( true );
+    m_EFilts[i]->SetGeneratePackedOutputMask( true );
     }
-  m_MaskFilt = MaskType::New();
-  m_NegMaskFilt = NegMaskType::New();
+  m_LastEFilt = RankType1::New();
 /*  m_Writer = WriterType::New();*/
 }
 
@@ -40,12 +39,11 @@ FastApproxMaskRankImageFilter<TInputImage, TMaskImage, TOutputImage>
     {
     m_otherFilts[i]->Modified();
     }
-  for (unsigned i = 0; i < TInputImage::ImageDimension; i++)
+  for (unsigned i = 0; i < TInputImage::ImageDimension - 1; i++)
     {
     m_EFilts[i]->Modified();
     }
-  m_MaskFilt->Modified();
-  m_NegMaskFilt->Modified();
+  m_LastEFilt->Modified();
 }
 
 
@@ -60,12 +58,26 @@ FastApproxMaskRankImageFilter<TInputImage, TMaskImage, TOutputImage>
     {
     m_otherFilts[i]->SetNumberOfThreads( nb );
     }
-  for (unsigned i = 0; i < TInputImage::ImageDimension; i++)
+  for (unsigned i = 0; i < TInputImage::ImageDimension - 1; i++)
     {
     m_EFilts[i]->SetNumberOfThreads( nb );
     }
-  m_MaskFilt->SetNumberOfThreads( nb );
-  m_NegMaskFilt->SetNumberOfThreads( nb );
+  m_LastEFilt->SetNumberOfThreads( nb );
+}
+
+
+template <class TInputImage, class TMaskImage, class TOutputImage>
+void
+FastApproxMaskRankImageFilter<TInputImage, TMaskImage, TOutputImage>
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  MaskImageType * mask = this->GetMaskImage();
+  if( mask && this->GetInput() )
+    {
+    mask->SetRequestedRegion( this->GetInput()->GetRequestedRegion() );
+    }
 }
 
 
@@ -78,6 +90,10 @@ FastApproxMaskRankImageFilter<TInputImage, TMaskImage, TOutputImage>
   ProgressAccumulator::Pointer progress = ProgressAccumulator::New();
   progress->SetMiniPipelineFilter(this);
   this->AllocateOutputs();
+
+  // the stages read the mask image in its packed form only
+  m_PackedMask.Pack( this->GetMaskImage(), m_firstFilt->GetMaskValue() );
+
   if (m_WriteInsideMask)
     {
     // set up the pipeline
@@ -86,15 +102,15 @@ FastApproxMaskRankImageFilter<TInputImage, TMaskImage, TOutputImage>
       if (i > 0) 
 	{
 	m_otherFilts[i]->SetInput(m_otherFilts[i-1]->GetOutput());
-	m_otherFilts[i]->SetMaskImage(this->GetMaskImage());
+	m_otherFilts[i]->SetPackedMask(&m_PackedMask);
 	m_otherFilts[i]->SetRank(m_Rank);
 	}
       }
     m_firstFilt->SetInput(this->GetInput());
-    m_firstFilt->SetMaskImage(this->GetMaskImage());
+    m_firstFilt->SetPackedMask(&m_PackedMask);
     m_firstFilt->SetRank(m_Rank);
     m_otherFilts[0]->SetInput( m_firstFilt->GetOutput() );
-    m_otherFilts[0]->SetMaskImage(this->GetMaskImage());
+    m_otherFilts[0]->SetPackedMask(&m_PackedMask);
     m_otherFilts[0]->SetRank(m_Rank);
     // set up the kernels
     for (unsigned i = 0; i< TInputImage::ImageDimension; i++)
@@ -126,14 +142,19 @@ FastApproxMaskRankImageFilter<TInputImage, TMaskImage, TOutputImage>
     {
     
     m_EFilts[0]->SetInput(this->GetInput());
-    m_EFilts[0]->SetMaskImage(this->GetMaskImage());
+    m_EFilts[0]->SetPackedMask(&m_PackedMask);
     m_EFilts[0]->SetRank(m_Rank);
-    for (unsigned i = 1; i < TInputImage::ImageDimension; i++)
+    for (unsigned i = 1; i < TInputImage::ImageDimension - 1; i++)
       {
+      // the packed output mask of the previous stage is filled when the
+      // previous stage is updated, before this one runs
       m_EFilts[i]->SetInput(m_EFilts[i-1]->GetOutput());
-      m_EFilts[i]->SetMaskImage(m_EFilts[i-1]->GetOutputMask());
+      m_EFilts[i]->SetPackedMask(m_EFilts[i-1]->GetPackedOutputMask());
       m_EFilts[i]->SetRank(m_Rank);
       }
+    m_LastEFilt->SetInput(m_EFilts[TInputImage::ImageDimension - 2]->GetOutput());
+    m_LastEFilt->SetPackedMask(m_EFilts[TInputImage::ImageDimension - 2]->GetPackedOutputMask());
+    m_LastEFilt->SetRank(m_Rank);
     
     // set up kernels
     for (unsigned i = 0; i< TInputImage::ImageDimension; i++)
@@ -146,24 +167,35 @@ FastApproxMaskRankImageFilter<TInputImage, TMaskImage, TOutputImage>
 	{
 	*kit=1;
 	}
+      if (i < TInputImage::ImageDimension - 1)
+	{
 	m_EFilts[i]->SetKernel(m_kernels[i]);
 	progress->RegisterInternalFilter(m_EFilts[i], 1.0/TInputImage::ImageDimension);
+	}
+      else
+	{
+	m_LastEFilt->SetKernel(m_kernels[i]);
+	progress->RegisterInternalFilter(m_LastEFilt, 1.0/TInputImage::ImageDimension);
+	}
       }
+
+    // the last stage already writes the fill value, zero, out of its
+    // output mask, as MaskImageFilter would do with that mask.
+    // MaskNegatedImageFilter would only keep the pixels where the input
+    // mask is zero: the last stage only writes the value of those
+    // pixels.
     if (this->GetReturnUnion())
       {
-      m_MaskFilt->SetInput(m_EFilts[TInputImage::ImageDimension - 1]->GetOutput());
-      m_MaskFilt->SetInput2(m_EFilts[TInputImage::ImageDimension - 1]->GetOutputMask());
-      m_MaskFilt->Update();
-      this->GraftOutput(m_MaskFilt->GetOutput());
+      m_LastEFilt->SetPackedWriteMask(NULL);
       }
     else
       {
-      m_NegMaskFilt->SetInput(m_EFilts[TInputImage::ImageDimension - 1]->GetOutput());
-      m_NegMaskFilt->SetInput2(this->GetMaskImage());
-      m_NegMaskFilt->Update();
-      this->GraftOutput(m_NegMaskFilt->GetOutput());
+      m_PackedOutsideMask.Pack( this->GetMaskImage(), NumericTraits<MaskPixelType>::Zero );
+      m_LastEFilt->SetPackedWriteMask(&m_PackedOutsideMask);
       }
-
+    m_LastEFilt->GraftOutput(this->GetOutput());
+    m_LastEFilt->Update();
+    this->GraftOutput(m_LastEFilt->GetOutput());
 
 //     typename MaskImageType::Pointer lastmask = m_EFilts[TInputImage::ImageDimension - 1]->GetOutputMask();
 //     lastmask->Update();
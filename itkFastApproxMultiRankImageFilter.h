@@ -0,0 +1,119 @@
+#ifndef __itkFastApproxMultiRankImageFilter_h
+#define __itkFastApproxMultiRankImageFilter_h
+
+#include "itkBoxImageFilter.h"
+#include "itkMultiRankImageFilter.h"
+#include "itkNeighborhood.h"
+#include <vector>
+
+namespace itk {
+
+/**
+ * \class FastApproxMultiRankImageFilter
+ * \brief A separable filter computing several ranks in a single pass
+ *
+ * This filter is to FastApproxRankImageFilter what MultiRankImageFilter
+ * is to RankImageFilter. The first dimension is processed with a
+ * MultiRankImageFilter, which computes all the ranks with a single
+ * histogram. The other dimensions work on the vector image produced by
+ * the first step: each component is filtered at its own rank, so the
+ * component i of the output is the same as the output of a
+ * FastApproxRankImageFilter with the rank i.
+ *
+ * The output image must be a VectorImage. It is also used for the
+ * intermediate results, so its component type should be able to store
+ * the input values exactly.
+ *
+ * \sa FastApproxRankImageFilter, MultiRankImageFilter
+ * \author Richard Beare
+ */
+
+template<class TInputImage, class TOutputImage>
+class ITK_EXPORT FastApproxMultiRankImageFilter :
+public BoxImageFilter<TInputImage, TOutputImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef FastApproxMultiRankImageFilter Self;
+  typedef BoxImageFilter<TInputImage,TOutputImage>  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(FastApproxMultiRankImageFilter,
+               BoxImageFilter);
+
+  /** Image related typedefs. */
+  typedef TInputImage InputImageType;
+  typedef typename TInputImage::RegionType RegionType ;
+  typedef typename TInputImage::SizeType SizeType ;
+  typedef typename TInputImage::IndexType IndexType ;
+  typedef typename TInputImage::PixelType PixelType ;
+  typedef typename TInputImage::OffsetType OffsetType ;
+
+  typedef TOutputImage OutputImageType;
+  typedef typename TOutputImage::PixelType OutputPixelType ;
+
+  /** Image related typedefs. */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+  /** n-dimensional Kernel radius. */
+  typedef typename TInputImage::SizeType RadiusType ;
+
+  typedef Neighborhood<bool, itkGetStaticConstMacro(ImageDimension)> KernelType;
+  typedef MultiRankImageFilter< InputImageType, OutputImageType, KernelType > FirstFilterType;
+  typedef MultiRankImageFilter< OutputImageType, OutputImageType, KernelType > OtherFilterType;
+
+  typedef typename FirstFilterType::RanksType RanksType;
+
+  virtual void SetRadius( const RadiusType & );
+
+  virtual void SetRadius( const unsigned long & radius )
+    {
+    // needed because of the overloading of the method
+    Superclass::SetRadius( radius );
+    }
+
+  /** The ranks to compute, between 0 and 1. There is one output
+   * component per rank. Defaults to a single rank of 0.5 (median). */
+  void SetRanks( const RanksType & ranks );
+  itkGetConstReferenceMacro(Ranks, RanksType);
+
+  virtual void Modified() const;
+
+  virtual void SetNumberOfThreads( int nb );
+
+protected:
+  FastApproxMultiRankImageFilter();
+  ~FastApproxMultiRankImageFilter() {};
+
+  /** Set the number of components of the output to the number of
+   * ranks */
+  void GenerateOutputInformation();
+
+  void GenerateData();
+
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  typename FirstFilterType::Pointer m_FirstFilter;
+
+  // one filter per dimension after the first one
+  std::vector< typename OtherFilterType::Pointer > m_OtherFilters;
+
+private:
+  FastApproxMultiRankImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  RanksType m_Ranks;
+};
+
+}
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkFastApproxMultiRankImageFilter.txx"
+#endif
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef __itkFastApproxMultiRankImageFilter_txx
+#define __itkFastApproxMultiRankImageFilter_txx
+
+#include "itkFastApproxMultiRankImageFilter.h"
+#include "itkProgressAccumulator.h"
+#include "itkNumericTraits.h"
+
+namespace itk {
+
+template <class TInputImage, class TOutputImage>
+FastApproxMultiRankImageFilter<TInputImage, TOutputImage>
+::FastApproxMultiRankImageFilter()
+{
+  // create the pipeline
+  m_FirstFilter = FirstFilterType::New();
+  m_FirstFilter->ReleaseDataFlagOn();
+  m_OtherFilters.resize( ImageDimension - 1 );
+  for( unsigned i = 0; i < ImageDimension - 1; i++ )
+    {
+    m_OtherFilters[i] = OtherFilterType::New();
+    m_OtherFilters[i]->ReleaseDataFlagOn();
+    if( i > 0 )
+      {
+      m_OtherFilters[i]->SetInput( m_OtherFilters[i-1]->GetOutput() );
+      }
+    else
+      {
+      m_OtherFilters[i]->SetInput( m_FirstFilter->GetOutput() );
+      }
+    }
+
+  RanksType ranks;
+  ranks.push_back( 0.5 );
+  this->SetRanks( ranks );
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+FastApproxMultiRankImageFilter<TInputImage, TOutputImage>
+::SetRanks( const RanksType & ranks )
+{
+  if( m_Ranks != ranks )
+    {
+    m_Ranks = ranks;
+    m_FirstFilter->SetRanks( m_Ranks );
+    for (unsigned i = 0; i < ImageDimension - 1; i++)
+      {
+      m_OtherFilters[i]->SetRanks( m_Ranks );
+      }
+    this->Modified();
+    }
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+FastApproxMultiRankImageFilter<TInputImage, TOutputImage>
+::Modified() const
+{
+  Superclass::Modified();
+  m_FirstFilter->Modified();
+  for (unsigned i = 0; i < ImageDimension - 1; i++)
+    {
+    m_OtherFilters[i]->Modified();
+    }
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+FastApproxMultiRankImageFilter<TInputImage, TOutputImage>
+::SetNumberOfThreads( int nb )
+{
+  Superclass::SetNumberOfThreads( nb );
+  m_FirstFilter->SetNumberOfThreads( nb );
+  for (unsigned i = 0; i < ImageDimension - 1; i++)
+    {
+    m_OtherFilters[i]->SetNumberOfThreads( nb );
+    }
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+FastApproxMultiRankImageFilter<TInputImage, TOutputImage>
+::SetRadius( const RadiusType & radius )
+{
+  Superclass::SetRadius( radius );
+
+  // set up the kernels
+  RadiusType rad;
+  rad.Fill(0);
+  rad[0] = radius[0];
+  m_FirstFilter->SetRadius( rad );
+  for (unsigned i = 1; i< ImageDimension; i++)
+    {
+    rad.Fill(0);
+    rad[i] = radius[i];
+    m_OtherFilters[i-1]->SetRadius( rad );
+    }
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+FastApproxMultiRankImageFilter<TInputImage, TOutputImage>
+::GenerateOutputInformation()
+{
+  Superclass::GenerateOutputInformation();
+
+  if( m_Ranks.empty() )
+    {
+    itkExceptionMacro( << "At least one rank must be set." );
+    }
+  this->GetOutput()->SetVectorLength( m_Ranks.size() );
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+FastApproxMultiRankImageFilter<TInputImage, TOutputImage>
+::GenerateData()
+{
+  // set up the pipeline
+  m_FirstFilter->SetInput( this->GetInput() );
+
+  // Create a process accumulator for tracking the progress of this minipipeline
+  ProgressAccumulator::Pointer progress = ProgressAccumulator::New();
+  progress->SetMiniPipelineFilter(this);
+  progress->RegisterInternalFilter( m_FirstFilter, 1.0/ImageDimension );
+  for( unsigned i = 0; i< ImageDimension - 1; i++ )
+    {
+    progress->RegisterInternalFilter( m_OtherFilters[i], 1.0/ImageDimension );
+    }
+
+  // the last filter directly writes in the output of this filter
+  if( ImageDimension > 1 )
+    {
+    OtherFilterType * last = m_OtherFilters[ImageDimension - 2];
+    last->GraftOutput( this->GetOutput() );
+    last->Update();
+    this->GraftOutput( last->GetOutput() );
+    }
+  else
+    {
+    m_FirstFilter->GraftOutput( this->GetOutput() );
+    m_FirstFilter->Update();
+    this->GraftOutput( m_FirstFilter->GetOutput() );
+    }
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+FastApproxMultiRankImageFilter<TInputImage, TOutputImage>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Ranks:";
+  for( unsigned int i=0; i<m_Ranks.size(); i++ )
+    {
+    os << " " << static_cast<typename NumericTraits< float >::PrintType>( m_Ranks[i] );
+    }
+  os << std::endl;
+}
+
+}
+
+
+#endif
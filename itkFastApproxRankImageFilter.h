@@ -2,10 +2,111 @@
 #define __itkFastApproxRankImageFilter_h
 
 #include "itkSeparableImageFilter.h"
+#include "itkFusedSeparableImageFilter.h"
 #include "itkRankImageFilter.h"
+#include "itkRankHistogram.h"
+#include "itkVanHerkGilWermanLine.h"
 
 namespace itk {
 
+namespace Function {
+
+/** The line function of FusedSeparableImageFilter for the ranks. The
+ * rank of the window is computed with the histogram used by
+ * RankImageFilter for the pixel type, or with the algorithm of van Herk
+ * and Gil-Werman for the minimum and the maximum, so the result is the
+ * one of the separable pipeline. */
+template <class TInputPixel>
+class SeparableRankLine
+{
+public:
+  typedef TInputPixel ValueType;
+  typedef typename RankHistogramSelector< TInputPixel >::Type HistogramType;
+
+  SeparableRankLine()
+    : m_Minimum( VanHerkGilWermanIdentity< TInputPixel >::Minimum() ),
+      m_Maximum( VanHerkGilWermanIdentity< TInputPixel >::Maximum() )
+    {
+    this->SetRank( 0.5 );
+    }
+
+  // the work areas of the extremum lines aren't copied
+  SeparableRankLine( const SeparableRankLine & line )
+    : m_Minimum( VanHerkGilWermanIdentity< TInputPixel >::Minimum() ),
+      m_Maximum( VanHerkGilWermanIdentity< TInputPixel >::Maximum() )
+    {
+    this->SetRank( line.m_Rank );
+    }
+
+  void operator=( const SeparableRankLine & line )
+    {
+    this->SetRank( line.m_Rank );
+    }
+
+  void SetRank( float rank )
+    {
+    m_Rank = rank;
+    m_Histogram = HistogramType();
+    m_Histogram.SetRank( rank );
+    }
+
+  float GetRank() const
+    {
+    return m_Rank;
+    }
+
+  inline void SetAxis( unsigned int ) {}
+
+  inline void Compute( const ValueType * in, long n, long begin, long end, long radius, ValueType * out )
+    {
+    if( m_Rank == 0 )
+      {
+      m_Minimum.Compute( in, n, begin, end, radius, out );
+      return;
+      }
+    if( m_Rank == 1 )
+      {
+      m_Maximum.Compute( in, n, begin, end, radius, out );
+      return;
+      }
+
+    // the moving histogram, which adds the new pixels before removing
+    // the old ones, like MovingHistogramImageFilter
+    HistogramType histogram = m_Histogram;
+    for( long k=std::max( begin - radius, 0L ); k<=std::min( begin + radius, n - 1 ); k++ )
+      {
+      histogram.AddPixel( in[k] );
+      }
+    out[0] = histogram.GetValue( in[begin] );
+    for( long p=begin+1; p<end; p++ )
+      {
+      if( p + radius < n )
+        {
+        histogram.AddPixel( in[p + radius] );
+        }
+      if( p - radius - 1 >= 0 )
+        {
+        histogram.RemovePixel( in[p - radius - 1] );
+        }
+      out[p - begin] = histogram.GetValue( in[p] );
+      }
+    }
+
+  inline const ValueType & GetValue( const ValueType & v, unsigned long ) const
+    {
+    return v;
+    }
+
+private:
+  float m_Rank;
+  // an empty histogram, with the rank
+  HistogramType m_Histogram;
+  VanHerkGilWermanLine< TInputPixel, std::less< TInputPixel > > m_Minimum;
+  VanHerkGilWermanLine< TInputPixel, std::greater< TInputPixel > > m_Maximum;
+};
+
+} // end namespace Function
+
 /**
  * \class FastApproxRankImageFilter
  * \brief A separable rank filter
@@ -14,6 +115,17 @@ namespace itk {
  * to be relatively quick then it is worthwhile pretending that they
  * are.
  *
+ * The ranks 0 and 1 are the minimum and the maximum, which are
+ * separable: the result is then exact, and is computed along each axis
+ * with the algorithm of van Herk and Gil-Werman by RankImageFilter.
+ *
+ * By default, all the axes are processed at once by
+ * FusedSeparableImageFilter, in a work area of the size of a few
+ * slices, so the input and the output images are read and written
+ * once. The result is the same as the one of the mini-pipeline of
+ * SeparableImageFilter, which is used with UseFusedAxesOff().
+ * NumberOfStreamDivisions only applies to that mini-pipeline.
+ *
  * \author Richard Beare
  */
 
@@ -53,15 +165,36 @@ public:
   void SetRank( float );
   itkGetMacro(Rank, float);
 
+  typedef Function::SeparableRankLine< PixelType > LineFunctionType;
+  typedef FusedSeparableImageFilter< TInputImage, TOutputImage, LineFunctionType > FusedFilterType;
+
+  /** Process all the axes at once, without intermediate images.
+   * Defaults to true. */
+  itkSetMacro(UseFusedAxes, bool);
+  itkGetMacro(UseFusedAxes, bool);
+  itkBooleanMacro(UseFusedAxes);
+
+  virtual void Modified() const;
+
+  virtual void SetNumberOfThreads( int nb );
+
 protected:
   FastApproxRankImageFilter();
   ~FastApproxRankImageFilter() {};
 
+  void GenerateData();
+
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  typename FusedFilterType::Pointer m_FusedFilter;
+
 private:
   FastApproxRankImageFilter(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
 
   float m_Rank;
+
+  bool m_UseFusedAxes;
 };
 
 }
@@ -1,12 +1,18 @@
 #ifndef __itkFastApproxRankImageFilter_txx
 #define __itkFastApproxRankImageFilter_txx
 
+#include "itkFastApproxRankImageFilter.h"
+#include "itkProgressAccumulator.h"
+
 namespace itk {
 
 template <class TInputImage, class TOutputImage>
 FastApproxRankImageFilter<TInputImage, TOutputImage>
 ::FastApproxRankImageFilter()
 {
+  m_UseFusedAxes = true;
+  m_FusedFilter = FusedFilterType::New();
+  m_Rank = -1;
   this->SetRank( 0.5 );
 }
 
@@ -19,14 +25,75 @@ FastApproxRankImageFilter<TInputImage, TOutputImage>
   if( m_Rank != rank )
     {
     m_Rank = rank;
-    for (unsigned i = 0; i < TInputImage::ImageDimension - 1; i++)
+    for (unsigned i = 0; i < TInputImage::ImageDimension; i++)
       {
       this->m_Filters[i]->SetRank( m_Rank );
       }
+    LineFunctionType line;
+    line.SetRank( m_Rank );
+    m_FusedFilter->SetLineFunction( line );
     this->Modified();
     }
 }
 
+
+template<class TInputImage, class TOutputImage>
+void
+FastApproxRankImageFilter<TInputImage, TOutputImage>
+::Modified() const
+{
+  Superclass::Modified();
+  m_FusedFilter->Modified();
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+FastApproxRankImageFilter<TInputImage, TOutputImage>
+::SetNumberOfThreads( int nb )
+{
+  Superclass::SetNumberOfThreads( nb );
+  m_FusedFilter->SetNumberOfThreads( nb );
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+FastApproxRankImageFilter<TInputImage, TOutputImage>
+::GenerateData()
+{
+  if( !m_UseFusedAxes )
+    {
+    Superclass::GenerateData();
+    return;
+    }
+
+  this->AllocateOutputs();
+
+  m_FusedFilter->SetInput( this->GetInput() );
+  m_FusedFilter->SetRadius( this->GetRadius() );
+
+  ProgressAccumulator::Pointer progress = ProgressAccumulator::New();
+  progress->SetMiniPipelineFilter(this);
+  progress->RegisterInternalFilter( m_FusedFilter, 1.0 );
+
+  m_FusedFilter->GraftOutput( this->GetOutput() );
+  m_FusedFilter->Update();
+  this->GraftOutput( m_FusedFilter->GetOutput() );
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+FastApproxRankImageFilter<TInputImage, TOutputImage>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Rank: " << m_Rank << std::endl;
+  os << indent << "UseFusedAxes: " << m_UseFusedAxes << std::endl;
+}
+
 }
 
 
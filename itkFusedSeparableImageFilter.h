@@ -0,0 +1,192 @@
+#ifndef __itkFusedSeparableImageFilter_h
+#define __itkFusedSeparableImageFilter_h
+
+#include "itkBoxImageFilter.h"
+#include "itkProgressReporter.h"
+
+
+namespace itk {
+
+/**
+ * \class FusedSeparableImageFilter
+ * \brief Run a separable filter on all the axes without intermediate images
+ *
+ * SeparableImageFilter runs one filter per axis, so each axis reads and
+ * writes a full intermediate image. This filter applies a line function
+ * along each axis in a work area instead. The output region of each
+ * thread is cut in tiles by ComputeRegionTiles(). The input pixels of a
+ * tile, padded by the radius, are copied once in the work area, the
+ * line function is applied along the first axis, then along the second
+ * one and so on, and the result is written once in the output. As in
+ * MovingWindowMeanImageFilter, the tiles are cut along the last axis
+ * first, then along the lower axes when the slices are too large, so
+ * the work area stays small whatever the size of the image.
+ *
+ * The line function is a class providing:
+ * + a ValueType typedef, the type of the values in the work area. The
+ * input pixels are converted to that type with static_cast.
+ * + void Compute( const ValueType * in, long n, long begin, long end,
+ * long radius, ValueType * out ), which stores in out[p-begin] the
+ * value of the window of the given radius centered on the position p of
+ * the n values of in, for all the positions p from begin to end
+ * (excluded). The window is cropped at the ends of the line.
+ * + GetValue( const ValueType & v, unsigned long count ), which returns
+ * a value castable to the output pixel type from the final value v of a
+ * pixel. count is the number of pixels of its box, cropped at the
+ * border.
+ * + void SetAxis( unsigned int axis ), called before the lines along
+ * the given axis are computed.
+ * + a copy constructor and an assignment operator, which copy the
+ * parameters of the line function. Each thread uses its own copy of the
+ * line function given with SetLineFunction().
+ *
+ * The neighborhood is cropped at the border, as in the other filters of
+ * this package.
+ *
+ * The subclasses can change how the input is copied in the work area
+ * and how the output is computed from it, with CopyInputOnTile() and
+ * WriteOutputOnTile(): SeparableMaskedMeanImageFilter reads a mask
+ * with the input.
+ *
+ * \sa SeparableImageFilter, SeparableMeanImageFilter, SeparableMaskedMeanImageFilter, FastApproxRankImageFilter
+ */
+
+template<class TInputImage, class TOutputImage, class TLineFunction>
+class ITK_EXPORT FusedSeparableImageFilter :
+public BoxImageFilter<TInputImage, TOutputImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef FusedSeparableImageFilter Self;
+  typedef BoxImageFilter<TInputImage,TOutputImage>  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(FusedSeparableImageFilter,
+               BoxImageFilter);
+
+  /** Image related typedefs. */
+  typedef TInputImage InputImageType;
+  typedef typename TInputImage::RegionType RegionType ;
+  typedef typename TInputImage::SizeType SizeType ;
+  typedef typename TInputImage::IndexType IndexType ;
+  typedef typename TInputImage::PixelType PixelType ;
+  typedef typename TInputImage::OffsetType OffsetType ;
+
+  typedef TOutputImage OutputImageType;
+  typedef typename TOutputImage::PixelType OutputPixelType ;
+  typedef typename TOutputImage::RegionType OutputImageRegionType ;
+
+  /** Image related typedefs. */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+  /** n-dimensional Kernel radius. */
+  typedef typename TInputImage::SizeType RadiusType ;
+
+  typedef TLineFunction LineFunctionType;
+  typedef typename LineFunctionType::ValueType ValueType;
+
+  /** Set the line function applied along each axis */
+  void SetLineFunction( const LineFunctionType & line )
+    {
+    m_LineFunction = line;
+    this->Modified();
+    }
+  const LineFunctionType & GetLineFunction() const
+    {
+    return m_LineFunction;
+    }
+
+protected:
+  FusedSeparableImageFilter() {};
+  ~FusedSeparableImageFilter() {};
+
+  void ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+                            int threadId);
+
+  typedef typename OffsetType::OffsetValueType OffsetValueType;
+  typedef typename TInputImage::InternalPixelType InputInternalPixelType;
+  typedef typename TInputImage::NeighborhoodAccessorFunctorType InputAccessorType;
+  typedef typename TOutputImage::InternalPixelType OutputInternalPixelType;
+  typedef typename TOutputImage::NeighborhoodAccessorFunctorType OutputAccessorType;
+
+  /** A growable array of values, which never shrinks. std::vector
+   * can't be used: it doesn't give a pointer to its values when
+   * ValueType is bool. */
+  class WorkArray
+  {
+  public:
+    WorkArray()
+      {
+      m_Values = 0;
+      m_Capacity = 0;
+      }
+    ~WorkArray()
+      {
+      delete [] m_Values;
+      }
+    ValueType * Reserve( OffsetValueType size )
+      {
+      if( size > m_Capacity )
+        {
+        delete [] m_Values;
+        m_Values = new ValueType[size];
+        m_Capacity = size;
+        }
+      return m_Values;
+      }
+  private:
+    WorkArray(const WorkArray&); //purposely not implemented
+    void operator=(const WorkArray&); //purposely not implemented
+    ValueType * m_Values;
+    OffsetValueType m_Capacity;
+  };
+
+  /** Copy the input pixels of the tile, padded by the radius, in the
+   * work area, apply the line function along each axis, and write the
+   * output pixels of the tile */
+  void GenerateDataOnTile(const OutputImageRegionType& tile,
+                          LineFunctionType & line,
+                          WorkArray & area,
+                          WorkArray & lineIn,
+                          WorkArray & lineOut,
+                          ProgressReporter & progress);
+
+  /** Copy the input pixels of the padded region of a tile in the work
+   * area, converted to ValueType. strides are the offsets of the next
+   * value along each axis in the work area. */
+  virtual void CopyInputOnTile(const RegionType& padded,
+                               const OffsetValueType * strides,
+                               ValueType * values);
+
+  /** Write the output pixels of the tile, from the final values of the
+   * work area and the number of pixels of their box */
+  virtual void WriteOutputOnTile(const OutputImageRegionType& tile,
+                                 const RegionType& padded,
+                                 const OffsetValueType * strides,
+                                 const ValueType * values,
+                                 LineFunctionType & line,
+                                 ProgressReporter & progress);
+
+private:
+  FusedSeparableImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  // the largest number of values in the work area, unless the kernel
+  // padded by the radius is larger
+  enum { MaximumWorkAreaSize = 1 << 18 };
+
+  LineFunctionType m_LineFunction;
+};
+
+}
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkFusedSeparableImageFilter.txx"
+#endif
+
+#endif
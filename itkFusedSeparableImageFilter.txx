@@ -0,0 +1,252 @@
+#ifndef __itkFusedSeparableImageFilter_txx
+#define __itkFusedSeparableImageFilter_txx
+
+#include "itkFusedSeparableImageFilter.h"
+#include "itkImageLinearConstIteratorWithIndex.h"
+#include "itkProgressReporter.h"
+#include "itkRegionTiles.h"
+#include <algorithm>
+
+namespace itk {
+
+template <class TInputImage, class TOutputImage, class TLineFunction>
+void
+FusedSeparableImageFilter<TInputImage, TOutputImage, TLineFunction>
+::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+                       int threadId)
+{
+  if( outputRegionForThread.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+  // the tiles are cut along all the axes, so their work area stays
+  // below MaximumWorkAreaSize whatever the size of the slices
+  std::vector< OutputImageRegionType > tiles;
+  ComputeRegionTiles( outputRegionForThread, this->GetRadius(),
+                      (unsigned long)MaximumWorkAreaSize, tiles );
+
+  // the output is written line by line along the first axis of each
+  // tile
+  unsigned long nbOfLines = 0;
+  for( typename std::vector< OutputImageRegionType >::const_iterator it=tiles.begin(); it!=tiles.end(); it++ )
+    {
+    nbOfLines += it->GetNumberOfPixels() / it->GetSize()[0];
+    }
+  ProgressReporter progress(this, threadId, nbOfLines);
+
+  LineFunctionType line( m_LineFunction );
+  WorkArray area;
+  WorkArray lineIn;
+  WorkArray lineOut;
+  for( typename std::vector< OutputImageRegionType >::const_iterator it=tiles.begin(); it!=tiles.end(); it++ )
+    {
+    this->GenerateDataOnTile( *it, line, area, lineIn, lineOut, progress );
+    }
+}
+
+
+template <class TInputImage, class TOutputImage, class TLineFunction>
+void
+FusedSeparableImageFilter<TInputImage, TOutputImage, TLineFunction>
+::GenerateDataOnTile(const OutputImageRegionType& tile,
+                     LineFunctionType & line,
+                     WorkArray & area,
+                     WorkArray & lineIn,
+                     WorkArray & lineOut,
+                     ProgressReporter & progress)
+{
+  const InputImageType * inputImage = this->GetInput();
+  const RadiusType radius = this->GetRadius();
+
+  // the pixels which can be in the kernel of a pixel of the tile
+  RegionType padded = tile;
+  padded.PadByRadius( radius );
+  padded.Crop( inputImage->GetRequestedRegion() );
+  const IndexType & areaIndex = padded.GetIndex();
+  const SizeType & areaSize = padded.GetSize();
+
+  OffsetValueType strides[ImageDimension];
+  OffsetValueType areaCount = 1;
+  for( unsigned int a=0; a<ImageDimension; a++ )
+    {
+    strides[a] = areaCount;
+    areaCount *= areaSize[a];
+    }
+  ValueType * values = area.Reserve( areaCount );
+
+  this->CopyInputOnTile( padded, strides, values );
+
+  // the positions, relative to the work area, of the lines of each
+  // pass. The axes already processed are restricted to the tile.
+  long low[ImageDimension];
+  long high[ImageDimension];
+  for( unsigned int a=0; a<ImageDimension; a++ )
+    {
+    low[a] = 0;
+    high[a] = areaSize[a];
+    }
+
+  for( unsigned int a=0; a<ImageDimension; a++ )
+    {
+    const long begin = tile.GetIndex()[a] - areaIndex[a];
+    const long end = begin + tile.GetSize()[a];
+    const long n = areaSize[a];
+    const OffsetValueType stride = strides[a];
+    if( radius[a] > 0 )
+      {
+      ValueType * in = lineIn.Reserve( n );
+      ValueType * out = lineOut.Reserve( end - begin );
+      line.SetAxis( a );
+
+      // visit all the lines along the axis a
+      long pos[ImageDimension];
+      for( unsigned int c=0; c<ImageDimension; c++ )
+        {
+        pos[c] = low[c];
+        }
+      pos[a] = 0;
+      bool done = false;
+      while( !done )
+        {
+        OffsetValueType o = 0;
+        for( unsigned int c=0; c<ImageDimension; c++ )
+          {
+          o += pos[c] * strides[c];
+          }
+        ValueType * v = values + o;
+
+        // the lines along the first axis are already contiguous
+        const ValueType * lineValues = v;
+        if( a > 0 )
+          {
+          for( long k=0; k<n; k++ )
+            {
+            in[k] = v[k * stride];
+            }
+          lineValues = in;
+          }
+        line.Compute( lineValues, n, begin, end, radius[a], out );
+        for( long p=begin; p<end; p++ )
+          {
+          v[p * stride] = out[p - begin];
+          }
+
+        // next line
+        done = true;
+        for( unsigned int c=0; c<ImageDimension; c++ )
+          {
+          if( c == a )
+            {
+            continue;
+            }
+          pos[c]++;
+          if( pos[c] < high[c] )
+            {
+            done = false;
+            break;
+            }
+          pos[c] = low[c];
+          }
+        }
+      }
+    low[a] = begin;
+    high[a] = end;
+    }
+
+  this->WriteOutputOnTile( tile, padded, strides, values, line, progress );
+}
+
+
+template <class TInputImage, class TOutputImage, class TLineFunction>
+void
+FusedSeparableImageFilter<TInputImage, TOutputImage, TLineFunction>
+::CopyInputOnTile(const RegionType& padded,
+                  const OffsetValueType * strides,
+                  ValueType * values)
+{
+  const InputImageType * inputImage = this->GetInput();
+  InputAccessorType inAccessor = inputImage->GetNeighborhoodAccessor();
+  const InputInternalPixelType * inBuffer = inputImage->GetBufferPointer();
+  inAccessor.SetBegin( inBuffer );
+  const IndexType & areaIndex = padded.GetIndex();
+
+  typedef ImageLinearConstIteratorWithIndex< InputImageType > InputLineIteratorType;
+  const long areaLength = padded.GetSize()[0];
+  InputLineIteratorType inLineIt( inputImage, padded );
+  inLineIt.SetDirection( 0 );
+  for( inLineIt.GoToBegin(); !inLineIt.IsAtEnd(); inLineIt.NextLine() )
+    {
+    const IndexType idx = inLineIt.GetIndex();
+    OffsetValueType o = 0;
+    for( unsigned int a=0; a<ImageDimension; a++ )
+      {
+      o += ( idx[a] - areaIndex[a] ) * strides[a];
+      }
+    const InputInternalPixelType * inPtr = inBuffer + inputImage->ComputeOffset( idx );
+    ValueType * v = values + o;
+    for( long k=0; k<areaLength; k++ )
+      {
+      v[k] = static_cast< ValueType >( inAccessor.Get( inPtr + k ) );
+      }
+    }
+}
+
+
+template <class TInputImage, class TOutputImage, class TLineFunction>
+void
+FusedSeparableImageFilter<TInputImage, TOutputImage, TLineFunction>
+::WriteOutputOnTile(const OutputImageRegionType& tile,
+                    const RegionType& padded,
+                    const OffsetValueType * strides,
+                    const ValueType * values,
+                    LineFunctionType & line,
+                    ProgressReporter & progress)
+{
+  const InputImageType * inputImage = this->GetInput();
+  OutputImageType * outputImage = this->GetOutput();
+  const RadiusType radius = this->GetRadius();
+  OutputAccessorType outAccessor = outputImage->GetNeighborhoodAccessor();
+  OutputInternalPixelType * outBuffer = outputImage->GetBufferPointer();
+  outAccessor.SetBegin( outBuffer );
+  const IndexType & areaIndex = padded.GetIndex();
+  const SizeType & areaSize = padded.GetSize();
+
+  // the number of pixels in the cropped box
+  const long r0 = radius[0];
+  const long areaStart0 = areaIndex[0];
+  const long areaEnd0 = areaStart0 + (long)areaSize[0];
+  const long lineLength = tile.GetSize()[0];
+  typedef ImageLinearConstIteratorWithIndex< InputImageType > InputLineIteratorType;
+  InputLineIteratorType lineIt( inputImage, tile );
+  lineIt.SetDirection( 0 );
+  for( lineIt.GoToBegin(); !lineIt.IsAtEnd(); lineIt.NextLine() )
+    {
+    const IndexType idx = lineIt.GetIndex();
+    unsigned long lineCount = 1;
+    OffsetValueType o = 0;
+    for( unsigned int a=0; a<ImageDimension; a++ )
+      {
+      o += ( idx[a] - areaIndex[a] ) * strides[a];
+      if( a > 0 )
+        {
+        const long first = std::max( idx[a] - (long)radius[a], areaIndex[a] );
+        const long lastPos = std::min( idx[a] + (long)radius[a], areaIndex[a] + (long)areaSize[a] - 1 );
+        lineCount *= lastPos - first + 1;
+        }
+      }
+    const ValueType * v = values + o;
+    OutputInternalPixelType * outPtr = outBuffer + outputImage->ComputeOffset( idx );
+    for( long k=0; k<lineLength; k++ )
+      {
+      const long p = idx[0] + k;
+      const long count = std::min( p + r0, areaEnd0 - 1 ) - std::max( p - r0, areaStart0 ) + 1;
+      outAccessor.Set( outPtr + k, static_cast< OutputPixelType >( line.GetValue( v[k], lineCount * count ) ) );
+      }
+    progress.CompletedPixel();
+    }
+}
+
+}
+
+
+#endif
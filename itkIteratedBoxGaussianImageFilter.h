@@ -0,0 +1,268 @@
+#ifndef __itkIteratedBoxGaussianImageFilter_h
+#define __itkIteratedBoxGaussianImageFilter_h
+
+#include "itkBoxImageFilter.h"
+#include "itkFusedSeparableImageFilter.h"
+#include "itkMovingWindowMeanImageFilter.h"
+#include "itkFixedArray.h"
+#include <vector>
+
+namespace itk {
+
+namespace Function {
+
+/** The line function of FusedSeparableImageFilter for the iterated box
+ * means. Along each axis, the box means of the passes are computed one
+ * after the other with a moving window, alternately in two line
+ * buffers. The values stay real numbers between the passes, and are
+ * only converted to the output type, with MeanRounding, at the end.
+ *
+ * The passes are computed on the whole line, which is padded by the sum
+ * of their radii: the errors at the ends of the padded line move inward
+ * by the radius of each pass, so they never reach the positions of the
+ * tile. */
+template <class TOutputPixel, unsigned int VDimension>
+class IteratedBoxLine
+{
+public:
+  typedef double ValueType;
+
+  enum { MaximumNumberOfPasses = 5 };
+
+  IteratedBoxLine()
+    {
+    m_Axis = 0;
+    m_NumberOfPasses = 0;
+    m_Round = true;
+    for( unsigned int a=0; a<VDimension; a++ )
+      {
+      for( unsigned int k=0; k<MaximumNumberOfPasses; k++ )
+        {
+        m_Radii[a][k] = 0;
+        }
+      }
+    }
+
+  void SetNumberOfPasses( unsigned int nb )
+    {
+    m_NumberOfPasses = nb;
+    }
+
+  void SetPassRadius( unsigned int axis, unsigned int pass, long radius )
+    {
+    m_Radii[axis][pass] = radius;
+    }
+
+  void SetRound( bool round )
+    {
+    m_Round = round;
+    }
+
+  inline void SetAxis( unsigned int axis )
+    {
+    m_Axis = axis;
+    }
+
+  inline void Compute( const ValueType * in, long n, long begin, long end, long, ValueType * out )
+    {
+    const long * radii = m_Radii[m_Axis];
+    unsigned int last = 0;
+    for( unsigned int k=0; k<m_NumberOfPasses; k++ )
+      {
+      if( radii[k] > 0 )
+        {
+        last = k;
+        }
+      }
+
+    if( (long)m_Ping.size() < n )
+      {
+      m_Ping.resize( n );
+      m_Pong.resize( n );
+      }
+    const ValueType * src = in;
+    ValueType * dst = &m_Ping[0];
+    for( unsigned int k=0; k<last; k++ )
+      {
+      if( radii[k] > 0 )
+        {
+        BoxPass( src, n, radii[k], 0, n, dst );
+        src = dst;
+        dst = ( dst == &m_Ping[0] ) ? &m_Pong[0] : &m_Ping[0];
+        }
+      }
+    // only the positions of the tile are needed after the last pass
+    BoxPass( src, n, radii[last], begin, end, out );
+    }
+
+  inline TOutputPixel GetValue( const ValueType & v, unsigned long ) const
+    {
+    return MeanRounding< ValueType, TOutputPixel >::Divide( v, 1, 1.0, m_Round );
+    }
+
+private:
+  /** The means in the windows of the given radius, cropped at the ends
+   * of the n values of src, for the positions first to last (excluded) */
+  static inline void BoxPass( const ValueType * src, long n, long radius, long first, long last, ValueType * dst )
+    {
+    const ValueType full = 1.0 / static_cast< ValueType >( 2 * radius + 1 );
+    ValueType sum = 0;
+    for( long k=std::max( first - radius, 0L ); k<=std::min( first + radius, n - 1 ); k++ )
+      {
+      sum += src[k];
+      }
+    for( long p=first; p<last; p++ )
+      {
+      if( p > first )
+        {
+        if( p + radius < n )
+          {
+          sum += src[p + radius];
+          }
+        if( p - radius - 1 >= 0 )
+          {
+          sum -= src[p - radius - 1];
+          }
+        }
+      const long count = std::min( p + radius, n - 1 ) - std::max( p - radius, 0L ) + 1;
+      dst[p - first] = sum * ( count == 2 * radius + 1 ? full : 1.0 / static_cast< ValueType >( count ) );
+      }
+    }
+
+  unsigned int m_Axis;
+  unsigned int m_NumberOfPasses;
+  bool m_Round;
+  long m_Radii[VDimension][MaximumNumberOfPasses];
+
+  // the work areas of the passes
+  std::vector< ValueType > m_Ping;
+  std::vector< ValueType > m_Pong;
+};
+
+} // end namespace Function
+
+/**
+ * \class IteratedBoxGaussianImageFilter
+ * \brief Approximate a gaussian blur with several box means
+ *
+ * The box mean applied several times converges quickly to a gaussian
+ * blur. This filter computes the width of the boxes which give the
+ * requested variance along each axis, for a number of passes between 3
+ * and 5: the boxes have one of two consecutive odd widths, chosen so the
+ * sum of the variances of the passes is the closest to sigma^2.
+ *
+ * All the passes along all the axes are run in a single execution of
+ * FusedSeparableImageFilter, with no intermediate image. The means of
+ * the passes are kept in double precision, and are rounded to the
+ * output type only once, at the end: the integer outputs are rounded to
+ * the nearest value, unless RoundOutput is off. The cost per pixel
+ * depends on the number of passes, but not on sigma.
+ *
+ * Sigma is given in pixels. The radius of the filter is the sum of the
+ * radii of the passes: it is set by SetSigma() and SetNumberOfPasses().
+ * As in the other filters of this package, the boxes are cropped at the
+ * border of the image.
+ *
+ * \sa SeparableMeanImageFilter, FusedSeparableImageFilter
+ */
+
+template<class TInputImage, class TOutputImage>
+class ITK_EXPORT IteratedBoxGaussianImageFilter :
+public BoxImageFilter<TInputImage, TOutputImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef IteratedBoxGaussianImageFilter Self;
+  typedef BoxImageFilter<TInputImage,TOutputImage>  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(IteratedBoxGaussianImageFilter,
+               BoxImageFilter);
+
+  /** Image related typedefs. */
+  typedef TInputImage InputImageType;
+  typedef typename TInputImage::RegionType RegionType ;
+  typedef typename TInputImage::SizeType SizeType ;
+  typedef typename TInputImage::IndexType IndexType ;
+  typedef typename TInputImage::PixelType PixelType ;
+  typedef typename TInputImage::OffsetType OffsetType ;
+
+  typedef TOutputImage OutputImageType;
+  typedef typename TOutputImage::PixelType OutputPixelType ;
+
+  /** Image related typedefs. */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+  /** n-dimensional Kernel radius. */
+  typedef typename TInputImage::SizeType RadiusType ;
+
+  typedef FixedArray< double, itkGetStaticConstMacro(ImageDimension) > SigmaArrayType;
+
+  typedef Function::IteratedBoxLine< OutputPixelType, itkGetStaticConstMacro(ImageDimension) > LineFunctionType;
+  typedef FusedSeparableImageFilter< TInputImage, TOutputImage, LineFunctionType > FusedFilterType;
+
+  /** The standard deviation of the gaussian along each axis, in
+   * pixels. Defaults to 1. */
+  void SetSigma( const SigmaArrayType & sigma );
+  void SetSigma( const double & sigma );
+  itkGetConstReferenceMacro(Sigma, SigmaArrayType);
+
+  /** The number of box means along each axis, from 3 to 5. Defaults to
+   * 3. */
+  void SetNumberOfPasses( unsigned int nb );
+  itkGetConstMacro(NumberOfPasses, unsigned int);
+
+  /** The radius of the boxes of a pass */
+  RadiusType GetPassRadius( unsigned int pass ) const
+    {
+    return m_PassRadii[pass];
+    }
+
+  /** Round the integer output pixels to the nearest value instead of
+   * truncating them. Defaults to true. */
+  itkSetMacro(RoundOutput, bool);
+  itkGetMacro(RoundOutput, bool);
+  itkBooleanMacro(RoundOutput);
+
+  virtual void Modified() const;
+
+  virtual void SetNumberOfThreads( int nb );
+
+protected:
+  IteratedBoxGaussianImageFilter();
+  ~IteratedBoxGaussianImageFilter() {};
+
+  void GenerateData();
+
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  /** Compute the radii of the passes, and the radius of the filter */
+  void ComputePassRadii();
+
+  typename FusedFilterType::Pointer m_FusedFilter;
+
+private:
+  IteratedBoxGaussianImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  SigmaArrayType m_Sigma;
+
+  unsigned int m_NumberOfPasses;
+
+  bool m_RoundOutput;
+
+  RadiusType m_PassRadii[LineFunctionType::MaximumNumberOfPasses];
+};
+
+}
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkIteratedBoxGaussianImageFilter.txx"
+#endif
+
+#endif
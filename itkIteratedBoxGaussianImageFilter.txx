@@ -0,0 +1,166 @@
+#ifndef __itkIteratedBoxGaussianImageFilter_txx
+#define __itkIteratedBoxGaussianImageFilter_txx
+
+#include "itkIteratedBoxGaussianImageFilter.h"
+#include "itkProgressAccumulator.h"
+#include <cmath>
+#include <algorithm>
+
+namespace itk {
+
+template <class TInputImage, class TOutputImage>
+IteratedBoxGaussianImageFilter<TInputImage, TOutputImage>
+::IteratedBoxGaussianImageFilter()
+{
+  m_Sigma.Fill( 1.0 );
+  m_NumberOfPasses = 3;
+  m_RoundOutput = true;
+  m_FusedFilter = FusedFilterType::New();
+  this->ComputePassRadii();
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+IteratedBoxGaussianImageFilter<TInputImage, TOutputImage>
+::Modified() const
+{
+  Superclass::Modified();
+  m_FusedFilter->Modified();
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+IteratedBoxGaussianImageFilter<TInputImage, TOutputImage>
+::SetNumberOfThreads( int nb )
+{
+  Superclass::SetNumberOfThreads( nb );
+  m_FusedFilter->SetNumberOfThreads( nb );
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+IteratedBoxGaussianImageFilter<TInputImage, TOutputImage>
+::SetSigma( const SigmaArrayType & sigma )
+{
+  if( m_Sigma != sigma )
+    {
+    m_Sigma = sigma;
+    this->ComputePassRadii();
+    this->Modified();
+    }
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+IteratedBoxGaussianImageFilter<TInputImage, TOutputImage>
+::SetSigma( const double & sigma )
+{
+  SigmaArrayType s;
+  s.Fill( sigma );
+  this->SetSigma( s );
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+IteratedBoxGaussianImageFilter<TInputImage, TOutputImage>
+::SetNumberOfPasses( unsigned int nb )
+{
+  nb = std::max( 3U, std::min( nb, (unsigned int)LineFunctionType::MaximumNumberOfPasses ) );
+  if( m_NumberOfPasses != nb )
+    {
+    m_NumberOfPasses = nb;
+    this->ComputePassRadii();
+    this->Modified();
+    }
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+IteratedBoxGaussianImageFilter<TInputImage, TOutputImage>
+::ComputePassRadii()
+{
+  // a box of width w has a variance of (w^2 - 1) / 12. The passes use
+  // the odd widths wl and wl + 2 around the ideal width, with the number
+  // of passes of width wl which gives the closest total variance.
+  const double n = m_NumberOfPasses;
+  RadiusType radius;
+  radius.Fill( 0 );
+  for( unsigned int a=0; a<ImageDimension; a++ )
+    {
+    const double variance = m_Sigma[a] * m_Sigma[a];
+    long wl = (long)std::floor( std::sqrt( 12.0 * variance / n + 1.0 ) );
+    if( wl % 2 == 0 )
+      {
+      wl--;
+      }
+    const double nbOfLow = ( 12.0 * variance - n * wl * wl - 4.0 * n * wl - 3.0 * n ) / ( -4.0 * wl - 4.0 );
+    const long m = (long)std::floor( nbOfLow + 0.5 );
+    for( unsigned int k=0; k<LineFunctionType::MaximumNumberOfPasses; k++ )
+      {
+      const long w = (long)k < m ? wl : wl + 2;
+      m_PassRadii[k][a] = k < m_NumberOfPasses ? ( w - 1 ) / 2 : 0;
+      radius[a] += m_PassRadii[k][a];
+      }
+    }
+  Superclass::SetRadius( radius );
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+IteratedBoxGaussianImageFilter<TInputImage, TOutputImage>
+::GenerateData()
+{
+  this->AllocateOutputs();
+
+  m_FusedFilter->SetInput( this->GetInput() );
+  m_FusedFilter->SetRadius( this->GetRadius() );
+
+  LineFunctionType line;
+  line.SetNumberOfPasses( m_NumberOfPasses );
+  line.SetRound( m_RoundOutput );
+  for( unsigned int k=0; k<m_NumberOfPasses; k++ )
+    {
+    for( unsigned int a=0; a<ImageDimension; a++ )
+      {
+      line.SetPassRadius( a, k, m_PassRadii[k][a] );
+      }
+    }
+  m_FusedFilter->SetLineFunction( line );
+
+  ProgressAccumulator::Pointer progress = ProgressAccumulator::New();
+  progress->SetMiniPipelineFilter(this);
+  progress->RegisterInternalFilter( m_FusedFilter, 1.0 );
+
+  m_FusedFilter->GraftOutput( this->GetOutput() );
+  m_FusedFilter->Update();
+  this->GraftOutput( m_FusedFilter->GetOutput() );
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+IteratedBoxGaussianImageFilter<TInputImage, TOutputImage>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Sigma: " << m_Sigma << std::endl;
+  os << indent << "NumberOfPasses: " << m_NumberOfPasses << std::endl;
+  os << indent << "RoundOutput: " << m_RoundOutput << std::endl;
+  for( unsigned int k=0; k<m_NumberOfPasses; k++ )
+    {
+    os << indent << "PassRadius " << k << ": " << m_PassRadii[k] << std::endl;
+    }
+}
+
+}
+
+
+#endif
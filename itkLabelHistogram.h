@@ -0,0 +1,245 @@
+#ifndef __itkLabelHistogram_h
+#define __itkLabelHistogram_h
+
+#include "itkRebindHistogramCount.h"
+#include <vector>
+#include <algorithm>
+#include <cassert>
+
+namespace itk {
+
+/**
+ * \class LabelHistogram
+ * \brief One moving histogram per label, for the labels in the kernel
+ *
+ * This is the histogram of LabelMovingHistogramImageFilter. It keeps a
+ * histogram of type THistogram for each label of the pixels currently
+ * in the kernel: the histogram of a label is taken when the first pixel
+ * of that label enters the kernel, and is given back when its last pixel
+ * leaves it. The memory used depends on the number of labels in the
+ * kernel, not on the number of labels in the image.
+ *
+ * The histograms are stored in a pool, and the labels in a vector sorted
+ * by label, with the position of their histogram in the pool. The
+ * histograms given back are kept in a free list, and reset when they are
+ * taken again, so once the pool is large enough, the moving histogram
+ * doesn't allocate anything. A copy keeps the histograms at the same
+ * positions in the pool: the copy of the histogram of a line to the
+ * other directions only copies the histograms of the labels in the
+ * kernel, in the storage already allocated by the destination.
+ *
+ * THistogram must provide the methods of the masked histograms:
+ * AddPixel(), RemovePixel(), IsValid(), Reset() and GetValue(), which
+ * must return a TInputPixel. Its IsValid() method must be false when it
+ * doesn't contain any pixel.
+ *
+ * The neighbor pixels often have the same label: the histogram of the
+ * last label used is kept at hand, so most of the updates don't search
+ * the label.
+ */
+template <class TInputPixel, class TLabel, class THistogram>
+class LabelHistogram
+{
+public:
+  typedef THistogram HistogramType;
+
+  LabelHistogram()
+    {
+    m_NumberOfHistograms = 0;
+    m_Last = NoHistogram;
+    }
+
+  explicit LabelHistogram( const HistogramType & empty ) : m_Empty( empty )
+    {
+    m_NumberOfHistograms = 0;
+    m_Last = NoHistogram;
+    }
+
+  LabelHistogram( const LabelHistogram & h ) :
+    m_Empty( h.m_Empty ), m_Labels( h.m_Labels ), m_Histograms( h.m_Histograms ),
+    m_FreeHistograms( h.m_FreeHistograms ), m_NumberOfHistograms( h.m_NumberOfHistograms ),
+    m_LastLabel( h.m_LastLabel ), m_Last( h.m_Last )
+    {
+    }
+
+  LabelHistogram & operator=( const LabelHistogram & h )
+    {
+    if( this != &h )
+      {
+      m_Empty = h.m_Empty;
+      m_Labels = h.m_Labels;
+      m_FreeHistograms = h.m_FreeHistograms;
+      m_NumberOfHistograms = h.m_NumberOfHistograms;
+      if( m_Histograms.size() < m_NumberOfHistograms )
+        {
+        m_Histograms.resize( m_NumberOfHistograms, m_Empty );
+        }
+      // the other histograms of the pool are reset before being used
+      for( typename LabelVectorType::const_iterator it = m_Labels.begin(); it != m_Labels.end(); it++ )
+        {
+        m_Histograms[ it->second ] = h.m_Histograms[ it->second ];
+        }
+      m_LastLabel = h.m_LastLabel;
+      m_Last = h.m_Last;
+      }
+    return *this;
+    }
+
+  // the same histogram, with the version of THistogram counting the
+  // pixels with another type - see RebindHistogramCount
+  template <class TOtherHistogram>
+  explicit LabelHistogram( const LabelHistogram<TInputPixel, TLabel, TOtherHistogram> & h ) : m_Empty( h.m_Empty )
+    {
+    m_Labels = h.m_Labels;
+    m_FreeHistograms = h.m_FreeHistograms;
+    m_NumberOfHistograms = h.m_NumberOfHistograms;
+    m_Histograms.reserve( h.m_Histograms.size() );
+    for( unsigned int i=0; i<h.m_Histograms.size(); i++ )
+      {
+      m_Histograms.push_back( HistogramType( h.m_Histograms[i] ) );
+      }
+    m_LastLabel = h.m_LastLabel;
+    m_Last = h.m_Last;
+    }
+
+  template <class, class, class> friend class LabelHistogram;
+
+  void AddPixel( const TInputPixel & p, const TLabel & label )
+    {
+    if( m_Last == NoHistogram || m_LastLabel != label )
+      {
+      typename LabelVectorType::iterator it = this->FindLabel( label );
+      if( it == m_Labels.end() || it->first != label )
+        {
+        it = m_Labels.insert( it, LabelEntryType( label, this->NewHistogram() ) );
+        }
+      m_LastLabel = label;
+      m_Last = it->second;
+      }
+    m_Histograms[ m_Last ].AddPixel( p );
+    }
+
+  void RemovePixel( const TInputPixel & p, const TLabel & label )
+    {
+    typename LabelVectorType::iterator it = m_Labels.end();
+    if( m_Last == NoHistogram || m_LastLabel != label )
+      {
+      it = this->FindLabel( label );
+      // the pixel must have been added with the same label
+      assert( it != m_Labels.end() && it->first == label );
+      m_LastLabel = label;
+      m_Last = it->second;
+      }
+    HistogramType & histogram = m_Histograms[ m_Last ];
+    histogram.RemovePixel( p );
+    if( !histogram.IsValid() )
+      {
+      // the label is not in the kernel anymore
+      if( it == m_Labels.end() )
+        {
+        it = this->FindLabel( label );
+        }
+      m_FreeHistograms.push_back( m_Last );
+      m_Labels.erase( it );
+      m_Last = NoHistogram;
+      }
+    }
+
+  void AddBoundary() {}
+
+  void RemoveBoundary() {}
+
+  /** Is there a pixel of that label in the kernel? */
+  bool IsValid( const TLabel & label )
+    {
+    if( m_Last == NoHistogram || m_LastLabel != label )
+      {
+      typename LabelVectorType::iterator it = this->FindLabel( label );
+      if( it == m_Labels.end() || it->first != label )
+        {
+        m_Last = NoHistogram;
+        return false;
+        }
+      m_LastLabel = label;
+      m_Last = it->second;
+      }
+    return true;
+    }
+
+  /** The value of the histogram of that label. IsValid() must have been
+   * called with the same label just before. */
+  TInputPixel GetValue( const TInputPixel & p, const TLabel & )
+    {
+    assert( m_Last != NoHistogram );
+    return m_Histograms[ m_Last ].GetValue( p );
+    }
+
+  /** The number of labels in the kernel */
+  unsigned long GetNumberOfLabels() const
+    {
+    return m_Labels.size();
+    }
+
+private:
+  // a label, and the position of its histogram in the pool
+  typedef std::pair< TLabel, unsigned int > LabelEntryType;
+  typedef std::vector< LabelEntryType > LabelVectorType;
+
+  // m_Last when the histogram of m_LastLabel is not known
+  enum { NoHistogram = ~0U };
+
+  static bool LabelLess( const LabelEntryType & e, const TLabel & label )
+    {
+    return e.first < label;
+    }
+
+  // the entry of the label, or the position where it must be inserted
+  typename LabelVectorType::iterator FindLabel( const TLabel & label )
+    {
+    return std::lower_bound( m_Labels.begin(), m_Labels.end(), label, LabelLess );
+    }
+
+  // take an unused histogram of the pool, or add one
+  unsigned int NewHistogram()
+    {
+    unsigned int i;
+    if( !m_FreeHistograms.empty() )
+      {
+      i = m_FreeHistograms.back();
+      m_FreeHistograms.pop_back();
+      }
+    else
+      {
+      i = m_NumberOfHistograms++;
+      if( i == m_Histograms.size() )
+        {
+        m_Histograms.push_back( m_Empty );
+        return i;
+        }
+      }
+    // it may have been copied from another histogram
+    m_Histograms[i].Reset();
+    return i;
+    }
+
+  HistogramType m_Empty;
+  LabelVectorType m_Labels;
+  std::vector< HistogramType > m_Histograms;
+  // the histograms of the pool, from 0 to m_NumberOfHistograms, not used
+  // by a label
+  std::vector< unsigned int > m_FreeHistograms;
+  unsigned int m_NumberOfHistograms;
+  TLabel m_LastLabel;
+  unsigned int m_Last;
+};
+
+template <class TInputPixel, class TLabel, class THistogram, class TCount>
+class RebindHistogramCount< LabelHistogram< TInputPixel, TLabel, THistogram >, TCount >
+{
+public:
+  typedef LabelHistogram< TInputPixel, TLabel, typename RebindHistogramCount< THistogram, TCount >::Type > Type;
+};
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,214 @@
+#ifndef __itkLabelMovingHistogramImageFilter_h
+#define __itkLabelMovingHistogramImageFilter_h
+
+#include "itkMovingHistogramImageFilterBase.h"
+#include "itkRebindHistogramCount.h"
+#include <list>
+#include <map>
+#include "itkOffsetLexicographicCompare.h"
+
+namespace itk {
+
+/**
+ * \class LabelMovingHistogramImageFilter
+ * \brief A moving histogram restricted to the label of each pixel
+ *
+ * The value of an output pixel is computed from the pixels of the
+ * kernel which have the same label as the center pixel in the label
+ * image. This is the same as running a MaskedMovingHistogramImageFilter
+ * for each label, with that label as MaskValue, and keeping the output
+ * of each run on the pixels of its label, but the image is traversed
+ * only once: the histogram moved over the image, a LabelHistogram,
+ * keeps one histogram for each label present in the kernel.
+ *
+ * The histogram type must provide the methods of LabelHistogram:
+ * AddPixel( p, label ), RemovePixel( p, label ), IsValid( label ) and
+ * GetValue( p, label ), plus AddBoundary() and RemoveBoundary() for the
+ * pixels outside the image, which are ignored.
+ *
+ * The pixels whose label isn't in their kernel, which can only happen
+ * when the kernel doesn't contain its center, are set to FillValue.
+ *
+ * The label image is read on the same region as the input. The kernel
+ * is moved without bounds check where it stays inside the image when
+ * the label image and the input have the same buffered region.
+ *
+ * \sa LabelRankImageFilter, MaskedMovingHistogramImageFilter, LabelHistogram
+ */
+
+template<class TInputImage, class TLabelImage, class TOutputImage, class TKernel, class THistogram >
+class ITK_EXPORT LabelMovingHistogramImageFilter :
+    public MovingHistogramImageFilterBase<TInputImage, TOutputImage, TKernel>
+{
+public:
+  /** Standard class typedefs. */
+  typedef LabelMovingHistogramImageFilter Self;
+  typedef MovingHistogramImageFilterBase<TInputImage, TOutputImage, TKernel>  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(LabelMovingHistogramImageFilter,
+               MovingHistogramImageFilterBase);
+
+  /** Image related typedefs. */
+  typedef TInputImage InputImageType;
+  typedef TOutputImage OutputImageType;
+  typedef TLabelImage LabelImageType;
+  typedef typename TInputImage::RegionType RegionType ;
+  typedef typename TInputImage::SizeType SizeType ;
+  typedef typename TInputImage::IndexType IndexType ;
+  typedef typename TInputImage::PixelType PixelType ;
+  typedef typename TInputImage::OffsetType OffsetType ;
+  typedef typename Superclass::OutputImageRegionType OutputImageRegionType;
+  typedef typename TOutputImage::PixelType OutputPixelType ;
+  typedef typename TInputImage::PixelType InputPixelType ;
+  typedef typename LabelImageType::PixelType LabelPixelType;
+  typedef THistogram HistogramType;
+
+  /** Set the label image */
+  void SetLabelImage(LabelImageType *input)
+     {
+     // Process object is not const-correct so the const casting is required.
+     this->SetNthInput( 1, const_cast<TLabelImage *>(input) );
+     }
+
+  /** Get the label image */
+  LabelImageType * GetLabelImage()
+    {
+    return static_cast<LabelImageType*>(const_cast<DataObject *>(this->ProcessObject::GetInput(1)));
+    }
+
+   /** Set the input image */
+  void SetInput1(InputImageType *input)
+     {
+     this->SetInput( input );
+     }
+
+   /** Set the label image */
+  void SetInput2(LabelImageType *input)
+     {
+     this->SetLabelImage( input );
+     }
+
+  /** Image related typedefs. */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+
+  /** Kernel typedef. */
+  typedef TKernel KernelType;
+
+  /** Kernel (structuring element) iterator. */
+  typedef typename KernelType::ConstIterator KernelIteratorType ;
+
+  /** n-dimensional Kernel radius. */
+  typedef typename KernelType::SizeType RadiusType ;
+
+  typedef typename std::list< OffsetType > OffsetListType;
+
+  typedef typename std::map< OffsetType, OffsetListType, typename Functor::OffsetLexicographicCompare<ImageDimension> > OffsetMapType;
+
+  typedef typename Superclass::OffsetValueType OffsetValueType;
+  typedef typename Superclass::LinearOffsetListType LinearOffsetListType;
+  typedef typename Superclass::InputInternalPixelType InputInternalPixelType;
+  typedef typename Superclass::InputAccessorType InputAccessorType;
+  typedef typename Superclass::OutputInternalPixelType OutputInternalPixelType;
+  typedef typename Superclass::OutputAccessorType OutputAccessorType;
+  typedef typename LabelImageType::InternalPixelType LabelInternalPixelType;
+  typedef typename Superclass::FaceListType FaceListType;
+
+  itkSetMacro(FillValue, OutputPixelType);
+  itkGetMacro(FillValue, OutputPixelType);
+
+protected:
+  LabelMovingHistogramImageFilter();
+  ~LabelMovingHistogramImageFilter() {};
+
+  /** The label image is read on the same region as the input */
+  void GenerateInputRequestedRegion();
+
+  /** Multi-thread version GenerateData. */
+  void  ThreadedGenerateData (const OutputImageRegionType&
+                              outputRegionForThread,
+                              int threadId) ;
+
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  /** NewHistogram must return an histogram object. It's also the good place to
+   * pass parameters to the histogram. */
+  virtual THistogram * NewHistogram();
+
+  /** Run the filter on the region of the thread with a copy of
+   * emptyHistogram. THist is the histogram type given by
+   * RebindHistogramCount for the number of pixels in the kernel. */
+  template <class THist>
+  void ThreadedGenerateDataWithHistogram(const OutputImageRegionType& outputRegionForThread,
+                                         int threadId,
+                                         const THist & emptyHistogram);
+
+  /** Run the moving histogram on the faces computed by ComputeFaces().
+   * The first face is processed without bounds check when the label
+   * image and the input have the same buffered region. HistVec stores
+   * the histograms of each direction, by value. */
+  template <class THist>
+  void ThreadedGenerateDataOnFaces(const FaceListType& faces,
+                                   const THist & emptyHistogram,
+                                   std::vector<THist> & HistVec,
+                                   ProgressReporter & progress);
+
+  /** Run the moving histogram on a region. When interior is true, the
+   * kernel must stay inside the input requested region on the whole
+   * region, and the label image must have the same buffered region as
+   * the input. The histograms of HistVec are restarted from
+   * emptyHistogram. */
+  template <class THist>
+  void ThreadedGenerateDataOnRegion(const OutputImageRegionType& region,
+                                    bool interior,
+                                    const THist & emptyHistogram,
+                                    std::vector<THist> & HistVec,
+                                    ProgressReporter & progress);
+
+  template <class THist>
+  void pushHistogram(THist * histogram,
+		     const OffsetListType* addedList,
+		     const OffsetListType* removedList,
+		     const RegionType &inputRegion,
+		     const RegionType &kernRegion,
+		     const InputImageType* inputImage,
+		     const LabelImageType *labelImage,
+		     const IndexType currentIdx);
+
+  /** Update the histogram when the kernel is known to be inside the
+   * image. The labels are read at the same offsets as the input. */
+  template <class THist>
+  inline void pushHistogramLinear(THist * histogram,
+                                  const LinearOffsetListType* addedList,
+                                  const LinearOffsetListType* removedList,
+                                  const InputAccessorType &accessor,
+                                  const InputInternalPixelType * currentPtr,
+                                  const LabelInternalPixelType * currentLabelPtr)
+    {
+    for( typename LinearOffsetListType::const_iterator addedIt = addedList->begin(); addedIt != addedList->end(); addedIt++ )
+      { histogram->AddPixel( accessor.Get( currentPtr + (*addedIt) ), currentLabelPtr[*addedIt] ); }
+    for( typename LinearOffsetListType::const_iterator removedIt = removedList->begin(); removedIt != removedList->end(); removedIt++ )
+      { histogram->RemovePixel( accessor.Get( currentPtr + (*removedIt) ), currentLabelPtr[*removedIt] ); }
+    }
+
+private:
+  LabelMovingHistogramImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  OutputPixelType m_FillValue;
+
+} ; // end of class
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkLabelMovingHistogramImageFilter.txx"
+#endif
+
+#endif
@@ -0,0 +1,377 @@
+#ifndef __itkLabelMovingHistogramImageFilter_txx
+#define __itkLabelMovingHistogramImageFilter_txx
+
+#include "itkLabelMovingHistogramImageFilter.h"
+#include "itkOffset.h"
+#include "itkProgressReporter.h"
+#include "itkNumericTraits.h"
+#include "itkImageLinearConstIteratorWithIndex.h"
+#include <vector>
+
+namespace itk {
+
+
+template<class TInputImage, class TLabelImage, class TOutputImage, class TKernel, class THistogram>
+LabelMovingHistogramImageFilter<TInputImage, TLabelImage, TOutputImage, TKernel, THistogram>
+::LabelMovingHistogramImageFilter()
+{
+  this->SetNumberOfRequiredInputs( 2 );
+  m_FillValue = NumericTraits< OutputPixelType >::Zero;
+}
+
+
+template<class TInputImage, class TLabelImage, class TOutputImage, class TKernel, class THistogram>
+THistogram *
+LabelMovingHistogramImageFilter<TInputImage, TLabelImage, TOutputImage, TKernel, THistogram>
+::NewHistogram()
+{
+  return new THistogram();
+}
+
+
+template<class TInputImage, class TLabelImage, class TOutputImage, class TKernel, class THistogram>
+void
+LabelMovingHistogramImageFilter<TInputImage, TLabelImage, TOutputImage, TKernel, THistogram>
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  LabelImageType * labelImage = this->GetLabelImage();
+  if( labelImage && this->GetInput() )
+    {
+    labelImage->SetRequestedRegion( this->GetInput()->GetRequestedRegion() );
+    }
+}
+
+
+template<class TInputImage, class TLabelImage, class TOutputImage, class TKernel, class THistogram>
+void
+LabelMovingHistogramImageFilter<TInputImage, TLabelImage, TOutputImage, TKernel, THistogram>
+::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+                       int threadId)
+{
+  HistogramType * histogram = this->NewHistogram();
+
+  // a bin can't count more pixels than there are in the kernel: use the
+  // narrowest count type able to store that number in the histograms of
+  // the labels
+  const unsigned long kernelCount = this->m_KernelPixelCount;
+  if( kernelCount <= NumericTraits< unsigned short >::max() )
+    {
+    typedef typename RebindHistogramCount< HistogramType, unsigned short >::Type NarrowHistogramType;
+    this->ThreadedGenerateDataWithHistogram( outputRegionForThread, threadId, NarrowHistogramType( *histogram ) );
+    }
+  else if( kernelCount <= NumericTraits< unsigned int >::max() )
+    {
+    typedef typename RebindHistogramCount< HistogramType, unsigned int >::Type NarrowHistogramType;
+    this->ThreadedGenerateDataWithHistogram( outputRegionForThread, threadId, NarrowHistogramType( *histogram ) );
+    }
+  else
+    {
+    this->ThreadedGenerateDataWithHistogram( outputRegionForThread, threadId, *histogram );
+    }
+  delete histogram;
+}
+
+
+template<class TInputImage, class TLabelImage, class TOutputImage, class TKernel, class THistogram>
+template<class THist>
+void
+LabelMovingHistogramImageFilter<TInputImage, TLabelImage, TOutputImage, TKernel, THistogram>
+::ThreadedGenerateDataWithHistogram(const OutputImageRegionType& outputRegionForThread,
+                                    int threadId,
+                                    const THist & emptyHistogram)
+{
+  // the histograms stored for each direction, allocated once per thread
+  std::vector<THist> HistVec( ImageDimension, emptyHistogram );
+
+  // split the region in the interior block, where the histogram is
+  // updated without any bounds check, and the boundary faces
+  FaceListType faces;
+
+  if( this->m_UseDynamicScheduling )
+    {
+    // the region of the thread is ignored: take the chunks until there
+    // is no more work
+    ProgressReporter progress(this, threadId, this->m_NumberOfLinesPerThread);
+    OutputImageRegionType chunk;
+    while( this->GetNextChunk( chunk ) )
+      {
+      this->ComputeFaces( chunk, faces );
+      this->ThreadedGenerateDataOnFaces( faces, emptyHistogram, HistVec, progress );
+      }
+    }
+  else
+    {
+    this->ComputeFaces( outputRegionForThread, faces );
+    // Report progress every line instead of every pixel
+    ProgressReporter progress(this, threadId, this->GetNumberOfLines( faces ));
+    this->ThreadedGenerateDataOnFaces( faces, emptyHistogram, HistVec, progress );
+    }
+}
+
+
+template<class TInputImage, class TLabelImage, class TOutputImage, class TKernel, class THistogram>
+template<class THist>
+void
+LabelMovingHistogramImageFilter<TInputImage, TLabelImage, TOutputImage, TKernel, THistogram>
+::ThreadedGenerateDataOnFaces(const FaceListType& faces,
+                              const THist & emptyHistogram,
+                              std::vector<THist> & HistVec,
+                              ProgressReporter & progress)
+{
+  // the interior block reads the labels with the linear offsets of the
+  // input, so it can only be used if both images have the same layout
+  bool interior = this->GetLabelImage()->GetBufferedRegion() == this->GetInput()->GetBufferedRegion();
+
+  for( typename FaceListType::const_iterator fit = faces.begin(); fit != faces.end(); fit++ )
+    {
+    if( fit->GetNumberOfPixels() > 0 )
+      {
+      this->ThreadedGenerateDataOnRegion( *fit, interior, emptyHistogram, HistVec, progress );
+      }
+    interior = false;
+    }
+}
+
+
+template<class TInputImage, class TLabelImage, class TOutputImage, class TKernel, class THistogram>
+template<class THist>
+void
+LabelMovingHistogramImageFilter<TInputImage, TLabelImage, TOutputImage, TKernel, THistogram>
+::ThreadedGenerateDataOnRegion(const OutputImageRegionType& region,
+                               bool interior,
+                               const THist & emptyHistogram,
+                               std::vector<THist> & HistVec,
+                               ProgressReporter & progress)
+{
+  OutputImageType* outputImage = this->GetOutput();
+  const InputImageType* inputImage = this->GetInput();
+  const LabelImageType* labelImage = this->GetLabelImage();
+
+  RegionType inputRegion = inputImage->GetRequestedRegion();
+
+  // initialize the histogram
+  THist & histogram = HistVec[0];
+  histogram = emptyHistogram;
+  for( typename OffsetListType::iterator listIt = this->m_KernelOffsets.begin();
+      listIt != this->m_KernelOffsets.end(); listIt++ )
+    {
+    IndexType idx = region.GetIndex() + (*listIt);
+    if( inputRegion.IsInside( idx ) )
+      {
+      histogram.AddPixel( inputImage->GetPixel(idx), labelImage->GetPixel(idx) );
+      }
+    else
+      {
+      histogram.AddBoundary();
+      }
+    }
+
+  // now move the histogram
+  OffsetType offset;
+  offset.Fill( 0 );
+  RegionType stRegion;
+  stRegion.SetSize( this->m_Kernel.GetSize() );
+  stRegion.PadByRadius( 1 ); // must pad the region by one because of the translation
+
+  OffsetType centerOffset;
+  for( unsigned axis=0; axis<ImageDimension; axis++)
+    { centerOffset[axis] = stRegion.GetSize()[axis] / 2; }
+
+  int BestDirection = this->m_Axes[ImageDimension - 1];
+
+  // init the offset and get the lists for the best axis
+  offset[BestDirection] = 1;
+  // it's very important for performances to get a pointer and not a copy
+  const OffsetListType* addedList = &this->m_AddedOffsets[offset];
+  const OffsetListType* removedList = &this->m_RemovedOffsets[offset];
+  const LinearOffsetListType* addedLinearList = &this->m_AddedLinearOffsets[offset];
+  const LinearOffsetListType* removedLinearList = &this->m_RemovedLinearOffsets[offset];
+
+  // the buffers used in the interior block
+  InputAccessorType inAccessor = inputImage->GetNeighborhoodAccessor();
+  const InputInternalPixelType * inBuffer = inputImage->GetBufferPointer();
+  inAccessor.SetBegin( inBuffer );
+  const LabelInternalPixelType * labelBuffer = labelImage->GetBufferPointer();
+  OutputAccessorType outAccessor = outputImage->GetNeighborhoodAccessor();
+  OutputInternalPixelType * outBuffer = outputImage->GetBufferPointer();
+  outAccessor.SetBegin( outBuffer );
+  const OffsetValueType inStride = inputImage->GetOffsetTable()[BestDirection];
+  const OffsetValueType outStride = outputImage->GetOffsetTable()[BestDirection];
+  const long lineLength = region.GetSize()[BestDirection];
+
+  typedef typename itk::ImageLinearConstIteratorWithIndex<InputImageType> InputLineIteratorType;
+  InputLineIteratorType InLineIt(inputImage, region);
+  InLineIt.SetDirection(BestDirection);
+
+  InLineIt.GoToBegin();
+  IndexType LineStart;
+
+  for (unsigned i=1;i<ImageDimension;i++)
+    {
+    HistVec[i] = histogram;
+    }
+
+  while(!InLineIt.IsAtEnd())
+    {
+    THist *histRef = &HistVec[BestDirection];
+    IndexType PrevLineStart = InLineIt.GetIndex();
+    OutputInternalPixelType * outPtr = outBuffer + outputImage->ComputeOffset( PrevLineStart );
+    if( interior )
+      {
+      // the kernel is always inside the image: no bounds check, no
+      // index computation
+      const OffsetValueType lineOffset = inputImage->ComputeOffset( PrevLineStart );
+      const InputInternalPixelType * inPtr = inBuffer + lineOffset;
+      const LabelInternalPixelType * labelPtr = labelBuffer + lineOffset;
+      for( long p=0; p<lineLength; p++, inPtr += inStride, labelPtr += inStride, outPtr += outStride )
+        {
+        const LabelPixelType label = *labelPtr;
+        if( histRef->IsValid( label ) )
+          {
+          outAccessor.Set( outPtr, static_cast< OutputPixelType >( histRef->GetValue( inAccessor.Get( inPtr ), label ) ) );
+          }
+        else
+          {
+          outAccessor.Set( outPtr, m_FillValue );
+          }
+        pushHistogramLinear( histRef, addedLinearList, removedLinearList, inAccessor, inPtr, labelPtr );
+        }
+      }
+    else
+      {
+      IndexType currentIdx = PrevLineStart;
+      for( long p=0; p<lineLength; p++, outPtr += outStride )
+        {
+        const LabelPixelType label = labelImage->GetPixel( currentIdx );
+        if( histRef->IsValid( label ) )
+          {
+          outAccessor.Set( outPtr, static_cast< OutputPixelType >( histRef->GetValue( inputImage->GetPixel( currentIdx ), label ) ) );
+          }
+        else
+          {
+          outAccessor.Set( outPtr, m_FillValue );
+          }
+        stRegion.SetIndex( currentIdx - centerOffset );
+        pushHistogram( histRef, addedList, removedList, inputRegion,
+                       stRegion, inputImage, labelImage, currentIdx );
+        currentIdx[BestDirection]++;
+        }
+      }
+    InLineIt.NextLine();
+    if (InLineIt.IsAtEnd())
+      {
+      break;
+      }
+    LineStart = InLineIt.GetIndex();
+    // move the stored histogram of the direction of the line change,
+    // and copy it to the directions which change faster - see
+    // MovingHistogramImageFilter
+    OffsetType LineOffset, Changes;
+    int LineDirection;
+    this->GetDirAndOffset(LineStart, PrevLineStart, ImageDimension,
+                    LineOffset, Changes, LineDirection);
+    IndexType PrevLineStartHist = LineStart - LineOffset;
+    THist *tmpHist = &HistVec[LineDirection];
+    if( interior )
+      {
+      OffsetValueType histOffset = inputImage->ComputeOffset( PrevLineStartHist );
+      pushHistogramLinear( tmpHist, &this->m_AddedLinearOffsets[LineOffset],
+                           &this->m_RemovedLinearOffsets[LineOffset], inAccessor,
+                           inBuffer + histOffset, labelBuffer + histOffset );
+      }
+    else
+      {
+      stRegion.SetIndex(PrevLineStartHist - centerOffset);
+      pushHistogram(tmpHist, &this->m_AddedOffsets[LineOffset],
+                    &this->m_RemovedOffsets[LineOffset], inputRegion,
+                    stRegion, inputImage, labelImage, PrevLineStartHist);
+      }
+
+    for (unsigned i=0;i<ImageDimension;i++)
+      {
+      if (i != (unsigned)LineDirection && (i == (unsigned)BestDirection || i < (unsigned)LineDirection))
+        {
+        HistVec[i] = HistVec[LineDirection];
+        }
+      }
+    progress.CompletedPixel();
+    }
+  // the last line of the region
+  progress.CompletedPixel();
+}
+
+
+template<class TInputImage, class TLabelImage, class TOutputImage, class TKernel, class THistogram>
+template<class THist>
+void
+LabelMovingHistogramImageFilter<TInputImage, TLabelImage, TOutputImage, TKernel, THistogram>
+::pushHistogram(THist *histogram,
+                const OffsetListType* addedList,
+                const OffsetListType* removedList,
+                const RegionType &inputRegion,
+                const RegionType &kernRegion,
+                const InputImageType* inputImage,
+                const LabelImageType *labelImage,
+                const IndexType currentIdx)
+{
+  if( inputRegion.IsInside( kernRegion ) )
+    {
+    for( typename OffsetListType::const_iterator addedIt = addedList->begin();
+        addedIt != addedList->end(); addedIt++ )
+      {
+      IndexType idx = currentIdx + (*addedIt);
+      histogram->AddPixel( inputImage->GetPixel( idx ), labelImage->GetPixel( idx ) );
+      }
+    for( typename OffsetListType::const_iterator removedIt = removedList->begin();
+        removedIt != removedList->end(); removedIt++ )
+      {
+      IndexType idx = currentIdx + (*removedIt);
+      histogram->RemovePixel( inputImage->GetPixel( idx ), labelImage->GetPixel( idx ) );
+      }
+    }
+  else
+    {
+    for( typename OffsetListType::const_iterator addedIt = addedList->begin();
+        addedIt != addedList->end(); addedIt++ )
+      {
+      IndexType idx = currentIdx + (*addedIt);
+      if( inputRegion.IsInside( idx ) )
+        {
+        histogram->AddPixel( inputImage->GetPixel( idx ), labelImage->GetPixel( idx ) );
+        }
+      else
+        {
+        histogram->AddBoundary();
+        }
+      }
+    for( typename OffsetListType::const_iterator removedIt = removedList->begin();
+        removedIt != removedList->end(); removedIt++ )
+      {
+      IndexType idx = currentIdx + (*removedIt);
+      if( inputRegion.IsInside( idx ) )
+        {
+        histogram->RemovePixel( inputImage->GetPixel( idx ), labelImage->GetPixel( idx ) );
+        }
+      else
+        {
+        histogram->RemoveBoundary();
+        }
+      }
+    }
+}
+
+
+template<class TInputImage, class TLabelImage, class TOutputImage, class TKernel, class THistogram>
+void
+LabelMovingHistogramImageFilter<TInputImage, TLabelImage, TOutputImage, TKernel, THistogram>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FillValue: "  << static_cast<typename NumericTraits<OutputPixelType>::PrintType>(m_FillValue) << std::endl;
+}
+
+}// end namespace itk
+#endif
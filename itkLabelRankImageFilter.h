@@ -0,0 +1,105 @@
+#ifndef __itkLabelRankImageFilter_h
+#define __itkLabelRankImageFilter_h
+
+#include "itkLabelMovingHistogramImageFilter.h"
+#include "itkLabelHistogram.h"
+#include "itkRankHistogramMask.h"
+
+namespace itk {
+
+/**
+ * \class LabelRankImageFilter
+ * \brief Rank filter of a greyscale image, computed in each label
+ *
+ * Each output pixel is the given rank (the median by default) of the
+ * input pixels of its kernel which have the same label as itself in
+ * the label image. The result is the same as running a
+ * MaskedRankImageFilter for each label, with that label as MaskValue,
+ * and merging the results on the pixels of each label, but the image is
+ * traversed only once, whatever the number of labels.
+ *
+ * A histogram is kept for each label present in the kernel (see
+ * LabelHistogram). These histograms are of the type used by
+ * MaskedRankImageFilter for the input pixel type, so the cost of a
+ * label is about the cost of the masked filter, and the labels which are
+ * not in the kernel don't cost anything.
+ *
+ * As in the other filters of this package, the neighborhood is cropped
+ * at the border of the image.
+ *
+ * \sa MaskedRankImageFilter, LabelMovingHistogramImageFilter
+ */
+
+template<class TInputImage, class TLabelImage, class TOutputImage, class TKernel >
+class ITK_EXPORT LabelRankImageFilter :
+    public LabelMovingHistogramImageFilter<TInputImage, TLabelImage, TOutputImage, TKernel,
+      LabelHistogram< typename TInputImage::PixelType, typename TLabelImage::PixelType,
+        typename RankHistogramMaskSelector< typename TInputImage::PixelType >::Type > >
+{
+public:
+  /** Standard class typedefs. */
+  typedef LabelRankImageFilter Self;
+  typedef LabelMovingHistogramImageFilter<TInputImage, TLabelImage, TOutputImage, TKernel,
+    LabelHistogram< typename TInputImage::PixelType, typename TLabelImage::PixelType,
+      typename RankHistogramMaskSelector< typename TInputImage::PixelType >::Type > >  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(LabelRankImageFilter,
+               LabelMovingHistogramImageFilter);
+
+  /** Image related typedefs. */
+  typedef TInputImage InputImageType;
+  typedef TOutputImage OutputImageType;
+  typedef TLabelImage LabelImageType;
+  typedef typename TInputImage::RegionType RegionType ;
+  typedef typename TInputImage::SizeType SizeType ;
+  typedef typename TInputImage::IndexType IndexType ;
+  typedef typename TInputImage::PixelType PixelType ;
+  typedef typename TInputImage::OffsetType OffsetType ;
+  typedef typename Superclass::OutputImageRegionType OutputImageRegionType;
+  typedef typename TOutputImage::PixelType OutputPixelType ;
+  typedef typename TInputImage::PixelType InputPixelType ;
+
+  /** Image related typedefs. */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+
+  /** Kernel typedef. */
+  typedef TKernel KernelType;
+
+  /** n-dimensional Kernel radius. */
+  typedef typename KernelType::SizeType RadiusType ;
+
+  itkSetMacro(Rank, float)
+  itkGetMacro(Rank, float)
+
+protected:
+  LabelRankImageFilter();
+  ~LabelRankImageFilter() {};
+
+  typedef typename Superclass::HistogramType HistogramType;
+
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  virtual HistogramType * NewHistogram();
+
+private:
+  LabelRankImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  float m_Rank;
+
+} ; // end of class
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkLabelRankImageFilter.txx"
+#endif
+
+#endif
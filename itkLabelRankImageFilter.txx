@@ -0,0 +1,41 @@
+#ifndef __itkLabelRankImageFilter_txx
+#define __itkLabelRankImageFilter_txx
+
+#include "itkLabelRankImageFilter.h"
+#include "itkNumericTraits.h"
+
+namespace itk {
+
+
+template<class TInputImage, class TLabelImage, class TOutputImage, class TKernel >
+LabelRankImageFilter<TInputImage, TLabelImage, TOutputImage, TKernel>
+::LabelRankImageFilter()
+{
+  m_Rank = 0.5;
+}
+
+
+template<class TInputImage, class TLabelImage, class TOutputImage, class TKernel >
+typename LabelRankImageFilter<TInputImage, TLabelImage, TOutputImage, TKernel>::HistogramType *
+LabelRankImageFilter<TInputImage, TLabelImage, TOutputImage, TKernel>
+::NewHistogram()
+{
+  // the histogram of each label is a copy of this one
+  typename HistogramType::HistogramType labelHistogram;
+  labelHistogram.SetRank( this->GetRank() );
+  return new HistogramType( labelHistogram );
+}
+
+
+template<class TInputImage, class TLabelImage, class TOutputImage, class TKernel >
+void
+LabelRankImageFilter<TInputImage, TLabelImage, TOutputImage, TKernel>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Rank: " << static_cast<typename NumericTraits< float >::PrintType>( m_Rank ) << std::endl;
+}
+
+}// end namespace itk
+#endif
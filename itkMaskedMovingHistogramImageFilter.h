@@ -18,10 +18,12 @@
 #define __itkMaskedMovingHistogramImageFilter_h
 
 #include "itkMovingHistogramImageFilterBase.h"
+#include "itkRebindHistogramCount.h"
 #include <list>
 #include <map>
 #include <set>
 #include "itkOffsetLexicographicCompare.h"
+#include "itkPackedMask.h"
 
 namespace itk {
 
@@ -109,6 +111,18 @@ public:
 
   typedef typename std::map< OffsetType, OffsetListType, typename Functor::OffsetLexicographicCompare<ImageDimension> > OffsetMapType;
 
+  typedef typename Superclass::OffsetValueType OffsetValueType;
+  typedef typename Superclass::LinearOffsetListType LinearOffsetListType;
+  typedef typename Superclass::InputInternalPixelType InputInternalPixelType;
+  typedef typename Superclass::InputAccessorType InputAccessorType;
+  typedef typename Superclass::OutputInternalPixelType OutputInternalPixelType;
+  typedef typename Superclass::OutputAccessorType OutputAccessorType;
+  typedef typename MaskImageType::InternalPixelType MaskInternalPixelType;
+  typedef typename Superclass::FaceListType FaceListType;
+
+  /** The mask stored with one bit per pixel */
+  typedef PackedMask< itkGetStaticConstMacro(ImageDimension) > PackedMaskType;
+
   /** Get the modified mask image */
   MaskImageType * GetOutputMask();
 
@@ -129,10 +143,93 @@ public:
   itkGetMacro(GenerateOutputMask, bool);
 //   itkBooleanMacro(GenerateOutputMask);
 
+  /** Only move the histogram over the runs of pixels of the mask. The
+   * output is first filled with FillValue (and the output mask with
+   * BackgroundMaskValue), then the runs of each line are found with a
+   * scan of the mask, and the lines without mask pixels are skipped.
+   * The histogram is moved from the end of a run to the start of the
+   * next one when it costs less than filling it again with the whole
+   * kernel, and is filled again otherwise. The time spent in the
+   * histogram depends on the number of pixels in the mask instead of
+   * the size of the image, so this mode is much faster with a small
+   * mask. The output is the same as without it. Defaults to false. */
+  itkSetMacro(UseMaskRuns, bool);
+  itkGetConstMacro(UseMaskRuns, bool);
+  itkBooleanMacro(UseMaskRuns);
+
+  /** Write the value of the pixels of the mask. When it is off, the
+   * value is written for the pixels out of the mask instead, computed
+   * from the pixels of the mask in their kernel, and the pixels of the
+   * mask are set to FillValue, unless ReturnUnion is on. The pixels
+   * without any pixel of the mask in their kernel are always set to
+   * FillValue, and the output masks contain the pixels which got a
+   * value. The runs of mask pixels can't be used when the pixels out of
+   * the mask are written: UseMaskRuns is then ignored. Defaults to
+   * true. */
+  itkSetMacro(WriteInsideMask, bool);
+  itkGetConstMacro(WriteInsideMask, bool);
+  itkBooleanMacro(WriteInsideMask);
+
+  /** When WriteInsideMask is off, also write the value of the pixels of
+   * the mask. Defaults to false. */
+  itkSetMacro(ReturnUnion, bool);
+  itkGetConstMacro(ReturnUnion, bool);
+  itkBooleanMacro(ReturnUnion);
+
+  /** Use a packed mask instead of the mask image, which is then not
+   * required. The packed mask must contain the requested region of the
+   * input, and is read during the execution of the filter only, so it
+   * can be filled by an other filter of the same pipeline, like the
+   * packed output mask of the previous stage. The filter is always
+   * modified, because the content of the mask may have changed. Set it
+   * to NULL to use the mask image again. */
+  void SetPackedMask( const PackedMaskType * mask );
+  const PackedMaskType * GetPackedMask() const
+    {
+    return m_PackedMask;
+    }
+
+  /** Store the output mask in a packed mask, on the requested region of
+   * the output, instead of (or in addition to) the output mask image
+   * produced by GenerateOutputMask. Defaults to false. */
+  itkSetMacro(GeneratePackedOutputMask, bool);
+  itkGetConstMacro(GeneratePackedOutputMask, bool);
+  itkBooleanMacro(GeneratePackedOutputMask);
+
+  /** The packed output mask, filled by the last execution of the filter
+   * when GeneratePackedOutputMask is on */
+  const PackedMaskType * GetPackedOutputMask() const
+    {
+    return &m_PackedOutputMask;
+    }
+
+  /** Only write the value of the pixels of this packed mask. The other
+   * pixels are set to FillValue, as MaskImageFilter would do after the
+   * filter, but their histogram is still moved and the output masks
+   * are not changed. The packed mask must contain the requested region
+   * of the output, and is read during the execution of the filter only.
+   * NULL, the default, writes all the pixels. */
+  void SetPackedWriteMask( const PackedMaskType * mask )
+    {
+    m_PackedWriteMask = mask;
+    this->Modified();
+    }
+  const PackedMaskType * GetPackedWriteMask() const
+    {
+    return m_PackedWriteMask;
+    }
+
 protected:
   MaskedMovingHistogramImageFilter();
   ~MaskedMovingHistogramImageFilter() {};
 
+  /** Pack the mask image, unless a packed mask was given, and
+   * initialize the packed output mask */
+  void BeforeThreadedGenerateData();
+
+  /** Copy the masks of the threads to the packed output mask */
+  void AfterThreadedGenerateData();
+
   /** Multi-thread version GenerateData. */
   void  ThreadedGenerateData (const OutputImageRegionType& 
                               outputRegionForThread,
@@ -147,15 +244,93 @@ protected:
    */
   virtual THistogram * NewHistogram();
 
-  void pushHistogram(HistogramType *histogram, 
+  template <class THist>
+  void pushHistogram(THist *histogram, 
 		     const OffsetListType* addedList,
 		     const OffsetListType* removedList,
 		     const RegionType &inputRegion,
 		     const RegionType &kernRegion,
 		     const InputImageType* inputImage,
-		     const MaskImageType *maskImage,
+		     const PackedMaskType *mask,
 		     const IndexType currentIdx);
 
+  /** Run the filter on the region of the thread with a copy of
+   * emptyHistogram. THist is the histogram type given by
+   * RebindHistogramCount for the number of pixels in the kernel. */
+  template <class THist>
+  void ThreadedGenerateDataWithHistogram(const OutputImageRegionType& outputRegionForThread,
+                                         int threadId,
+                                         const THist & emptyHistogram);
+
+  /** Run the moving histogram on the faces computed by ComputeFaces().
+   * The first face is processed without bounds check when the packed
+   * mask has the buffered region of the input as region. HistVec stores the
+   * histograms of each direction, by value. */
+  template <class THist>
+  void ThreadedGenerateDataOnFaces(const FaceListType& faces,
+                                   const THist & emptyHistogram,
+                                   std::vector<THist> & HistVec,
+                                   PackedMaskType * threadOutputMask,
+                                   ProgressReporter & progress);
+
+  /** Run the moving histogram on a region. When interior is true, the
+   * kernel must stay inside the input requested region on the whole
+   * region, and the packed mask must have the buffered region of the
+   * input as region. The histograms of HistVec are restarted from
+   * emptyHistogram. The output mask of the pixels is stored in
+   * threadOutputMask, if not NULL. */
+  template <class THist>
+  void ThreadedGenerateDataOnRegion(const OutputImageRegionType& region,
+                                    bool interior,
+                                    const THist & emptyHistogram,
+                                    std::vector<THist> & HistVec,
+                                    PackedMaskType * threadOutputMask,
+                                    ProgressReporter & progress);
+
+  /** Run the moving histogram on the runs of mask pixels of a region,
+   * when UseMaskRuns is on */
+  template <class THist>
+  void ThreadedGenerateDataOnMaskRuns(const OutputImageRegionType& region,
+                                      const THist & emptyHistogram,
+                                      PackedMaskType * threadOutputMask,
+                                      ProgressReporter & progress);
+
+  /** Update the histogram when the kernel is known to be inside the
+   * image. The bits of the mask are read at the same offsets as the
+   * input, from the offset of the current pixel in the mask. */
+  template <class THist>
+  inline void pushHistogramLinear(THist * histogram,
+                                  const LinearOffsetListType* addedList,
+                                  const LinearOffsetListType* removedList,
+                                  const InputAccessorType &accessor,
+                                  const InputInternalPixelType * currentPtr,
+                                  const PackedMaskType * mask,
+                                  OffsetValueType currentMaskOffset)
+    {
+    for( typename LinearOffsetListType::const_iterator addedIt = addedList->begin(); addedIt != addedList->end(); addedIt++ )
+      {
+      if( mask->Test( currentMaskOffset + (*addedIt) ) )
+        { histogram->AddPixel( accessor.Get( currentPtr + (*addedIt) ) ); }
+      else
+        { histogram->AddBoundary(); }
+      }
+    for( typename LinearOffsetListType::const_iterator removedIt = removedList->begin(); removedIt != removedList->end(); removedIt++ )
+      {
+      if( mask->Test( currentMaskOffset + (*removedIt) ) )
+        { histogram->RemovePixel( accessor.Get( currentPtr + (*removedIt) ) ); }
+      else
+        { histogram->RemoveBoundary(); }
+      }
+    }
+
+  /** A copy of the mask on a region processed by the thread, where the
+   * pixels of the mask which don't get a value are reset, and the pixels
+   * out of the mask which get one are set, or NULL when no packed output
+   * mask is generated. The masks of the threads are copied to the packed
+   * output mask by AfterThreadedGenerateData(), so the threads never
+   * write to the same word. */
+  PackedMaskType * NewThreadOutputMask( const OutputImageRegionType & region, int threadId );
+
 private:
   MaskedMovingHistogramImageFilter(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
@@ -168,6 +343,30 @@ private:
 
   MaskPixelType m_BackgroundMaskValue;
 
+  bool m_UseMaskRuns;
+
+  bool m_WriteInsideMask;
+
+  bool m_ReturnUnion;
+
+  // the packed mask given by the user, if any
+  const PackedMaskType * m_PackedMask;
+
+  // the packed copy of the mask image, when no packed mask is given
+  PackedMaskType m_PackedMaskImage;
+
+  // the packed mask used by the current execution of the filter
+  const PackedMaskType * m_Mask;
+
+  bool m_GeneratePackedOutputMask;
+  PackedMaskType m_PackedOutputMask;
+
+  // the masks of the regions processed by each thread
+  std::vector< std::list< PackedMaskType > > m_ThreadOutputMasks;
+
+  // the pixels written with their value, if not all of them
+  const PackedMaskType * m_PackedWriteMask;
+
 } ; // end of class
 
 } // end namespace itk
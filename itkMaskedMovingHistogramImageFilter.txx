@@ -27,6 +27,8 @@
 #include "itkImageRegionIterator.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkImageLinearConstIteratorWithIndex.h"
+#include <vector>
+#include <utility>
 
 
 namespace itk {
@@ -41,6 +43,13 @@ MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel,
   this->m_MaskValue = NumericTraits< MaskPixelType >::max();
   this->m_BackgroundMaskValue = NumericTraits< MaskPixelType >::Zero;
   this->SetGenerateOutputMask( false );
+  this->m_UseMaskRuns = false;
+  this->m_WriteInsideMask = true;
+  this->m_ReturnUnion = false;
+  this->m_PackedMask = NULL;
+  this->m_Mask = NULL;
+  this->m_GeneratePackedOutputMask = false;
+  this->m_PackedWriteMask = NULL;
 }
 
 
@@ -78,6 +87,18 @@ MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel,
 }
 
 
+template<class TInputImage, class TMaskImage, class TOutputImage, class TKernel, class THistogram>
+void
+MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel, THistogram>
+::SetPackedMask( const PackedMaskType * mask )
+{
+  m_PackedMask = mask;
+  // the mask image is only required without packed mask
+  this->SetNumberOfRequiredInputs( mask ? 1 : 2 );
+  this->Modified();
+}
+
+
 template<class TInputImage, class TMaskImage, class TOutputImage, class TKernel, class THistogram>
 void
 MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel, THistogram>
@@ -130,45 +151,238 @@ MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel,
 }
 
 
+template<class TInputImage, class TMaskImage, class TOutputImage, class TKernel, class THistogram>
+void
+MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel, THistogram>
+::BeforeThreadedGenerateData()
+{
+  Superclass::BeforeThreadedGenerateData();
+
+  // the threads only read the bits of the mask
+  if( m_PackedMask )
+    {
+    m_Mask = m_PackedMask;
+    }
+  else
+    {
+    m_PackedMaskImage.Pack( this->GetMaskImage(), m_MaskValue );
+    m_Mask = &m_PackedMaskImage;
+    }
+
+  if( m_GeneratePackedOutputMask )
+    {
+    // the threads remove the pixels of the mask which don't get a
+    // value, and add the pixels out of the mask which get one, in their
+    // own copies of the mask
+    m_PackedOutputMask.SetRegion( this->GetOutput()->GetRequestedRegion() );
+    m_ThreadOutputMasks.assign( this->GetNumberOfThreads(), std::list< PackedMaskType >() );
+    }
+}
+
+
+template<class TInputImage, class TMaskImage, class TOutputImage, class TKernel, class THistogram>
+void
+MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel, THistogram>
+::AfterThreadedGenerateData()
+{
+  Superclass::AfterThreadedGenerateData();
+
+  if( !m_GeneratePackedOutputMask )
+    {
+    return;
+    }
+  for( unsigned int t=0; t<m_ThreadOutputMasks.size(); t++ )
+    {
+    for( typename std::list< PackedMaskType >::const_iterator it = m_ThreadOutputMasks[t].begin(); it != m_ThreadOutputMasks[t].end(); it++ )
+      {
+      m_PackedOutputMask.PasteRegion( *it );
+      }
+    }
+  m_ThreadOutputMasks.clear();
+}
+
+
+template<class TInputImage, class TMaskImage, class TOutputImage, class TKernel, class THistogram>
+typename MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel, THistogram>::PackedMaskType *
+MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel, THistogram>
+::NewThreadOutputMask( const OutputImageRegionType & region, int threadId )
+{
+  if( !m_GeneratePackedOutputMask )
+    {
+    return NULL;
+    }
+  // a list: the masks already given to the thread are never moved
+  std::list< PackedMaskType > & masks = m_ThreadOutputMasks[threadId];
+  masks.push_back( PackedMaskType() );
+  masks.back().CopyRegion( *m_Mask, region );
+  return &masks.back();
+}
+
+
+template<class TInputImage, class TMaskImage, class TOutputImage, class TKernel, class THistogram>
+void
+MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel, THistogram>
+::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+                      int threadId) 
+{
+  HistogramType * histogram = this->NewHistogram();
+
+  // a bin can't count more pixels than there are in the kernel: use the
+  // narrowest count type able to store that number
+  const unsigned long kernelCount = this->m_KernelPixelCount;
+  if( kernelCount <= NumericTraits< unsigned short >::max() )
+    {
+    typedef typename RebindHistogramCount< HistogramType, unsigned short >::Type NarrowHistogramType;
+    this->ThreadedGenerateDataWithHistogram( outputRegionForThread, threadId, NarrowHistogramType( *histogram ) );
+    }
+  else if( kernelCount <= NumericTraits< unsigned int >::max() )
+    {
+    typedef typename RebindHistogramCount< HistogramType, unsigned int >::Type NarrowHistogramType;
+    this->ThreadedGenerateDataWithHistogram( outputRegionForThread, threadId, NarrowHistogramType( *histogram ) );
+    }
+  else
+    {
+    this->ThreadedGenerateDataWithHistogram( outputRegionForThread, threadId, *histogram );
+    }
+  delete histogram;
+}
+
+
+template<class TInputImage, class TMaskImage, class TOutputImage, class TKernel, class THistogram>
+template<class THist>
+void
+MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel, THistogram>
+::ThreadedGenerateDataWithHistogram(const OutputImageRegionType& outputRegionForThread,
+                                    int threadId,
+                                    const THist & emptyHistogram) 
+{
+  // the histograms stored for each direction, allocated once per thread
+  std::vector<THist> HistVec( ImageDimension, emptyHistogram );
+
+  // split the region in the interior block, where the histogram is
+  // updated without any bounds check, and the boundary faces
+  FaceListType faces;
+
+  // the runs only contain the pixels of the mask
+  const bool useMaskRuns = m_UseMaskRuns && m_WriteInsideMask;
+
+  if( this->m_UseDynamicScheduling )
+    {
+    // the region of the thread is ignored: take the chunks until there
+    // is no more work. The cost of a chunk depends on the mask, so the
+    // threads with the cheapest chunks process more of them.
+    ProgressReporter progress(this, threadId, this->m_NumberOfLinesPerThread);
+    OutputImageRegionType chunk;
+    while( this->GetNextChunk( chunk ) )
+      {
+      if( useMaskRuns )
+        {
+        this->ThreadedGenerateDataOnMaskRuns( chunk, emptyHistogram,
+                                              this->NewThreadOutputMask( chunk, threadId ), progress );
+        }
+      else
+        {
+        this->ComputeFaces( chunk, faces );
+        this->ThreadedGenerateDataOnFaces( faces, emptyHistogram, HistVec,
+                                           this->NewThreadOutputMask( chunk, threadId ), progress );
+        }
+      }
+    }
+  else if( useMaskRuns )
+    {
+    // Report progress every line of the region
+    const int BestDirection = this->m_Axes[ImageDimension - 1];
+    unsigned long nbOfLines = 0;
+    if( outputRegionForThread.GetNumberOfPixels() > 0 )
+      {
+      nbOfLines = outputRegionForThread.GetNumberOfPixels() / outputRegionForThread.GetSize()[BestDirection];
+      }
+    ProgressReporter progress(this, threadId, nbOfLines);
+    this->ThreadedGenerateDataOnMaskRuns( outputRegionForThread, emptyHistogram,
+                                          this->NewThreadOutputMask( outputRegionForThread, threadId ), progress );
+    }
+  else
+    {
+    this->ComputeFaces( outputRegionForThread, faces );
+    // Report progress every line instead of every pixel
+    ProgressReporter progress(this, threadId, this->GetNumberOfLines( faces ));
+    this->ThreadedGenerateDataOnFaces( faces, emptyHistogram, HistVec,
+                                       this->NewThreadOutputMask( outputRegionForThread, threadId ), progress );
+    }
+}
+
+
+template<class TInputImage, class TMaskImage, class TOutputImage, class TKernel, class THistogram>
+template<class THist>
+void
+MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel, THistogram>
+::ThreadedGenerateDataOnFaces(const FaceListType& faces,
+                              const THist & emptyHistogram,
+                              std::vector<THist> & HistVec,
+                              PackedMaskType * threadOutputMask,
+                              ProgressReporter & progress) 
+{
+  // the interior block reads the mask with the linear offsets of the
+  // input, so it can only be used if the packed mask has the same
+  // layout as the input buffer
+  bool interior = m_Mask->GetRegion() == this->GetInput()->GetBufferedRegion();
+
+  for( typename FaceListType::const_iterator fit = faces.begin(); fit != faces.end(); fit++ )
+    {
+    if( fit->GetNumberOfPixels() > 0 )
+      {
+      this->ThreadedGenerateDataOnRegion( *fit, interior, emptyHistogram, HistVec, threadOutputMask, progress );
+      }
+    interior = false;
+    }
+}
+
+
 // a modified version that uses line iterators and only moves the
 // histogram in one direction. Hopefully it will be a bit simpler and
 // faster due to improved memory access and a tighter loop.
 template<class TInputImage, class TMaskImage, class TOutputImage, class TKernel, class THistogram>
+template<class THist>
 void
 MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel, THistogram>
-::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
-                      int threadId) 
+::ThreadedGenerateDataOnRegion(const OutputImageRegionType& region,
+                               bool interior,
+                               const THist & emptyHistogram,
+                               std::vector<THist> & HistVec,
+                               PackedMaskType * threadOutputMask,
+                               ProgressReporter & progress) 
 {
   
-  // instantiate the histogram
-  HistogramType * histogram = this->NewHistogram();
-    
   OutputImageType* outputImage = this->GetOutput();
   MaskImageType * outputMask = this->GetOutputMask();
   const InputImageType* inputImage = this->GetInput();
-  const MaskImageType *maskImage = this->GetMaskImage();
+  const PackedMaskType *mask = m_Mask;
+  const PackedMaskType *writeMask = m_PackedWriteMask;
+  const bool writeInside = m_WriteInsideMask || m_ReturnUnion;
+  const bool writeOutside = !m_WriteInsideMask;
 
   RegionType inputRegion = inputImage->GetRequestedRegion();
 
   // initialize the histogram
+  THist & histogram = HistVec[0];
+  histogram = emptyHistogram;
   for( typename OffsetListType::iterator listIt = this->m_KernelOffsets.begin(); 
       listIt != this->m_KernelOffsets.end(); listIt++ )
     {
-    IndexType idx = outputRegionForThread.GetIndex() + (*listIt);
-    if( inputRegion.IsInside( idx ) && maskImage->GetPixel(idx) == m_MaskValue )
+    IndexType idx = region.GetIndex() + (*listIt);
+    if( inputRegion.IsInside( idx ) && mask->Test( mask->ComputeOffset( idx ) ) )
       {
-      histogram->AddPixel( inputImage->GetPixel(idx) );
+      histogram.AddPixel( inputImage->GetPixel(idx) );
       }
     else
       {
-      histogram->AddBoundary();
+      histogram.AddBoundary();
       }
     }
 
   // now move the histogram
   itk::FixedArray<short, ImageDimension> direction;
   direction.Fill(1);
-  IndexType currentIdx = outputRegionForThread.GetIndex();
   int axis = ImageDimension - 1;
   OffsetType offset;
   offset.Fill( 0 );
@@ -183,72 +397,155 @@ MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel,
   int BestDirection = this->m_Axes[axis];
   int LineLength = inputRegion.GetSize()[BestDirection];
   
-  // Report progress every line instead of every pixel
-  ProgressReporter progress(this, threadId, outputRegionForThread.GetNumberOfPixels()/outputRegionForThread.GetSize()[BestDirection]);
   // init the offset and get the lists for the best axis
   offset[BestDirection] = direction[BestDirection];
   // it's very important for performances to get a pointer and not a copy
   const OffsetListType* addedList = &this->m_AddedOffsets[offset];;
   const OffsetListType* removedList = &this->m_RemovedOffsets[offset];
+  const LinearOffsetListType* addedLinearList = &this->m_AddedLinearOffsets[offset];
+  const LinearOffsetListType* removedLinearList = &this->m_RemovedLinearOffsets[offset];
+
+  // the buffers used in the interior block
+  InputAccessorType inAccessor = inputImage->GetNeighborhoodAccessor();
+  const InputInternalPixelType * inBuffer = inputImage->GetBufferPointer();
+  inAccessor.SetBegin( inBuffer );
+  OutputAccessorType outAccessor = outputImage->GetNeighborhoodAccessor();
+  OutputInternalPixelType * outBuffer = outputImage->GetBufferPointer();
+  outAccessor.SetBegin( outBuffer );
+  const OffsetValueType inStride = inputImage->GetOffsetTable()[BestDirection];
+  const OffsetValueType outStride = outputImage->GetOffsetTable()[BestDirection];
+  const long lineLength = region.GetSize()[BestDirection];
   
   typedef typename itk::ImageLinearConstIteratorWithIndex<InputImageType> InputLineIteratorType;
-  InputLineIteratorType InLineIt(inputImage, outputRegionForThread);
+  InputLineIteratorType InLineIt(inputImage, region);
   InLineIt.SetDirection(BestDirection);
   
-  typedef typename itk::ImageRegionIterator<OutputImageType> OutputIteratorType;
   InLineIt.GoToBegin();
   IndexType LineStart;
-  InLineIt.GoToBegin();
   
-  typedef typename std::vector<HistogramType *> HistVecType;
-  HistVecType HistVec(ImageDimension);
-  typedef typename std::vector<IndexType> IndexVecType;
-  IndexVecType PrevLineStartVec(ImageDimension);
-
-  // Steps is used to keep track of the order in which the line
-  // iterator passes over the various dimensions.
-  int *Steps = new int[ImageDimension];
   
   for (unsigned i=0;i<ImageDimension;i++)
     {
-    HistVec[i] = histogram->Clone();
-    PrevLineStartVec[i] = InLineIt.GetIndex();
-    Steps[i]=0;
+    if (i > 0)
+      {
+      HistVec[i] = histogram;
+      }
     }
 
   while(!InLineIt.IsAtEnd())
     {
-    HistogramType *histRef = HistVec[BestDirection];
+    THist *histRef = &HistVec[BestDirection];
     IndexType PrevLineStart = InLineIt.GetIndex();
-    for (InLineIt.GoToBeginOfLine(); !InLineIt.IsAtEndOfLine(); ++InLineIt)
+    if( interior )
       {
-      
-      // Update the histogram
-      IndexType currentIdx = InLineIt.GetIndex();
-
-      if( maskImage->GetPixel(currentIdx) == m_MaskValue && histRef->IsValid() ) 
-        {		
-        outputImage->SetPixel( currentIdx,
-                              static_cast< OutputPixelType >( histRef->GetValue( inputImage->GetPixel(currentIdx) ) ) );
-        if( this->m_GenerateOutputMask )
-          {
-          outputMask->SetPixel( currentIdx, m_MaskValue );
-          }
-        }	
-      else
-        {	
-        outputImage->SetPixel( currentIdx, m_FillValue );
-        if( this->m_GenerateOutputMask )
-          {
-          outputMask->SetPixel( currentIdx, m_BackgroundMaskValue );
+      // the kernel is always inside the image: no bounds check, no
+      // index computation
+      OffsetValueType lineOffset = inputImage->ComputeOffset( PrevLineStart );
+      const InputInternalPixelType * inPtr = inBuffer + lineOffset;
+      OffsetValueType maskOffset = lineOffset;
+      OutputInternalPixelType * outPtr = outBuffer + outputImage->ComputeOffset( PrevLineStart );
+      MaskInternalPixelType * outMaskPtr = 0;
+      OffsetValueType outMaskStride = 0;
+      if( this->m_GenerateOutputMask )
+        {
+        outMaskPtr = outputMask->GetBufferPointer() + outputMask->ComputeOffset( PrevLineStart );
+        outMaskStride = outputMask->GetOffsetTable()[BestDirection];
+        }
+      OffsetValueType writeOffset = 0;
+      OffsetValueType writeStride = 0;
+      if( writeMask )
+        {
+        writeOffset = writeMask->ComputeOffset( PrevLineStart );
+        writeStride = writeMask->GetOffsetTable()[BestDirection];
+        }
+      for( long p=0; p<lineLength; p++, inPtr += inStride, maskOffset += inStride, outPtr += outStride, outMaskPtr += outMaskStride, writeOffset += writeStride )
+        {
+        const bool inMask = mask->Test( maskOffset );
+        if( ( inMask ? writeInside : writeOutside ) && histRef->IsValid() ) 
+          {		
+          if( !writeMask || writeMask->Test( writeOffset ) )
+            {
+            outAccessor.Set( outPtr, static_cast< OutputPixelType >( histRef->GetValue( inAccessor.Get( inPtr ) ) ) );
+            }
+          else
+            {
+            outAccessor.Set( outPtr, m_FillValue );
+            }
+          if( this->m_GenerateOutputMask )
+            {
+            *outMaskPtr = m_MaskValue;
+            }
+          if( threadOutputMask && !inMask )
+            {
+            IndexType idx = PrevLineStart;
+            idx[BestDirection] += p;
+            threadOutputMask->Set( threadOutputMask->ComputeOffset( idx ) );
+            }
+          }	
+        else
+          {	
+          outAccessor.Set( outPtr, m_FillValue );
+          if( this->m_GenerateOutputMask )
+            {
+            *outMaskPtr = m_BackgroundMaskValue;
+            }
+          if( threadOutputMask && inMask )
+            {
+            IndexType idx = PrevLineStart;
+            idx[BestDirection] += p;
+            threadOutputMask->Reset( threadOutputMask->ComputeOffset( idx ) );
+            }
           }
+        pushHistogramLinear( histRef, addedLinearList, removedLinearList, inAccessor, inPtr, mask, maskOffset );
         }
-      stRegion.SetIndex( currentIdx - centerOffset );
-      pushHistogram(histRef, addedList, removedList, inputRegion, 
-                    stRegion, inputImage, maskImage, currentIdx);
+      }
+    else
+      {
+      for (InLineIt.GoToBeginOfLine(); !InLineIt.IsAtEndOfLine(); ++InLineIt)
+        {
+        
+        // Update the histogram
+        IndexType currentIdx = InLineIt.GetIndex();
+
+        const bool inMask = mask->Test( mask->ComputeOffset( currentIdx ) );
+        if( ( inMask ? writeInside : writeOutside ) && histRef->IsValid() ) 
+          {		
+          if( !writeMask || writeMask->Test( writeMask->ComputeOffset( currentIdx ) ) )
+            {
+            outputImage->SetPixel( currentIdx,
+                                  static_cast< OutputPixelType >( histRef->GetValue( inputImage->GetPixel(currentIdx) ) ) );
+            }
+          else
+            {
+            outputImage->SetPixel( currentIdx, m_FillValue );
+            }
+          if( this->m_GenerateOutputMask )
+            {
+            outputMask->SetPixel( currentIdx, m_MaskValue );
+            }
+          if( threadOutputMask && !inMask )
+            {
+            threadOutputMask->Set( threadOutputMask->ComputeOffset( currentIdx ) );
+            }
+          }	
+        else
+          {	
+          outputImage->SetPixel( currentIdx, m_FillValue );
+          if( this->m_GenerateOutputMask )
+            {
+            outputMask->SetPixel( currentIdx, m_BackgroundMaskValue );
+            }
+          if( threadOutputMask && inMask )
+            {
+            threadOutputMask->Reset( threadOutputMask->ComputeOffset( currentIdx ) );
+            }
+          }
+        stRegion.SetIndex( currentIdx - centerOffset );
+        pushHistogram(histRef, addedList, removedList, inputRegion, 
+                      stRegion, inputImage, mask, currentIdx);
 
+        }
       }
-    Steps[BestDirection] += LineLength;
     InLineIt.NextLine();
     if (InLineIt.IsAtEnd())
       {
@@ -267,50 +564,289 @@ MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel,
     // This function deals with changing planes etc
     this->GetDirAndOffset(LineStart, PrevLineStart, ImageDimension,
                     LineOffset, Changes, LineDirection);
-    ++(Steps[LineDirection]);
     IndexType PrevLineStartHist = LineStart - LineOffset;
-    const OffsetListType* addedListLine = &this->m_AddedOffsets[LineOffset];;
-    const OffsetListType* removedListLine = &this->m_RemovedOffsets[LineOffset];
-    HistogramType *tmpHist = HistVec[LineDirection];
-    stRegion.SetIndex(PrevLineStart - centerOffset);
+    THist *tmpHist = &HistVec[LineDirection];
     // Now move the histogram
-    pushHistogram(tmpHist, addedListLine, removedListLine, inputRegion, 
-                  stRegion, inputImage, maskImage, PrevLineStartHist);
+    if( interior )
+      {
+      OffsetValueType histOffset = inputImage->ComputeOffset( PrevLineStartHist );
+      pushHistogramLinear( tmpHist, &this->m_AddedLinearOffsets[LineOffset],
+                           &this->m_RemovedLinearOffsets[LineOffset], inAccessor,
+                           inBuffer + histOffset, mask, histOffset );
+      }
+    else
+      {
+      stRegion.SetIndex(PrevLineStartHist - centerOffset);
+      pushHistogram(tmpHist, &this->m_AddedOffsets[LineOffset],
+                    &this->m_RemovedOffsets[LineOffset], inputRegion, 
+                    stRegion, inputImage, mask, PrevLineStartHist);
+      }
     
-    //PrevLineStartVec[LineDirection] = LineStart;
     // copy the updated histogram and line start entries to the
     // relevant directions. When updating direction 2, for example,
-    // new copies of directions 0 and 1 should be made.
+    // new copies of directions 0 and 1 should be made. The line
+    // iterator moves along the axes in increasing order, so these are
+    // the axes below LineDirection, and the best direction. The copies
+    // are made in place, in the storage of the old histograms.
     for (unsigned i=0;i<ImageDimension;i++) 
       {
-      if (Steps[i] > Steps[LineDirection])
+      if (i != (unsigned)LineDirection && (i == (unsigned)BestDirection || i < (unsigned)LineDirection))
         {
-        // make sure this is the right thing to do
-        delete(HistVec[i]);
-        HistVec[i] = HistVec[LineDirection]->Clone();
+        HistVec[i] = HistVec[LineDirection];
         }
       }
     progress.CompletedPixel();
     }
-  for (unsigned i=0;i<ImageDimension;i++) 
+  // the last line of the region
+  progress.CompletedPixel();
+}
+
+
+template<class TInputImage, class TMaskImage, class TOutputImage, class TKernel, class THistogram>
+template<class THist>
+void
+MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel, THistogram>
+::ThreadedGenerateDataOnMaskRuns(const OutputImageRegionType& region,
+                                 const THist & emptyHistogram,
+                                 PackedMaskType * threadOutputMask,
+                                 ProgressReporter & progress) 
+{
+  if( region.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+
+  OutputImageType* outputImage = this->GetOutput();
+  MaskImageType * outputMask = this->GetOutputMask();
+  const InputImageType* inputImage = this->GetInput();
+  const PackedMaskType *mask = m_Mask;
+  const PackedMaskType *writeMask = m_PackedWriteMask;
+
+  RegionType inputRegion = inputImage->GetRequestedRegion();
+
+  // the pixels out of the runs are never visited again: fill the whole
+  // region first
+  ImageRegionIterator<OutputImageType> outIt( outputImage, region );
+  for( outIt.GoToBegin(); !outIt.IsAtEnd(); ++outIt )
+    {
+    outIt.Set( m_FillValue );
+    }
+  if( this->m_GenerateOutputMask )
+    {
+    ImageRegionIterator<MaskImageType> outMaskIt( outputMask, region );
+    for( outMaskIt.GoToBegin(); !outMaskIt.IsAtEnd(); ++outMaskIt )
+      {
+      outMaskIt.Set( m_BackgroundMaskValue );
+      }
+    }
+
+  const int BestDirection = this->m_Axes[ImageDimension - 1];
+
+  // the lists of the translations of one pixel along each axis, in the
+  // negative (0) and positive (1) directions, and the number of pixels
+  // they update
+  const OffsetListType* addedLists[ImageDimension][2];
+  const OffsetListType* removedLists[ImageDimension][2];
+  const LinearOffsetListType* addedLinearLists[ImageDimension][2];
+  const LinearOffsetListType* removedLinearLists[ImageDimension][2];
+  unsigned long translationCost[ImageDimension][2];
+  for( unsigned int axis=0; axis<ImageDimension; axis++ )
+    {
+    for( int d=0; d<2; d++ )
+      {
+      OffsetType offset;
+      offset.Fill( 0 );
+      offset[axis] = 2 * d - 1;
+      addedLists[axis][d] = &this->m_AddedOffsets[offset];
+      removedLists[axis][d] = &this->m_RemovedOffsets[offset];
+      addedLinearLists[axis][d] = &this->m_AddedLinearOffsets[offset];
+      removedLinearLists[axis][d] = &this->m_RemovedLinearOffsets[offset];
+      translationCost[axis][d] = addedLists[axis][d]->size() + removedLists[axis][d]->size();
+      }
+    }
+
+  // the positions where the kernel, padded by one pixel for the
+  // translation, stays inside the input. The histogram is updated there
+  // without bounds check when the packed mask has the same layout as
+  // the input buffer.
+  FaceListType faces;
+  this->ComputeFaces( inputRegion, faces );
+  const RegionType interiorRegion = faces.front();
+  const bool linear = mask->GetRegion() == inputImage->GetBufferedRegion();
+
+  InputAccessorType inAccessor = inputImage->GetNeighborhoodAccessor();
+  const InputInternalPixelType * inBuffer = inputImage->GetBufferPointer();
+  inAccessor.SetBegin( inBuffer );
+
+  RegionType stRegion;
+  stRegion.SetSize( this->m_Kernel.GetSize() );
+  stRegion.PadByRadius( 1 ); // must pad the region by one because of the translation
+  OffsetType centerOffset;
+  for( unsigned axis=0; axis<ImageDimension; axis++)
+    { centerOffset[axis] = stRegion.GetSize()[axis] / 2; }
+
+  THist histogram = emptyHistogram;
+  bool filled = false;
+  // the position of the kernel of the histogram
+  IndexType current;
+  current.Fill( 0 );
+
+  // the runs of the current line: their start and their length
+  std::vector< std::pair< long, long > > runs;
+
+  const long lineLength = region.GetSize()[BestDirection];
+  const OffsetValueType maskStride = mask->GetOffsetTable()[BestDirection];
+
+  typedef ImageLinearConstIteratorWithIndex<InputImageType> InputLineIteratorType;
+  InputLineIteratorType lineIt( inputImage, region );
+  lineIt.SetDirection( BestDirection );
+  for( lineIt.GoToBegin(); !lineIt.IsAtEnd(); lineIt.NextLine() )
     {
-    delete(HistVec[i]);
+    // find the runs of the line
+    runs.clear();
+    const IndexType lineStart = lineIt.GetIndex();
+    const OffsetValueType lineOffset = mask->ComputeOffset( lineStart );
+    if( maskStride == 1 )
+      {
+      // the bits of the line are contiguous: the words without any
+      // change are skipped at once
+      const OffsetValueType lineEnd = lineOffset + lineLength;
+      OffsetValueType runStart = mask->FindNext( lineOffset, lineEnd, true );
+      while( runStart < lineEnd )
+        {
+        const OffsetValueType runStop = mask->FindNext( runStart, lineEnd, false );
+        runs.push_back( std::make_pair( (long)( runStart - lineOffset ), (long)( runStop - runStart ) ) );
+        runStart = mask->FindNext( runStop, lineEnd, true );
+        }
+      }
+    else
+      {
+      long runStart = -1;
+      for( long p=0; p<lineLength; p++ )
+        {
+        if( mask->Test( lineOffset + p * maskStride ) )
+          {
+          if( runStart < 0 )
+            {
+            runStart = p;
+            }
+          }
+        else if( runStart >= 0 )
+          {
+          runs.push_back( std::make_pair( runStart, p - runStart ) );
+          runStart = -1;
+          }
+        }
+      if( runStart >= 0 )
+        {
+        runs.push_back( std::make_pair( runStart, lineLength - runStart ) );
+        }
+      }
+
+    for( typename std::vector< std::pair< long, long > >::const_iterator runIt = runs.begin(); runIt != runs.end(); runIt++ )
+      {
+      IndexType target = lineStart;
+      target[BestDirection] += runIt->first;
+      const long runEnd = target[BestDirection] + runIt->second - 1;
+
+      // move the histogram to the start of the run, or fill it again if
+      // the run is too far
+      unsigned long cost = 0;
+      for( unsigned int axis=0; axis<ImageDimension && filled; axis++ )
+        {
+        const long diff = target[axis] - current[axis];
+        cost += ( diff > 0 ? diff : -diff ) * translationCost[axis][diff > 0];
+        }
+      if( !filled || cost >= this->m_KernelPixelCount )
+        {
+        histogram = emptyHistogram;
+        for( typename OffsetListType::iterator listIt = this->m_KernelOffsets.begin(); 
+            listIt != this->m_KernelOffsets.end(); listIt++ )
+          {
+          IndexType idx = target + (*listIt);
+          if( inputRegion.IsInside( idx ) && mask->Test( mask->ComputeOffset( idx ) ) )
+            {
+            histogram.AddPixel( inputImage->GetPixel(idx) );
+            }
+          else
+            {
+            histogram.AddBoundary();
+            }
+          }
+        current = target;
+        filled = true;
+        }
+
+      // translate the histogram one pixel at a time toward the target,
+      // which is moved along the run once the histogram is on it
+      while( true )
+        {
+        int axis = -1;
+        for( unsigned int a=0; a<ImageDimension; a++ )
+          {
+          if( current[a] != target[a] )
+            {
+            axis = a;
+            break;
+            }
+          }
+        if( axis < 0 )
+          {
+          if( histogram.IsValid() )
+            {
+            if( !writeMask || writeMask->Test( writeMask->ComputeOffset( current ) ) )
+              {
+              outputImage->SetPixel( current,
+                                     static_cast< OutputPixelType >( histogram.GetValue( inputImage->GetPixel(current) ) ) );
+              }
+            if( this->m_GenerateOutputMask )
+              {
+              outputMask->SetPixel( current, m_MaskValue );
+              }
+            }
+          else if( threadOutputMask )
+            {
+            threadOutputMask->Reset( threadOutputMask->ComputeOffset( current ) );
+            }
+          if( target[BestDirection] == runEnd )
+            {
+            break;
+            }
+          target[BestDirection]++;
+          axis = BestDirection;
+          }
+        const int d = target[axis] > current[axis];
+        if( linear && interiorRegion.IsInside( current ) )
+          {
+          OffsetValueType o = inputImage->ComputeOffset( current );
+          pushHistogramLinear( &histogram, addedLinearLists[axis][d], removedLinearLists[axis][d],
+                               inAccessor, inBuffer + o, mask, o );
+          }
+        else
+          {
+          stRegion.SetIndex( current - centerOffset );
+          pushHistogram( &histogram, addedLists[axis][d], removedLists[axis][d], inputRegion, 
+                         stRegion, inputImage, mask, current );
+          }
+        current[axis] += 2 * d - 1;
+        }
+      }
+    progress.CompletedPixel();
     }
-  delete(histogram);
-  delete [] Steps;
 }
 
 
 template<class TInputImage, class TMaskImage, class TOutputImage, class TKernel, class THistogram>
+template<class THist>
 void
 MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel, THistogram>
-::pushHistogram(HistogramType *histogram, 
+::pushHistogram(THist *histogram, 
                 const OffsetListType* addedList,
                 const OffsetListType* removedList,
                 const RegionType &inputRegion,
                 const RegionType &kernRegion,
                 const InputImageType* inputImage,
-                const MaskImageType *maskImage,
+                const PackedMaskType *mask,
                 const IndexType currentIdx)
 {
 
@@ -321,7 +857,7 @@ MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel,
         addedIt != addedList->end(); addedIt++ )
       { 
       typename InputImageType::IndexType idx = currentIdx + (*addedIt);
-      if( maskImage->GetPixel(idx) == m_MaskValue )
+      if( mask->Test( mask->ComputeOffset( idx ) ) )
         {
         histogram->AddPixel( inputImage->GetPixel( idx ) ); 
         }
@@ -334,7 +870,7 @@ MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel,
         removedIt != removedList->end(); removedIt++ )
       { 
       typename InputImageType::IndexType idx = currentIdx + (*removedIt);
-      if( maskImage->GetPixel(idx) == m_MaskValue )
+      if( mask->Test( mask->ComputeOffset( idx ) ) )
         {
         histogram->RemovePixel( inputImage->GetPixel( idx ) ); 
         }
@@ -351,7 +887,7 @@ MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel,
         addedIt != addedList->end(); addedIt++ )
       {
       IndexType idx = currentIdx + (*addedIt);
-      if( inputRegion.IsInside( idx ) && maskImage->GetPixel(idx) == m_MaskValue )
+      if( inputRegion.IsInside( idx ) && mask->Test( mask->ComputeOffset( idx ) ) )
         {
         histogram->AddPixel( inputImage->GetPixel( idx ) ); 
         }
@@ -364,7 +900,7 @@ MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel,
         removedIt != removedList->end(); removedIt++ )
       {
       IndexType idx = currentIdx + (*removedIt);
-      if( inputRegion.IsInside( idx ) && maskImage->GetPixel(idx) == m_MaskValue )
+      if( inputRegion.IsInside( idx ) && mask->Test( mask->ComputeOffset( idx ) ) )
         { 
         histogram->RemovePixel( inputImage->GetPixel( idx ) ); 
         }
@@ -389,6 +925,12 @@ MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel,
   os << indent << "FillValue: "  << static_cast<typename NumericTraits<OutputPixelType>::PrintType>(m_FillValue) << std::endl;
   os << indent << "MaskValue: "  << static_cast<typename NumericTraits<MaskPixelType>::PrintType>(m_MaskValue) << std::endl;
   os << indent << "BackgroundMaskValue: "  << static_cast<typename NumericTraits<MaskPixelType>::PrintType>(m_BackgroundMaskValue) << std::endl;
+  os << indent << "UseMaskRuns: "  << m_UseMaskRuns << std::endl;
+  os << indent << "WriteInsideMask: "  << m_WriteInsideMask << std::endl;
+  os << indent << "ReturnUnion: "  << m_ReturnUnion << std::endl;
+  os << indent << "PackedMask: "  << m_PackedMask << std::endl;
+  os << indent << "GeneratePackedOutputMask: "  << m_GeneratePackedOutputMask << std::endl;
+  os << indent << "PackedWriteMask: "  << m_PackedWriteMask << std::endl;
 }
 
 }// end namespace itk
@@ -0,0 +1,143 @@
+#ifndef __itkMaskedMovingWindowMeanImageFilter_h
+#define __itkMaskedMovingWindowMeanImageFilter_h
+
+#include "itkMaskedMovingHistogramImageFilter.h"
+#include "itkMovingWindowMeanImageFilter.h"
+#include <vector>
+
+namespace itk {
+
+namespace Function {
+
+/** The histogram of MaskedMovingWindowMeanImageFilter: the sum and the
+ * number of the pixels of the mask in the kernel, as in MeanHistogram.
+ * The pixels out of the mask are ignored, and the histogram is only
+ * valid when the kernel contains at least one pixel of the mask. */
+template <class TInputPixel, class TOutputPixel>
+class MaskedMeanHistogram : public MeanHistogram< TInputPixel, TOutputPixel >
+{
+public:
+  inline bool IsValid()
+    {
+    return this->count > 0;
+    }
+};
+
+} // end namespace Function
+
+
+/**
+ * \class MaskedMovingWindowMeanImageFilter
+ * \brief Mean of the pixels of a mask
+ *
+ * Each output pixel is the mean of the input pixels of its kernel which
+ * are in the mask: this is a normalized box filter when the kernel is a
+ * box. The sum and the number of the pixels of the mask are updated
+ * together while the kernel is moved, so the image and the mask are
+ * read once, instead of computing the mean of the product of the image
+ * by the mask and the mean of the mask, and dividing them.
+ *
+ * As in MaskedMovingHistogramImageFilter, the value is written for the
+ * pixels of the mask by default, and can be written for the pixels out
+ * of the mask, or for both, with WriteInsideMask and ReturnUnion. The
+ * pixels without any pixel of the mask in their kernel are set to
+ * FillValue.
+ *
+ * The sums and the divisions are the ones of
+ * MovingWindowMeanImageFilter: they are exact for the integer pixel
+ * types, and the integer outputs are rounded to the nearest value unless
+ * RoundOutput is off.
+ *
+ * \sa SeparableMaskedMeanImageFilter, MovingWindowMeanImageFilter, MaskedRankImageFilter
+ */
+
+template<class TInputImage, class TMaskImage, class TOutputImage, class TKernel >
+class ITK_EXPORT MaskedMovingWindowMeanImageFilter :
+    public MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel, typename Function::MaskedMeanHistogram< typename TInputImage::PixelType, typename TOutputImage::PixelType > >
+{
+public:
+  /** Standard class typedefs. */
+  typedef MaskedMovingWindowMeanImageFilter Self;
+  typedef MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel, typename Function::MaskedMeanHistogram< typename TInputImage::PixelType, typename TOutputImage::PixelType > >  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(MaskedMovingWindowMeanImageFilter,
+               MaskedMovingHistogramImageFilter);
+
+  /** Image related typedefs. */
+  typedef TInputImage InputImageType;
+  typedef TOutputImage OutputImageType;
+  typedef typename TInputImage::RegionType RegionType ;
+  typedef typename TInputImage::SizeType SizeType ;
+  typedef typename TInputImage::IndexType IndexType ;
+  typedef typename TInputImage::PixelType PixelType ;
+  typedef typename TInputImage::OffsetType OffsetType ;
+  typedef typename Superclass::OutputImageRegionType OutputImageRegionType;
+  typedef typename TOutputImage::PixelType OutputPixelType ;
+  typedef typename TInputImage::PixelType InputPixelType ;
+
+  /** Image related typedefs. */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+
+  /** Kernel typedef. */
+  typedef TKernel KernelType;
+
+  /** Kernel (structuring element) iterator. */
+  typedef typename KernelType::ConstIterator KernelIteratorType ;
+
+  /** n-dimensional Kernel radius. */
+  typedef typename KernelType::SizeType RadiusType ;
+
+  /** The type of the sums of the pixels */
+  typedef typename Function::MeanAccumulator< InputPixelType >::Type AccumulateType;
+
+  typedef Function::MeanDivision< InputPixelType, OutputPixelType > DivisionType;
+  typedef typename Superclass::HistogramType HistogramType;
+
+  /** Round the integer output pixels to the nearest value instead of
+   * truncating them. Defaults to true. */
+  itkSetMacro(RoundOutput, bool);
+  itkGetMacro(RoundOutput, bool);
+  itkBooleanMacro(RoundOutput);
+
+protected:
+  MaskedMovingWindowMeanImageFilter();
+  ~MaskedMovingWindowMeanImageFilter() {};
+
+  /** Compute the table of the reciprocals */
+  void BeforeThreadedGenerateData();
+
+  /** Give the division of the filter to the histograms */
+  virtual HistogramType * NewHistogram();
+
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+private:
+  MaskedMovingWindowMeanImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  // the largest number of reciprocals in the table of the division, as
+  // in MovingWindowMeanImageFilter
+  enum { MaximumNumberOfReciprocals = 1 << 16 };
+
+  bool m_RoundOutput;
+
+  std::vector< double > m_Reciprocals;
+
+  DivisionType m_Division;
+
+} ; // end of class
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkMaskedMovingWindowMeanImageFilter.txx"
+#endif
+
+#endif
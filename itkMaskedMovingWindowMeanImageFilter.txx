@@ -0,0 +1,56 @@
+#ifndef __itkMaskedMovingWindowMeanImageFilter_txx
+#define __itkMaskedMovingWindowMeanImageFilter_txx
+
+#include "itkMaskedMovingWindowMeanImageFilter.h"
+#include <algorithm>
+
+namespace itk {
+
+
+template<class TInputImage, class TMaskImage, class TOutputImage, class TKernel>
+MaskedMovingWindowMeanImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel>
+::MaskedMovingWindowMeanImageFilter()
+{
+  m_RoundOutput = true;
+}
+
+
+template<class TInputImage, class TMaskImage, class TOutputImage, class TKernel>
+void
+MaskedMovingWindowMeanImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel>
+::BeforeThreadedGenerateData()
+{
+  Superclass::BeforeThreadedGenerateData();
+
+  // the kernel never contains more pixels of the mask than pixels
+  const unsigned long size = std::min( (unsigned long)this->GetKernelPixelCount() + 1,
+                                       (unsigned long)MaximumNumberOfReciprocals );
+  DivisionType::ComputeReciprocals( m_Reciprocals, size );
+  m_Division.SetReciprocals( m_Reciprocals );
+  m_Division.SetRound( m_RoundOutput );
+}
+
+
+template<class TInputImage, class TMaskImage, class TOutputImage, class TKernel>
+typename MaskedMovingWindowMeanImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel>::HistogramType *
+MaskedMovingWindowMeanImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel>
+::NewHistogram()
+{
+  HistogramType * hist = new HistogramType();
+  hist->SetDivision( m_Division );
+  return hist;
+}
+
+
+template<class TInputImage, class TMaskImage, class TOutputImage, class TKernel>
+void
+MaskedMovingWindowMeanImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "RoundOutput: " << m_RoundOutput << std::endl;
+}
+
+}// end namespace itk
+#endif
@@ -42,6 +42,10 @@ namespace itk {
  * implementation. The extensions to Huang are support for arbitary
  * pixel types (using c++ maps) and arbitary neighborhoods. I presume
  * that these are not new ideas.
+ *
+ * The histogram implementation is chosen at compile time from the
+ * input pixel type (see RankHistogramMaskSelector), so the per pixel
+ * histogram updates are not virtual calls.
  * 
  * This filter is based on the sliding window code from the
  * consolidatedMorphology package on InsightJournal.
@@ -55,12 +59,12 @@ namespace itk {
 
 template<class TInputImage, class TMaskImage, class TOutputImage, class TKernel >
 class ITK_EXPORT MaskedRankImageFilter : 
-    public MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel, RankHistogramMask< typename TInputImage::PixelType > >
+    public MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel, typename RankHistogramMaskSelector< typename TInputImage::PixelType >::Type >
 {
 public:
   /** Standard class typedefs. */
   typedef MaskedRankImageFilter Self;
-  typedef MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel, RankHistogramMask< typename TInputImage::PixelType > >  Superclass;
+  typedef MaskedMovingHistogramImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel, typename RankHistogramMaskSelector< typename TInputImage::PixelType >::Type >  Superclass;
   typedef SmartPointer<Self>        Pointer;
   typedef SmartPointer<const Self>  ConstPointer;
   
@@ -103,24 +107,9 @@ protected:
   MaskedRankImageFilter();
   ~MaskedRankImageFilter() {};
 
-  typedef RankHistogramMask<InputPixelType> HistogramType;
-  
-  typedef RankHistogramMaskVec<InputPixelType, std::less< InputPixelType> > VHistogram;
-  typedef RankHistogramMaskMap<InputPixelType, std::less< InputPixelType>  > MHistogram;
-  
-  void PrintSelf(std::ostream& os, Indent indent) const;
-  
-  bool useVectorBasedHistogram()
-  {
-    // bool, short and char are acceptable for vector based algorithm: they do not require
-    // too much memory. Other types are not usable with that algorithm
-    return typeid(InputPixelType) == typeid(unsigned char)
-      || typeid(InputPixelType) == typeid(signed char)
-//       || typeid(InputPixelType) == typeid(unsigned short)
-//       || typeid(InputPixelType) == typeid(signed short)
-      || typeid(InputPixelType) == typeid(bool);
-  }
+  typedef typename Superclass::HistogramType HistogramType;
 
+  void PrintSelf(std::ostream& os, Indent indent) const;
 
   virtual HistogramType * NewHistogram();
 
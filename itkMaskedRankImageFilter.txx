@@ -47,15 +47,7 @@ typename MaskedRankImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel>::
 MaskedRankImageFilter<TInputImage, TMaskImage, TOutputImage, TKernel>
 ::NewHistogram()
 {
-  HistogramType * hist;
-  if (useVectorBasedHistogram())
-    {
-    hist = new VHistogram();
-    }
-  else
-    {
-    hist = new MHistogram();
-    }
+  HistogramType * hist = new HistogramType();
   hist->SetRank( this->GetRank() );
   return hist;
 }
@@ -18,6 +18,7 @@
 #define __itkMovingHistogramImageFilter_h
 
 #include "itkMovingHistogramImageFilterBase.h"
+#include "itkRebindHistogramCount.h"
 
 //#define zigzag
 
@@ -46,9 +47,11 @@ namespace itk {
  *
  * The histogram type is a class which has to implements seven methods:
  * + a default constructor which takes no parameter.
- * + HistogramType * Clone() must produce a new identical histogram. It is
- * used internally to optimize the filter, by avoiding reverse iteration
- * over the image.
+ * + a copy constructor and an assignment operator producing an identical
+ * histogram. They are used internally to optimize the filter, by avoiding
+ * reverse iteration over the image. The histograms are copied in place at
+ * each line change, so the assignment should reuse the memory already
+ * allocated by the destination histogram.
  * + void AddPixel( const InputPixelType &p ) is called when a new pixel
  * is added to the histogram.
  * + void RemovePixel( const InputPixelType &p ) is called when a pixel
@@ -70,7 +73,9 @@ namespace itk {
  *
  * One histogram is created for each thread by the method NewHistogram().
  * The NewHistogram() method can be overiden to pass some parameters to the
- * histogram.
+ * histogram. If the histogram specializes RebindHistogramCount, the filter
+ * converts it to the version with the narrowest count type able to store
+ * the number of pixels in the kernel.
  * 
  * The neighborhood is defined by a structuring element, and must a
  * itk::Neighborhood object or a subclass.
@@ -132,6 +137,14 @@ public:
 
   typedef typename std::map< OffsetType, OffsetListType, typename Functor::OffsetLexicographicCompare<ImageDimension> > OffsetMapType;
 
+  typedef typename Superclass::OffsetValueType OffsetValueType;
+  typedef typename Superclass::LinearOffsetListType LinearOffsetListType;
+  typedef typename Superclass::InputInternalPixelType InputInternalPixelType;
+  typedef typename Superclass::InputAccessorType InputAccessorType;
+  typedef typename Superclass::OutputInternalPixelType OutputInternalPixelType;
+  typedef typename Superclass::OutputAccessorType OutputAccessorType;
+  typedef typename Superclass::FaceListType FaceListType;
+
 protected:
   MovingHistogramImageFilter();
   ~MovingHistogramImageFilter() {};
@@ -152,7 +165,36 @@ protected:
   // declare the type used to store the histogram
   typedef THistogram HistogramType;
 
-  void pushHistogram(HistogramType * histogram, 
+  /** Run the filter on the region of the thread with a copy of
+   * emptyHistogram. THist is the histogram type given by
+   * RebindHistogramCount for the number of pixels in the kernel. */
+  template <class THist>
+  void ThreadedGenerateDataWithHistogram(const OutputImageRegionType& outputRegionForThread,
+                                         int threadId,
+                                         const THist & emptyHistogram);
+
+  /** Run the moving histogram on the faces computed by ComputeFaces().
+   * The first face is processed without bounds check. HistVec stores
+   * the histograms of each direction, by value. */
+  template <class THist>
+  void ThreadedGenerateDataOnFaces(const FaceListType& faces,
+                                   const THist & emptyHistogram,
+                                   std::vector<THist> & HistVec,
+                                   ProgressReporter & progress);
+
+  /** Run the moving histogram on a region. When interior is true, the
+   * kernel must stay inside the input requested region on the whole
+   * region, and no bounds check is done. The histograms of HistVec are
+   * restarted from emptyHistogram. */
+  template <class THist>
+  void ThreadedGenerateDataOnRegion(const OutputImageRegionType& region,
+                                    bool interior,
+                                    const THist & emptyHistogram,
+                                    std::vector<THist> & HistVec,
+                                    ProgressReporter & progress);
+
+  template <class THist>
+  void pushHistogram(THist * histogram, 
 		     const OffsetListType* addedList,
 		     const OffsetListType* removedList,
 		     const RegionType &inputRegion,
@@ -160,6 +202,22 @@ protected:
 		     const InputImageType* inputImage,
 		     const IndexType currentIdx);
 
+  /** Update the histogram when the kernel is known to be inside the
+   * image: the pixels are read at a constant offset of the current
+   * position in the buffer, without bounds check. */
+  template <class THist>
+  inline void pushHistogramLinear(THist * histogram,
+                                  const LinearOffsetListType* addedList,
+                                  const LinearOffsetListType* removedList,
+                                  const InputAccessorType &accessor,
+                                  const InputInternalPixelType * currentPtr)
+    {
+    for( typename LinearOffsetListType::const_iterator addedIt = addedList->begin(); addedIt != addedList->end(); addedIt++ )
+      { histogram->AddPixel( accessor.Get( currentPtr + (*addedIt) ) ); }
+    for( typename LinearOffsetListType::const_iterator removedIt = removedList->begin(); removedIt != removedList->end(); removedIt++ )
+      { histogram->RemovePixel( accessor.Get( currentPtr + (*removedIt) ) ); }
+    }
+
   void printHist(const HistogramType &H);
 
 #endif
@@ -22,6 +22,7 @@
 #include "itkOffset.h"
 #include "itkProgressReporter.h"
 #include "itkNumericTraits.h"
+#include <algorithm>
 
 #ifndef zigzag
 
@@ -185,28 +186,120 @@ MovingHistogramImageFilter<TInputImage, TOutputImage, TKernel, THistogram>
 ::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
                        int threadId) 
 {
-    
-    // instantiate the histogram
-    HistogramType * histogram = this->NewHistogram();
+  HistogramType * histogram = this->NewHistogram();
+
+  // a bin can't count more pixels than there are in the kernel: use the
+  // narrowest count type able to store that number, to keep the
+  // histograms small
+  const unsigned long kernelCount = this->m_KernelPixelCount;
+  if( kernelCount <= NumericTraits< unsigned short >::max() )
+    {
+    typedef typename RebindHistogramCount< HistogramType, unsigned short >::Type NarrowHistogramType;
+    this->ThreadedGenerateDataWithHistogram( outputRegionForThread, threadId, NarrowHistogramType( *histogram ) );
+    }
+  else if( kernelCount <= NumericTraits< unsigned int >::max() )
+    {
+    typedef typename RebindHistogramCount< HistogramType, unsigned int >::Type NarrowHistogramType;
+    this->ThreadedGenerateDataWithHistogram( outputRegionForThread, threadId, NarrowHistogramType( *histogram ) );
+    }
+  else
+    {
+    this->ThreadedGenerateDataWithHistogram( outputRegionForThread, threadId, *histogram );
+    }
+  delete histogram;
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel, class THistogram>
+template<class THist>
+void
+MovingHistogramImageFilter<TInputImage, TOutputImage, TKernel, THistogram>
+::ThreadedGenerateDataWithHistogram(const OutputImageRegionType& outputRegionForThread,
+                                    int threadId,
+                                    const THist & emptyHistogram) 
+{
+  // the histograms stored for each direction. They are allocated only
+  // once per thread: the traversal then copies the histograms in place.
+  std::vector<THist> HistVec( ImageDimension, emptyHistogram );
+
+  // split the region in the interior block, where the histogram is
+  // updated without any bounds check, and the boundary faces
+  FaceListType faces;
+
+  if( this->m_UseDynamicScheduling )
+    {
+    // the region of the thread is ignored: take the chunks until there
+    // is no more work, so the threads with the cheapest chunks process
+    // more of them
+    ProgressReporter progress(this, threadId, this->m_NumberOfLinesPerThread);
+    OutputImageRegionType chunk;
+    while( this->GetNextChunk( chunk ) )
+      {
+      this->ComputeFaces( chunk, faces );
+      this->ThreadedGenerateDataOnFaces( faces, emptyHistogram, HistVec, progress );
+      }
+    }
+  else
+    {
+    this->ComputeFaces( outputRegionForThread, faces );
+    // Report progress every line instead of every pixel
+    ProgressReporter progress(this, threadId, this->GetNumberOfLines( faces ));
+    this->ThreadedGenerateDataOnFaces( faces, emptyHistogram, HistVec, progress );
+    }
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel, class THistogram>
+template<class THist>
+void
+MovingHistogramImageFilter<TInputImage, TOutputImage, TKernel, THistogram>
+::ThreadedGenerateDataOnFaces(const FaceListType& faces,
+                              const THist & emptyHistogram,
+                              std::vector<THist> & HistVec,
+                              ProgressReporter & progress) 
+{
+  bool interior = true;
+  for( typename FaceListType::const_iterator fit = faces.begin(); fit != faces.end(); fit++ )
+    {
+    if( fit->GetNumberOfPixels() > 0 )
+      {
+      this->ThreadedGenerateDataOnRegion( *fit, interior, emptyHistogram, HistVec, progress );
+      }
+    interior = false;
+    }
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel, class THistogram>
+template<class THist>
+void
+MovingHistogramImageFilter<TInputImage, TOutputImage, TKernel, THistogram>
+::ThreadedGenerateDataOnRegion(const OutputImageRegionType& region,
+                               bool interior,
+                               const THist & emptyHistogram,
+                               std::vector<THist> & HistVec,
+                               ProgressReporter & progress) 
+{
     
     OutputImageType* outputImage = this->GetOutput();
     const InputImageType* inputImage = this->GetInput();
     RegionType inputRegion = inputImage->GetRequestedRegion();
     
     // initialize the histogram
+    THist & histogram = HistVec[0];
+    histogram = emptyHistogram;
     for( typename OffsetListType::iterator listIt = this->m_KernelOffsets.begin(); listIt != this->m_KernelOffsets.end(); listIt++ )
       {
-      IndexType idx = outputRegionForThread.GetIndex() + (*listIt);
+      IndexType idx = region.GetIndex() + (*listIt);
       if( inputRegion.IsInside( idx ) )
-        { histogram->AddPixel( inputImage->GetPixel(idx) ); }
+        { histogram.AddPixel( inputImage->GetPixel(idx) ); }
       else
-        { histogram->AddBoundary(); }
+        { histogram.AddBoundary(); }
       }
 
     // now move the histogram
     itk::FixedArray<short, ImageDimension> direction;
     direction.Fill(1);
-    IndexType currentIdx = outputRegionForThread.GetIndex();
     int axis = ImageDimension - 1;
     OffsetType offset;
     offset.Fill( 0 );
@@ -221,57 +314,72 @@ MovingHistogramImageFilter<TInputImage, TOutputImage, TKernel, THistogram>
     int BestDirection = this->m_Axes[axis];
     int LineLength = inputRegion.GetSize()[BestDirection];
 
-    // Report progress every line instead of every pixel
-    ProgressReporter progress(this, threadId, outputRegionForThread.GetNumberOfPixels()/outputRegionForThread.GetSize()[BestDirection]);
     // init the offset and get the lists for the best axis
     offset[BestDirection] = direction[BestDirection];
     // it's very important for performances to get a pointer and not a copy
     const OffsetListType* addedList = &this->m_AddedOffsets[offset];;
     const OffsetListType* removedList = &this->m_RemovedOffsets[offset];
+    const LinearOffsetListType* addedLinearList = &this->m_AddedLinearOffsets[offset];
+    const LinearOffsetListType* removedLinearList = &this->m_RemovedLinearOffsets[offset];
+
+    // the pixels are read and written directly in the buffers, through
+    // the neighborhood accessors so the VectorImage is supported too
+    InputAccessorType inAccessor = inputImage->GetNeighborhoodAccessor();
+    const InputInternalPixelType * inBuffer = inputImage->GetBufferPointer();
+    inAccessor.SetBegin( inBuffer );
+    OutputAccessorType outAccessor = outputImage->GetNeighborhoodAccessor();
+    OutputInternalPixelType * outBuffer = outputImage->GetBufferPointer();
+    outAccessor.SetBegin( outBuffer );
+    const OffsetValueType inStride = inputImage->GetOffsetTable()[BestDirection];
+    const OffsetValueType outStride = outputImage->GetOffsetTable()[BestDirection];
+    const long lineLength = region.GetSize()[BestDirection];
 
     typedef typename itk::ImageLinearConstIteratorWithIndex<InputImageType> InputLineIteratorType;
-    InputLineIteratorType InLineIt(inputImage, outputRegionForThread);
+    InputLineIteratorType InLineIt(inputImage, region);
     InLineIt.SetDirection(BestDirection);
     
-    typedef typename itk::ImageRegionIterator<OutputImageType> OutputIteratorType;
-    //OutputIteratorType oit(outputImage, outputRegionForThread);
     InLineIt.GoToBegin();
     IndexType LineStart;
-    //PrevLineStart = InLineIt.GetIndex();
-    InLineIt.GoToBegin();
-
-    typedef typename std::vector<HistogramType *> HistVecType;
-    HistVecType HistVec(ImageDimension);
-    typedef typename std::vector<IndexType> IndexVecType;
-    IndexVecType PrevLineStartVec(ImageDimension);
 
-    // Steps is used to keep track of the order in which the line
-    // iterator passes over the various dimensions.
-    int *Steps = new int[ImageDimension];
 
     for (unsigned int i=0;i<ImageDimension;i++)
       {
-      HistVec[i] = histogram->Clone();
-      PrevLineStartVec[i] = InLineIt.GetIndex();
-      Steps[i]=0;
+      if (i > 0)
+        {
+        HistVec[i] = histogram;
+        }
       }
 
     while(!InLineIt.IsAtEnd())
       {
-      HistogramType *histRef = HistVec[BestDirection];
+      THist *histRef = &HistVec[BestDirection];
       IndexType PrevLineStart = InLineIt.GetIndex();
-      for (InLineIt.GoToBeginOfLine(); !InLineIt.IsAtEndOfLine(); ++InLineIt)
-	{
-	
-	// Update the historgram
-	IndexType currentIdx = InLineIt.GetIndex();
-	outputImage->SetPixel(currentIdx, static_cast< OutputPixelType >( histRef->GetValue( inputImage->GetPixel( currentIdx ) ) ));
-	stRegion.SetIndex( currentIdx - centerOffset );
-	pushHistogram(histRef, addedList, removedList, inputRegion, 
-		      stRegion, inputImage, currentIdx);
 
-	}
-      Steps[BestDirection] += LineLength;
+      const InputInternalPixelType * inPtr = inBuffer + inputImage->ComputeOffset( PrevLineStart );
+      OutputInternalPixelType * outPtr = outBuffer + outputImage->ComputeOffset( PrevLineStart );
+      if( interior )
+        {
+        // the kernel is always inside the image: no bounds check, no
+        // index computation
+        for( long p=0; p<lineLength; p++, inPtr += inStride, outPtr += outStride )
+          {
+          outAccessor.Set( outPtr, static_cast< OutputPixelType >( histRef->GetValue( inAccessor.Get( inPtr ) ) ) );
+          pushHistogramLinear( histRef, addedLinearList, removedLinearList, inAccessor, inPtr );
+          }
+        }
+      else
+        {
+        IndexType currentIdx = PrevLineStart;
+        for( long p=0; p<lineLength; p++, inPtr += inStride, outPtr += outStride )
+          {
+          outAccessor.Set( outPtr, static_cast< OutputPixelType >( histRef->GetValue( inAccessor.Get( inPtr ) ) ) );
+          stRegion.SetIndex( currentIdx - centerOffset );
+          pushHistogram(histRef, addedList, removedList, inputRegion, 
+                        stRegion, inputImage, currentIdx);
+          currentIdx[BestDirection]++;
+          }
+        }
+
       InLineIt.NextLine();
       if (InLineIt.IsAtEnd())
 	{
@@ -288,45 +396,51 @@ MovingHistogramImageFilter<TInputImage, TOutputImage, TKernel, THistogram>
       // which direction
       int LineDirection=0;
       // This function deals with changing planes etc
-      GetDirAndOffset(LineStart, PrevLineStart, ImageDimension,
+      this->GetDirAndOffset(LineStart, PrevLineStart, ImageDimension,
 		      LineOffset, Changes, LineDirection);
-      ++(Steps[LineDirection]);
       IndexType PrevLineStartHist = LineStart - LineOffset;
-      const OffsetListType* addedListLine = &this->m_AddedOffsets[LineOffset];;
-      const OffsetListType* removedListLine = &this->m_RemovedOffsets[LineOffset];
-      HistogramType *tmpHist = HistVec[LineDirection];
-      stRegion.SetIndex(PrevLineStart - centerOffset);
+      THist *tmpHist = &HistVec[LineDirection];
       // Now move the histogram
-      pushHistogram(tmpHist, addedListLine, removedListLine, inputRegion, 
-		    stRegion, inputImage, PrevLineStartHist);
+      if( interior )
+        {
+        pushHistogramLinear( tmpHist, &this->m_AddedLinearOffsets[LineOffset],
+                             &this->m_RemovedLinearOffsets[LineOffset], inAccessor,
+                             inBuffer + inputImage->ComputeOffset( PrevLineStartHist ) );
+        }
+      else
+        {
+        stRegion.SetIndex(PrevLineStartHist - centerOffset);
+        pushHistogram(tmpHist, &this->m_AddedOffsets[LineOffset],
+                      &this->m_RemovedOffsets[LineOffset], inputRegion, 
+                      stRegion, inputImage, PrevLineStartHist);
+        }
 
-      //PrevLineStartVec[LineDirection] = LineStart;
       // copy the updated histogram and line start entries to the
       // relevant directions. When updating direction 2, for example,
-      // new copies of directions 0 and 1 should be made.
+      // new copies of directions 0 and 1 should be made. The line
+      // iterator moves along the axes in increasing order, so these are
+      // the axes below LineDirection, and the best direction. The copies
+      // are made in place, in the storage of the old histograms, so no
+      // memory is allocated once the histograms have reached their
+      // working size.
       for (unsigned int i=0;i<ImageDimension;i++) 
 	{
-	if (Steps[i] > Steps[LineDirection])
+	if (i != (unsigned)LineDirection && (i == (unsigned)BestDirection || i < (unsigned)LineDirection))
 	  {
-	  //PrevLineStartVec[i] = LineStart;
-	  delete(HistVec[i]);
-	  HistVec[i] = HistVec[LineDirection]->Clone();
+	  HistVec[i] = HistVec[LineDirection];
 	  }
 	}
       progress.CompletedPixel();
       }
-  for (unsigned i=0;i<ImageDimension;i++) 
-    {
-    delete(HistVec[i]);
-    }
-  delete [] Steps;
-  delete histogram;
+  // the last line of the region
+  progress.CompletedPixel();
 }
 
 template<class TInputImage, class TOutputImage, class TKernel, class THistogram>
+template<class THist>
 void
 MovingHistogramImageFilter<TInputImage, TOutputImage, TKernel, THistogram>
-::pushHistogram(HistogramType * histogram, 
+::pushHistogram(THist * histogram, 
 		const OffsetListType* addedList,
 		const OffsetListType* removedList,
 		const RegionType &inputRegion,
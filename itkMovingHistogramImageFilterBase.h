@@ -18,9 +18,12 @@
 #define __itkMovingHistogramImageFilterBase_h
 
 #include "itkKernelImageFilter.h"
+#include "itkProgressReporter.h"
+#include "itkSimpleFastMutexLock.h"
 #include <list>
 #include <map>
 #include <set>
+#include <vector>
 #include "itkOffsetLexicographicCompare.h"
 
 namespace itk {
@@ -48,9 +51,11 @@ namespace itk {
  *
  * The histogram type is a class which has to implements seven methods:
  * + a default constructor which takes no parameter.
- * + HistogramType * Clone() must produce a new identical histogram. It is
- * used internally to optimize the filter, by avoiding reverse iteration
- * over the image.
+ * + a copy constructor and an assignment operator producing an identical
+ * histogram. They are used internally to optimize the filter, by avoiding
+ * reverse iteration over the image. The histograms are copied in place at
+ * each line change, so the assignment should reuse the memory already
+ * allocated by the destination histogram.
  * + void AddPixel( const InputPixelType &p ) is called when a new pixel
  * is added to the histogram.
  * + void RemovePixel( const InputPixelType &p ) is called when a pixel
@@ -73,6 +78,15 @@ namespace itk {
  * One histogram is created for each thread by the method NewHistogram().
  * The NewHistogram() method can be overiden to pass some parameters to the
  * histogram.
+ *
+ * By default, each thread processes the slab of the output image given by
+ * SplitRequestedRegion(). When the cost of the pixels depends on the image
+ * content, as with a mask, some threads can finish a lot earlier than the
+ * others. With UseDynamicScheduling turned on, the output is instead cut
+ * in chunks of about NumberOfLinesPerChunk lines, and each thread takes a
+ * new chunk as soon as it has finished the previous one. The histogram
+ * is initialized again at the start of each chunk, so the chunks should
+ * not be too small compared to the kernel.
  * 
  * The neighborhood is defined by a structuring element, and must a
  * itk::Neighborhood object or a subclass.
@@ -134,15 +148,73 @@ public:
 
   typedef typename std::map< OffsetType, OffsetListType, typename Functor::OffsetLexicographicCompare<ImageDimension> > OffsetMapType;
 
+  /** The offsets in the input buffer, as a number of pixels */
+  typedef typename OffsetType::OffsetValueType OffsetValueType;
+  typedef typename std::vector< OffsetValueType > LinearOffsetListType;
+  typedef typename std::map< OffsetType, LinearOffsetListType, typename Functor::OffsetLexicographicCompare<ImageDimension> > LinearOffsetMapType;
+
+  /** Types used to access the image buffers. The neighborhood accessors
+   * are used because they work with the pixels of the Image and of the
+   * VectorImage */
+  typedef typename TInputImage::InternalPixelType InputInternalPixelType;
+  typedef typename TInputImage::NeighborhoodAccessorFunctorType InputAccessorType;
+  typedef typename TOutputImage::InternalPixelType OutputInternalPixelType;
+  typedef typename TOutputImage::NeighborhoodAccessorFunctorType OutputAccessorType;
+
+  typedef typename std::list< OutputImageRegionType > FaceListType;
+
   /** Set kernel (structuring element). */
   void SetKernel( const KernelType& kernel );
 
   itkGetMacro(PixelsPerTranslation, unsigned long);
+
+  /** The number of pixels in the kernel. It is the largest count which
+   * can be found in a bin of the histogram. */
+  itkGetMacro(KernelPixelCount, unsigned long);
+
+  /** Let the threads take chunks of lines of the output as long as
+   * there is some left, instead of processing a fixed slab of the
+   * output. Defaults to false. */
+  itkSetMacro(UseDynamicScheduling, bool);
+  itkGetConstMacro(UseDynamicScheduling, bool);
+  itkBooleanMacro(UseDynamicScheduling);
+
+  /** The approximate number of lines in a chunk, when
+   * UseDynamicScheduling is on. The chunks are made of whole planes
+   * orthogonal to the slowest axis which is not the line direction,
+   * so a chunk may contain more lines than requested. Defaults to 64. */
+  itkSetMacro(NumberOfLinesPerChunk, unsigned long);
+  itkGetConstMacro(NumberOfLinesPerChunk, unsigned long);
   
 protected:
   MovingHistogramImageFilterBase();
   ~MovingHistogramImageFilterBase() {};
+
+  void PrintSelf(std::ostream& os, Indent indent) const;
   
+  /** Compute the linear offsets of the added and removed pixels in the
+   * input buffer, and cut the output in chunks when UseDynamicScheduling
+   * is on */
+  void BeforeThreadedGenerateData();
+
+  /** Get the next chunk of the output to process. Return false when all
+   * the chunks have already been taken. This method can be called by
+   * several threads at the same time. */
+  bool GetNextChunk( OutputImageRegionType & chunk );
+
+  /** Split the region in the block where the kernel, padded by one pixel
+   * for the translation, stays inside the input requested region, and
+   * the boundary faces around it, in the same way as
+   * ImageBoundaryFacesCalculator. The interior block is the first region
+   * of the list, and may be empty. The face calculator itself can't be
+   * used: it works on the buffered region of the input, not on the
+   * requested one. */
+  void ComputeFaces( const OutputImageRegionType & region, FaceListType & faces ) const;
+
+  /** The number of lines in the traversal of the faces, used to report
+   * the progress */
+  unsigned long GetNumberOfLines( const FaceListType & faces ) const;
+
   void GetDirAndOffset(const IndexType LineStart, 
                       const IndexType PrevLineStart,
                       const int ImageDimension,
@@ -154,6 +226,11 @@ protected:
   OffsetMapType m_AddedOffsets;
   OffsetMapType m_RemovedOffsets;
 
+  // the same offsets, in the buffer of the current input. They are only
+  // valid during the execution of the filter.
+  LinearOffsetMapType m_AddedLinearOffsets;
+  LinearOffsetMapType m_RemovedLinearOffsets;
+
   // store the offset of the kernel to initialize the histogram
   OffsetListType m_KernelOffsets;
 
@@ -161,6 +238,20 @@ protected:
 
   unsigned long m_PixelsPerTranslation;
 
+  unsigned long m_KernelPixelCount;
+
+  bool m_UseDynamicScheduling;
+  unsigned long m_NumberOfLinesPerChunk;
+
+  // the chunks not yet processed are the ones after m_NextChunk. They
+  // are only valid during the execution of the filter.
+  std::vector< OutputImageRegionType > m_Chunks;
+  unsigned long m_NextChunk;
+  SimpleFastMutexLock m_ChunkLock;
+
+  // the number of lines expected to be processed by a thread with the
+  // dynamic scheduling, used to report the progress
+  unsigned long m_NumberOfLinesPerThread;
 
 private:
   MovingHistogramImageFilterBase(const Self&); //purposely not implemented
@@ -22,6 +22,7 @@
 #include "itkOffset.h"
 #include "itkProgressReporter.h"
 #include "itkNumericTraits.h"
+#include <algorithm>
 
 #ifndef zigzag
 
@@ -39,6 +40,11 @@ MovingHistogramImageFilterBase<TInputImage, TOutputImage, TKernel>
 ::MovingHistogramImageFilterBase()
 {
   m_PixelsPerTranslation = 0;
+  m_KernelPixelCount = 0;
+  m_UseDynamicScheduling = false;
+  m_NumberOfLinesPerChunk = 64;
+  m_NextChunk = 0;
+  m_NumberOfLinesPerThread = 0;
 }
 
 
@@ -101,6 +107,7 @@ MovingHistogramImageFilterBase<TInputImage, TOutputImage, TKernel>
 
   // store the kernel offset list
   m_KernelOffsets = kernelOffsets;
+  m_KernelPixelCount = count;
 
   typename itk::FixedArray< unsigned long, ImageDimension > axisCount;
   axisCount.Fill( 0 );
@@ -172,6 +179,170 @@ MovingHistogramImageFilterBase<TInputImage, TOutputImage, TKernel>
 }
 
 
+template<class TInputImage, class TOutputImage, class TKernel>
+void
+MovingHistogramImageFilterBase<TInputImage, TOutputImage, TKernel>
+::BeforeThreadedGenerateData()
+{
+  // the buffered region of the input is known only now, so the
+  // offsets can't be converted in SetKernel()
+  const OffsetValueType * offsetTable = this->GetInput()->GetOffsetTable();
+
+  const OffsetMapType * maps[2] = { &m_AddedOffsets, &m_RemovedOffsets };
+  LinearOffsetMapType * linearMaps[2] = { &m_AddedLinearOffsets, &m_RemovedLinearOffsets };
+  for( unsigned int m=0; m<2; m++ )
+    {
+    linearMaps[m]->clear();
+    for( typename OffsetMapType::const_iterator mapIt = maps[m]->begin(); mapIt != maps[m]->end(); mapIt++ )
+      {
+      LinearOffsetListType & linear = (*linearMaps[m])[mapIt->first];
+      linear.reserve( mapIt->second.size() );
+      for( typename OffsetListType::const_iterator listIt = mapIt->second.begin(); listIt != mapIt->second.end(); listIt++ )
+        {
+        OffsetValueType l = 0;
+        for( unsigned int axis=0; axis<ImageDimension; axis++ )
+          {
+          l += (*listIt)[axis] * offsetTable[axis];
+          }
+        linear.push_back( l );
+        }
+      }
+    }
+
+  // cut the output in chunks for the dynamic scheduling
+  m_Chunks.clear();
+  m_NextChunk = 0;
+  m_NumberOfLinesPerThread = 0;
+  const OutputImageRegionType & region = this->GetOutput()->GetRequestedRegion();
+  if( !m_UseDynamicScheduling || region.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+
+  // the chunks are cut along the slowest axis which is not the line
+  // direction, so the histogram is moved along whole lines
+  int BestDirection = m_Axes[ImageDimension - 1];
+  int splitAxis = ImageDimension - 1;
+  if( splitAxis == BestDirection )
+    {
+    splitAxis--;
+    }
+  if( splitAxis < 0 )
+    {
+    m_Chunks.push_back( region );
+    }
+  else
+    {
+    unsigned long planeSize = region.GetSize()[splitAxis];
+    unsigned long linesPerPlane = region.GetNumberOfPixels() / ( region.GetSize()[BestDirection] * planeSize );
+    unsigned long planesPerChunk = std::max( 1UL, m_NumberOfLinesPerChunk / linesPerPlane );
+    for( unsigned long p=0; p<planeSize; p+=planesPerChunk )
+      {
+      IndexType idx = region.GetIndex();
+      SizeType size = region.GetSize();
+      idx[splitAxis] += p;
+      size[splitAxis] = std::min( planesPerChunk, planeSize - p );
+      m_Chunks.push_back( OutputImageRegionType( idx, size ) );
+      }
+    }
+
+  // only the first thread reports the progress: estimate the part of
+  // the work it will do
+  unsigned long nbOfLines = 0;
+  FaceListType faces;
+  for( typename std::vector< OutputImageRegionType >::const_iterator it = m_Chunks.begin(); it != m_Chunks.end(); it++ )
+    {
+    this->ComputeFaces( *it, faces );
+    nbOfLines += this->GetNumberOfLines( faces );
+    }
+  OutputImageRegionType splitRegion;
+  int nbOfThreads = this->SplitRequestedRegion( 0, this->GetNumberOfThreads(), splitRegion );
+  m_NumberOfLinesPerThread = nbOfLines / std::max( 1, nbOfThreads );
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+bool
+MovingHistogramImageFilterBase<TInputImage, TOutputImage, TKernel>
+::GetNextChunk( OutputImageRegionType & chunk )
+{
+  bool found = false;
+  m_ChunkLock.Lock();
+  if( m_NextChunk < m_Chunks.size() )
+    {
+    chunk = m_Chunks[m_NextChunk];
+    m_NextChunk++;
+    found = true;
+    }
+  m_ChunkLock.Unlock();
+  return found;
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+void
+MovingHistogramImageFilterBase<TInputImage, TOutputImage, TKernel>
+::ComputeFaces( const OutputImageRegionType & region, FaceListType & faces ) const
+{
+  const RegionType & inputRegion = this->GetInput()->GetRequestedRegion();
+  RegionType stRegion;
+  stRegion.SetSize( this->m_Kernel.GetSize() );
+  stRegion.PadByRadius( 1 );
+
+  faces.clear();
+  OutputImageRegionType interior = region;
+  for( unsigned int axis=0; axis<ImageDimension; axis++ )
+    {
+    // the positions where the padded kernel is inside on that axis
+    long low = stRegion.GetSize()[axis] / 2;
+    long high = stRegion.GetSize()[axis] - 1 - low;
+    long start = interior.GetIndex()[axis];
+    long end = start + (long)interior.GetSize()[axis];
+    long interiorStart = std::max( start, std::min( end,
+      inputRegion.GetIndex()[axis] + low ) );
+    long interiorEnd = std::max( interiorStart, std::min( end,
+      inputRegion.GetIndex()[axis] + (long)inputRegion.GetSize()[axis] - high ) );
+
+    IndexType idx = interior.GetIndex();
+    SizeType size = interior.GetSize();
+    if( interiorStart > start )
+      {
+      size[axis] = interiorStart - start;
+      faces.push_back( OutputImageRegionType( idx, size ) );
+      }
+    if( interiorEnd < end )
+      {
+      idx[axis] = interiorEnd;
+      size[axis] = end - interiorEnd;
+      faces.push_back( OutputImageRegionType( idx, size ) );
+      }
+    idx[axis] = interiorStart;
+    size[axis] = interiorEnd - interiorStart;
+    interior.SetIndex( idx );
+    interior.SetSize( size );
+    }
+  faces.push_front( interior );
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+unsigned long
+MovingHistogramImageFilterBase<TInputImage, TOutputImage, TKernel>
+::GetNumberOfLines( const FaceListType & faces ) const
+{
+  int BestDirection = m_Axes[ImageDimension - 1];
+  unsigned long nbOfLines = 0;
+  for( typename FaceListType::const_iterator fit = faces.begin(); fit != faces.end(); fit++ )
+    {
+    if( fit->GetNumberOfPixels() > 0 )
+      {
+      nbOfLines += fit->GetNumberOfPixels() / fit->GetSize()[BestDirection];
+      }
+    }
+  return nbOfLines;
+}
+
+
 template<class TInputImage, class TOutputImage, class TKernel>
 void
 MovingHistogramImageFilterBase<TInputImage, TOutputImage, TKernel>
@@ -200,5 +371,19 @@ MovingHistogramImageFilterBase<TInputImage, TOutputImage, TKernel>
     }
 }
 
+
+template<class TInputImage, class TOutputImage, class TKernel>
+void
+MovingHistogramImageFilterBase<TInputImage, TOutputImage, TKernel>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "PixelsPerTranslation: " << m_PixelsPerTranslation << std::endl;
+  os << indent << "KernelPixelCount: " << m_KernelPixelCount << std::endl;
+  os << indent << "UseDynamicScheduling: " << m_UseDynamicScheduling << std::endl;
+  os << indent << "NumberOfLinesPerChunk: " << m_NumberOfLinesPerChunk << std::endl;
+}
+
 }// end namespace itk
 #endif
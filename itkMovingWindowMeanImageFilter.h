@@ -18,14 +18,160 @@
 #define __itkMovingWindowMeanImageFilter_h
 
 #include "itkMovingHistogramImageFilter.h"
+#include "itkNumericTraits.h"
+#include <vector>
+#include <cmath>
+#include <cassert>
 
 namespace itk {
 
 namespace Function {
+
+/** The type used to sum the pixels in the mean filters: a 64 bit
+ * integer for the integer pixel types up to 32 bits, where the sums are
+ * then exact, and double for the other ones. */
+template <class TInputPixel, bool VExactInteger = ( NumericTraits< TInputPixel >::is_integer && sizeof( TInputPixel ) <= 4 ) >
+class MeanAccumulator
+{
+public:
+  typedef double Type;
+  enum { IsInteger = 0 };
+};
+
 template <class TInputPixel>
+class MeanAccumulator< TInputPixel, true >
+{
+public:
+  typedef long long Type;
+  enum { IsInteger = 1 };
+};
+
+/** Convert the mean of the pixels to the output type. This version is
+ * used for the real output types: the sum is multiplied by the
+ * reciprocal of the number of pixels. */
+template <class TInputPixel, class TOutputPixel, bool VIntegerOutput = NumericTraits< TOutputPixel >::is_integer >
+class MeanRounding
+{
+public:
+  typedef typename MeanAccumulator< TInputPixel >::Type AccumulateType;
+
+  static inline TOutputPixel Divide( const AccumulateType & sum, unsigned long, double reciprocal, bool )
+    {
+    return static_cast< TOutputPixel >( static_cast< double >( sum ) * reciprocal );
+    }
+};
+
+/** The integer output types. The product of the sum by the reciprocal
+ * can be slightly lower than an integer quotient, so it is corrected
+ * with the remainder of the division. With round, the mean is rounded to
+ * the nearest value, the halves away from zero. Otherwise it is
+ * truncated toward zero, as with a static_cast. The result is exact for
+ * the integer sums. */
+template <class TInputPixel, class TOutputPixel>
+class MeanRounding< TInputPixel, TOutputPixel, true >
+{
+public:
+  typedef typename MeanAccumulator< TInputPixel >::Type AccumulateType;
+
+  static inline TOutputPixel Divide( const AccumulateType & sum, unsigned long count, double reciprocal, bool round )
+    {
+    // work on the magnitude, so the quotient is truncated toward zero
+    const bool negative = sum < 0;
+    AccumulateType s = negative ? -sum : sum;
+    AccumulateType c = static_cast< AccumulateType >( count );
+    if( round )
+      {
+      // floor( s / c + 1/2 ) is floor( ( 2s + c ) / 2c )
+      s = 2 * s + c;
+      c = 2 * c;
+      reciprocal *= 0.5;
+      }
+    // the product is less than one unit away from the quotient for the
+    // sums lower than 2^52
+    AccumulateType q = static_cast< AccumulateType >( std::floor( static_cast< double >( s ) * reciprocal ) );
+    const AccumulateType rest = s - q * c;
+    if( rest < 0 )
+      {
+      q -= 1;
+      }
+    else if( rest >= c )
+      {
+      q += 1;
+      }
+    return static_cast< TOutputPixel >( negative ? -q : q );
+    }
+};
+
+/** The division of the sum of the pixels of a neighborhood by their
+ * number. The reciprocals of the numbers of pixels are read in a table,
+ * computed once by the filter and shared by its threads, so there is no
+ * floating point division per pixel. The numbers of pixels out of the
+ * table are still divided. */
+template <class TInputPixel, class TOutputPixel>
+class MeanDivision
+{
+public:
+  typedef typename MeanAccumulator< TInputPixel >::Type AccumulateType;
+
+  MeanDivision()
+    {
+    m_Reciprocals = 0;
+    m_NumberOfReciprocals = 0;
+    m_Round = true;
+    }
+
+  /** The table is not copied: it must live as long as the division is
+   * used */
+  void SetReciprocals( const std::vector< double > & reciprocals )
+    {
+    m_NumberOfReciprocals = reciprocals.size();
+    m_Reciprocals = m_NumberOfReciprocals > 0 ? &reciprocals[0] : 0;
+    }
+
+  void SetRound( bool round )
+    {
+    m_Round = round;
+    }
+
+  bool GetRound() const
+    {
+    return m_Round;
+    }
+
+  inline TOutputPixel operator()( const AccumulateType & sum, unsigned long count ) const
+    {
+    const double reciprocal = count < m_NumberOfReciprocals ? m_Reciprocals[count] : 1.0 / static_cast< double >( count );
+    return MeanRounding< TInputPixel, TOutputPixel >::Divide( sum, count, reciprocal, m_Round );
+    }
+
+  /** Fill the table with the reciprocals of the numbers of pixels lower
+   * than size */
+  static void ComputeReciprocals( std::vector< double > & reciprocals, unsigned long size )
+    {
+    reciprocals.resize( size );
+    for( unsigned long c=1; c<size; c++ )
+      {
+      reciprocals[c] = 1.0 / static_cast< double >( c );
+      }
+    if( size > 0 )
+      {
+      reciprocals[0] = 0;
+      }
+    }
+
+private:
+  const double * m_Reciprocals;
+  unsigned long m_NumberOfReciprocals;
+  bool m_Round;
+};
+
+template <class TInputPixel, class TOutputPixel>
 class MeanHistogram
 {
 public:
+  typedef typename MeanAccumulator< TInputPixel >::Type AccumulateType;
+  typedef MeanDivision< TInputPixel, TOutputPixel > DivisionType;
+
   MeanHistogram()
     {
     sum = 0;
@@ -33,26 +179,31 @@ public:
     }
   ~MeanHistogram(){}
 
+  void SetDivision( const DivisionType & d )
+    {
+    division = d;
+    }
+
   inline void AddBoundary() {}
 
   inline void RemoveBoundary() {}
 
   inline void AddPixel( const TInputPixel &p )
     {
-    sum += p;
+    sum += static_cast< AccumulateType >( p );
     count++;
     }
 
   inline void RemovePixel( const TInputPixel &p )
     {
-    sum -= p;
+    assert( count > 0 );
+    sum -= static_cast< AccumulateType >( p );
     count--;
-    assert( count >= 0 );
     }
 
-  inline double GetValue( const TInputPixel & )
+  inline TOutputPixel GetValue( const TInputPixel & )
     {
-    return sum / static_cast< double >( count );
+    return division( sum, count );
     }
 
   inline MeanHistogram * Clone()
@@ -60,13 +211,16 @@ public:
     MeanHistogram * result = new MeanHistogram();
     result->sum = this->sum;
     result->count = this->count;
+    result->division = this->division;
     return result;
     }
 
-  double sum;
+  AccumulateType sum;
   unsigned long count;
+  DivisionType division;
 
 };
+
 } // end namespace Function
 
 
@@ -84,16 +238,32 @@ public:
  * This filter employs a recursive implementation based on the sliding
  * window code from consolidatedMorphology, and is therefore usually a
  * lot faster than the direct implementation.
+ *
+ * With a box kernel, the moving window still has to read all the pixels
+ * of the faces of the box at each step. By default, the box kernels use
+ * a summed area table instead: the table of the sums of the pixels
+ * before each position is built for a tile of the output, padded by the
+ * radius, and the sum in a box is then computed with 2^d values of the
+ * table, whatever the radius.
+ *
+ * The integer pixels are summed with a 64 bit integer (see
+ * Function::MeanAccumulator), and the sums are divided with a table of
+ * the reciprocals of the numbers of pixels (see Function::MeanDivision),
+ * with an exact result for the integer output types. The result is then
+ * the same for the moving window and the summed area table, whatever the
+ * number of threads. The integer outputs are rounded to the nearest
+ * value by default: RoundOutputOff() truncates them toward zero, as a
+ * static_cast of the mean.
  */
 
 template<class TInputImage, class TOutputImage, class TKernel >
 class ITK_EXPORT MovingWindowMeanImageFilter : 
-    public MovingHistogramImageFilter<TInputImage, TOutputImage, TKernel, typename  Function::MeanHistogram< typename TInputImage::PixelType > >
+    public MovingHistogramImageFilter<TInputImage, TOutputImage, TKernel, typename  Function::MeanHistogram< typename TInputImage::PixelType, typename TOutputImage::PixelType > >
 {
 public:
   /** Standard class typedefs. */
   typedef MovingWindowMeanImageFilter Self;
-  typedef MovingHistogramImageFilter<TInputImage,TOutputImage, TKernel, typename  Function::MeanHistogram< typename TInputImage::PixelType > >  Superclass;
+  typedef MovingHistogramImageFilter<TInputImage,TOutputImage, TKernel, typename  Function::MeanHistogram< typename TInputImage::PixelType, typename TOutputImage::PixelType > >  Superclass;
   typedef SmartPointer<Self>        Pointer;
   typedef SmartPointer<const Self>  ConstPointer;
   
@@ -129,18 +299,92 @@ public:
   /** n-dimensional Kernel radius. */
   typedef typename KernelType::SizeType RadiusType ;
 
+  /** The type of the sums of the pixels */
+  typedef typename Function::MeanAccumulator< InputPixelType >::Type AccumulateType;
+
+  typedef Function::MeanDivision< InputPixelType, OutputPixelType > DivisionType;
+  typedef typename Superclass::HistogramType HistogramType;
+
+  /** Use a summed area table instead of the moving window when the
+   * kernel is a box. Defaults to true. */
+  itkSetMacro(UseSummedAreaTable, bool);
+  itkGetMacro(UseSummedAreaTable, bool);
+  itkBooleanMacro(UseSummedAreaTable);
+
+  /** Round the integer output pixels to the nearest value instead of
+   * truncating them. Defaults to true. */
+  itkSetMacro(RoundOutput, bool);
+  itkGetMacro(RoundOutput, bool);
+  itkBooleanMacro(RoundOutput);
+
 protected:
-  MovingWindowMeanImageFilter() {};
+  MovingWindowMeanImageFilter();
   ~MovingWindowMeanImageFilter() {};
 
+  /** Choose between the moving window and the summed area table, and
+   * compute the table of the reciprocals */
+  void BeforeThreadedGenerateData();
+
+  /** Give the division of the filter to the histograms */
+  virtual HistogramType * NewHistogram();
+
+  void ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+                            int threadId);
+
+  typedef typename Superclass::OffsetValueType OffsetValueType;
+  typedef typename Superclass::InputInternalPixelType InputInternalPixelType;
+  typedef typename Superclass::InputAccessorType InputAccessorType;
+  typedef typename Superclass::OutputInternalPixelType OutputInternalPixelType;
+  typedef typename Superclass::OutputAccessorType OutputAccessorType;
+
+  typedef std::vector< AccumulateType > TableType;
+
+  /** Cut the region in tiles with ComputeRegionTiles(), so the table
+   * of a tile, padded by the radius, stays small, and compute them with
+   * SummedAreaTableOnTile() */
+  void SummedAreaTableOnRegion(const OutputImageRegionType& region,
+                               ProgressReporter & progress);
+
+  /** Build the summed area table of the tile, padded by the radius, and
+   * compute the mean of each output pixel of the tile. table is the
+   * work area. */
+  void SummedAreaTableOnTile(const OutputImageRegionType& tile,
+                             TableType & table,
+                             ProgressReporter & progress);
+
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
 private:
   MovingWindowMeanImageFilter(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
 
+  // the largest number of values in the table of a tile, unless the
+  // kernel padded by the radius is larger
+  enum { MaximumTableSize = 1 << 20 };
+
+  // the largest number of reciprocals in the table of the division. The
+  // larger kernels divide by the number of pixels.
+  enum { MaximumNumberOfReciprocals = 1 << 16 };
+
+  bool m_UseSummedAreaTable;
+
+  bool m_RoundOutput;
+
+  std::vector< double > m_Reciprocals;
+
+  DivisionType m_Division;
+
+  // whether the table is used in the current execution
+  bool m_SummedAreaTableEnabled;
+
 } ; // end of class
 
 } // end namespace itk
   
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkMovingWindowMeanImageFilter.txx"
+#endif
+
 #endif
 
 
@@ -0,0 +1,298 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkMovingWindowMeanImageFilter.txx,v $
+  Language:  C++
+  Date:      $Date: 2004/04/30 21:02:03 $
+  Version:   $Revision: 1.14 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkMovingWindowMeanImageFilter_txx
+#define __itkMovingWindowMeanImageFilter_txx
+
+#include "itkMovingWindowMeanImageFilter.h"
+#include "itkImageLinearConstIteratorWithIndex.h"
+#include "itkProgressReporter.h"
+#include "itkRegionTiles.h"
+#include <algorithm>
+
+namespace itk {
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+MovingWindowMeanImageFilter<TInputImage, TOutputImage, TKernel>
+::MovingWindowMeanImageFilter()
+{
+  m_UseSummedAreaTable = true;
+  m_SummedAreaTableEnabled = false;
+  m_RoundOutput = true;
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+void
+MovingWindowMeanImageFilter<TInputImage, TOutputImage, TKernel>
+::BeforeThreadedGenerateData()
+{
+  Superclass::BeforeThreadedGenerateData();
+
+  // the table gives the sum in a box: all the pixels of the kernel must
+  // be in the neighborhood
+  m_SummedAreaTableEnabled = m_UseSummedAreaTable
+    && this->GetKernelPixelCount() == this->GetKernel().Size();
+
+  // the neighborhood, cropped at the border, has at most as many pixels
+  // as the kernel
+  const unsigned long size = std::min( (unsigned long)this->GetKernelPixelCount() + 1,
+                                       (unsigned long)MaximumNumberOfReciprocals );
+  DivisionType::ComputeReciprocals( m_Reciprocals, size );
+  m_Division.SetReciprocals( m_Reciprocals );
+  m_Division.SetRound( m_RoundOutput );
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+typename MovingWindowMeanImageFilter<TInputImage, TOutputImage, TKernel>::HistogramType *
+MovingWindowMeanImageFilter<TInputImage, TOutputImage, TKernel>
+::NewHistogram()
+{
+  HistogramType * hist = new HistogramType();
+  hist->SetDivision( m_Division );
+  return hist;
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+void
+MovingWindowMeanImageFilter<TInputImage, TOutputImage, TKernel>
+::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+                       int threadId)
+{
+  if( !m_SummedAreaTableEnabled )
+    {
+    Superclass::ThreadedGenerateData( outputRegionForThread, threadId );
+    return;
+    }
+
+  if( this->m_UseDynamicScheduling )
+    {
+    ProgressReporter progress(this, threadId, this->m_NumberOfLinesPerThread);
+    OutputImageRegionType chunk;
+    while( this->GetNextChunk( chunk ) )
+      {
+      this->SummedAreaTableOnRegion( chunk, progress );
+      }
+    }
+  else if( outputRegionForThread.GetNumberOfPixels() > 0 )
+    {
+    // the output is written line by line along the first axis of each
+    // tile: there are more lines when the lines are cut in several tiles
+    std::vector< OutputImageRegionType > tiles;
+    ComputeRegionTiles( outputRegionForThread, this->GetKernel().GetRadius(),
+                        (unsigned long)MaximumTableSize, tiles );
+    unsigned long nbOfLines = 0;
+    for( typename std::vector< OutputImageRegionType >::const_iterator it=tiles.begin(); it!=tiles.end(); it++ )
+      {
+      nbOfLines += it->GetNumberOfPixels() / it->GetSize()[0];
+      }
+    ProgressReporter progress(this, threadId, nbOfLines);
+    this->SummedAreaTableOnRegion( outputRegionForThread, progress );
+    }
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+void
+MovingWindowMeanImageFilter<TInputImage, TOutputImage, TKernel>
+::SummedAreaTableOnRegion(const OutputImageRegionType& region,
+                          ProgressReporter & progress)
+{
+  if( region.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+
+  // the tiles are cut along all the axes, so their table stays below
+  // MaximumTableSize whatever the size of the slices
+  std::vector< OutputImageRegionType > tiles;
+  ComputeRegionTiles( region, this->GetKernel().GetRadius(),
+                      (unsigned long)MaximumTableSize, tiles );
+
+  TableType table;
+  for( typename std::vector< OutputImageRegionType >::const_iterator it=tiles.begin(); it!=tiles.end(); it++ )
+    {
+    this->SummedAreaTableOnTile( *it, table, progress );
+    }
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+void
+MovingWindowMeanImageFilter<TInputImage, TOutputImage, TKernel>
+::SummedAreaTableOnTile(const OutputImageRegionType& tile,
+                        TableType & table,
+                        ProgressReporter & progress)
+{
+  const InputImageType * inputImage = this->GetInput();
+  OutputImageType * outputImage = this->GetOutput();
+  const RadiusType radius = this->GetKernel().GetRadius();
+
+  InputAccessorType inAccessor = inputImage->GetNeighborhoodAccessor();
+  const InputInternalPixelType * inBuffer = inputImage->GetBufferPointer();
+  inAccessor.SetBegin( inBuffer );
+  OutputAccessorType outAccessor = outputImage->GetNeighborhoodAccessor();
+  OutputInternalPixelType * outBuffer = outputImage->GetBufferPointer();
+  outAccessor.SetBegin( outBuffer );
+
+  // the pixels which can be in the kernel of a pixel of the tile
+  RegionType area = tile;
+  area.PadByRadius( radius );
+  area.Crop( inputImage->GetRequestedRegion() );
+  const IndexType & areaIndex = area.GetIndex();
+  const SizeType & areaSize = area.GetSize();
+
+  // the table has one more position on each axis: the position j of the
+  // table stores the sum of the pixels of the area at the positions
+  // lower than j on all the axes, so it is null when j is 0 on one axis
+  OffsetValueType strides[ImageDimension];
+  OffsetValueType tableSize = 1;
+  for( unsigned int a=0; a<ImageDimension; a++ )
+    {
+    strides[a] = tableSize;
+    tableSize *= areaSize[a] + 1;
+    }
+  table.assign( tableSize, static_cast< AccumulateType >( 0 ) );
+  AccumulateType * t = &table[0];
+
+  // copy the pixels, shifted by one position on each axis
+  typedef ImageLinearConstIteratorWithIndex< InputImageType > InputLineIteratorType;
+  const long areaLength = areaSize[0];
+  InputLineIteratorType inLineIt( inputImage, area );
+  inLineIt.SetDirection( 0 );
+  for( inLineIt.GoToBegin(); !inLineIt.IsAtEnd(); inLineIt.NextLine() )
+    {
+    const IndexType idx = inLineIt.GetIndex();
+    OffsetValueType o = 0;
+    for( unsigned int a=0; a<ImageDimension; a++ )
+      {
+      o += ( idx[a] - areaIndex[a] + 1 ) * strides[a];
+      }
+    const InputInternalPixelType * inPtr = inBuffer + inputImage->ComputeOffset( idx );
+    AccumulateType * line = t + o;
+    for( long k=0; k<areaLength; k++ )
+      {
+      line[k] = static_cast< AccumulateType >( inAccessor.Get( inPtr + k ) );
+      }
+    }
+
+  // and sum them along each axis
+  for( unsigned int a=0; a<ImageDimension; a++ )
+    {
+    const OffsetValueType stride = strides[a];
+    const OffsetValueType block = stride * ( areaSize[a] + 1 );
+    for( OffsetValueType base=0; base<tableSize; base+=block )
+      {
+      for( OffsetValueType j=1; j<=(OffsetValueType)areaSize[a]; j++ )
+        {
+        AccumulateType * current = t + base + j * stride;
+        const AccumulateType * previous = current - stride;
+        for( OffsetValueType i=0; i<stride; i++ )
+          {
+          current[i] += previous[i];
+          }
+        }
+      }
+    }
+
+  // the sum in the box is given by the 2^d corners of the box in the
+  // table. The corners on the axes other than the first one are the
+  // same along a line.
+  const unsigned int nbOfCorners = 1 << ( ImageDimension - 1 );
+  OffsetValueType cornerOffsets[nbOfCorners];
+  bool cornerSigns[nbOfCorners];
+  const long r0 = radius[0];
+  const long areaStart0 = areaIndex[0];
+  const long areaEnd0 = areaStart0 + areaLength;
+  const long lineLength = tile.GetSize()[0];
+
+  InputLineIteratorType lineIt( inputImage, tile );
+  lineIt.SetDirection( 0 );
+  for( lineIt.GoToBegin(); !lineIt.IsAtEnd(); lineIt.NextLine() )
+    {
+    const IndexType idx = lineIt.GetIndex();
+
+    // the number of pixels in the box, on the other axes
+    unsigned long lineCount = 1;
+    for( unsigned int c=0; c<nbOfCorners; c++ )
+      {
+      cornerOffsets[c] = 0;
+      cornerSigns[c] = true;
+      }
+    for( unsigned int a=1; a<ImageDimension; a++ )
+      {
+      // the box is cropped by the area, which is cropped by the input
+      // requested region
+      const long low = std::max( idx[a] - (long)radius[a], areaIndex[a] ) - areaIndex[a];
+      const long high = std::min( idx[a] + (long)radius[a], areaIndex[a] + (long)areaSize[a] - 1 ) - areaIndex[a] + 1;
+      lineCount *= high - low;
+      for( unsigned int c=0; c<nbOfCorners; c++ )
+        {
+        if( c & ( 1 << ( a - 1 ) ) )
+          {
+          cornerOffsets[c] += low * strides[a];
+          cornerSigns[c] = !cornerSigns[c];
+          }
+        else
+          {
+          cornerOffsets[c] += high * strides[a];
+          }
+        }
+      }
+
+    OutputInternalPixelType * outPtr = outBuffer + outputImage->ComputeOffset( idx );
+    for( long k=0; k<lineLength; k++ )
+      {
+      const long p = idx[0] + k;
+      const long low = std::max( p - r0, areaStart0 ) - areaStart0;
+      const long high = std::min( p + r0, areaEnd0 - 1 ) - areaStart0 + 1;
+      AccumulateType sum = static_cast< AccumulateType >( 0 );
+      for( unsigned int c=0; c<nbOfCorners; c++ )
+        {
+        const AccumulateType * corner = t + cornerOffsets[c];
+        if( cornerSigns[c] )
+          {
+          sum += corner[high] - corner[low];
+          }
+        else
+          {
+          sum -= corner[high] - corner[low];
+          }
+        }
+      // the same computation as Function::MeanHistogram
+      outAccessor.Set( outPtr + k, m_Division( sum, lineCount * ( high - low ) ) );
+      }
+    progress.CompletedPixel();
+    }
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+void
+MovingWindowMeanImageFilter<TInputImage, TOutputImage, TKernel>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "UseSummedAreaTable: " << m_UseSummedAreaTable << std::endl;
+  os << indent << "RoundOutput: " << m_RoundOutput << std::endl;
+}
+
+}// end namespace itk
+#endif
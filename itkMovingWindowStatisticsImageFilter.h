@@ -0,0 +1,306 @@
+#ifndef __itkMovingWindowStatisticsImageFilter_h
+#define __itkMovingWindowStatisticsImageFilter_h
+
+#include "itkMovingHistogramImageFilter.h"
+#include "itkMovingWindowMeanImageFilter.h"
+#include <map>
+#include <algorithm>
+#include <cmath>
+
+namespace itk {
+
+namespace Function {
+
+/** The positions of the statistics in the output pixels of
+ * MovingWindowStatisticsImageFilter and SeparableStatisticsImageFilter */
+class StatisticsComponents
+{
+public:
+  enum { Mean = 0, Variance = 1, Sigma = 2, Minimum = 3, Maximum = 4 };
+};
+
+/** The type used to sum the squares of the pixels in StatisticsHistogram:
+ * a 64 bit integer for the integer pixel types up to 16 bits, where the
+ * sums are then exact, and double for the other ones. */
+template <class TInputPixel, bool VExactInteger = ( NumericTraits< TInputPixel >::is_integer && sizeof( TInputPixel ) <= 2 ) >
+class SquareAccumulator
+{
+public:
+  typedef double Type;
+};
+
+template <class TInputPixel>
+class SquareAccumulator< TInputPixel, true >
+{
+public:
+  typedef long long Type;
+};
+
+/** How StatisticsHistogram reads its input pixels. A scalar pixel is the
+ * statistics of a set of one pixel. The sums are the ones of
+ * MeanAccumulator and SquareAccumulator, so they don't drift while the
+ * kernel is moved over the integer images. */
+template <class TInputPixel, class TOutputPixel>
+class StatisticsInputTraits
+{
+public:
+  typedef TInputPixel ExtremumType;
+  typedef typename MeanAccumulator< TInputPixel >::Type SumType;
+  typedef typename SquareAccumulator< TInputPixel >::Type SumOfSquaresType;
+
+  // the minimum and the maximum are the same value: only one set of
+  // values is kept
+  enum { SharedExtrema = 1 };
+
+  static inline SumType Mean( const TInputPixel & p )
+    {
+    return static_cast< SumType >( p );
+    }
+
+  static inline SumOfSquaresType MeanOfSquares( const TInputPixel & p )
+    {
+    const SumOfSquaresType v = static_cast< SumOfSquaresType >( p );
+    return v * v;
+    }
+
+  static inline ExtremumType Minimum( const TInputPixel & p )
+    {
+    return p;
+    }
+
+  static inline ExtremumType Maximum( const TInputPixel & p )
+    {
+    return p;
+    }
+};
+
+/** An input pixel of the output type is the statistics of a set of
+ * pixels, computed by an other StatisticsHistogram. All the sets must
+ * have the same number of pixels, as the lines of a box kernel in a
+ * separable filter. */
+template <class TPixel>
+class StatisticsInputTraits< TPixel, TPixel >
+{
+public:
+  typedef typename TPixel::ValueType ExtremumType;
+  typedef double SumType;
+  typedef double SumOfSquaresType;
+
+  enum { SharedExtrema = 0 };
+
+  static inline double Mean( const TPixel & p )
+    {
+    return static_cast< double >( p[StatisticsComponents::Mean] );
+    }
+
+  static inline double MeanOfSquares( const TPixel & p )
+    {
+    const double mean = static_cast< double >( p[StatisticsComponents::Mean] );
+    return static_cast< double >( p[StatisticsComponents::Variance] ) + mean * mean;
+    }
+
+  static inline ExtremumType Minimum( const TPixel & p )
+    {
+    return p[StatisticsComponents::Minimum];
+    }
+
+  static inline ExtremumType Maximum( const TPixel & p )
+    {
+    return p[StatisticsComponents::Maximum];
+    }
+};
+
+/** The mean, the variance and the standard deviation of the pixels in
+ * the neighborhood, and their minimum and maximum when the output pixel
+ * has room for them.
+ *
+ * TOutputPixel is a fixed size array, like itk::Vector, with at least 3
+ * components: see StatisticsComponents. The minimum and the maximum
+ * require an ordered set of the values of the neighborhood, and are
+ * only tracked when the output pixel has 5 components or more. */
+template <class TInputPixel, class TOutputPixel>
+class StatisticsHistogram
+{
+public:
+  typedef StatisticsInputTraits< TInputPixel, TOutputPixel > InputTraits;
+  typedef typename InputTraits::ExtremumType ExtremumType;
+  typedef typename InputTraits::SumType SumType;
+  typedef typename InputTraits::SumOfSquaresType SumOfSquaresType;
+  typedef typename TOutputPixel::ValueType OutputValueType;
+
+  enum { TrackExtrema = ( (unsigned int)TOutputPixel::Dimension > (unsigned int)StatisticsComponents::Maximum ) };
+
+  StatisticsHistogram()
+    {
+    sum = 0;
+    sumOfSquares = 0;
+    count = 0;
+    }
+  ~StatisticsHistogram(){}
+
+  inline void AddBoundary() {}
+
+  inline void RemoveBoundary() {}
+
+  inline void AddPixel( const TInputPixel &p )
+    {
+    sum += InputTraits::Mean( p );
+    sumOfSquares += InputTraits::MeanOfSquares( p );
+    count++;
+    if( TrackExtrema )
+      {
+      minima[ InputTraits::Minimum( p ) ]++;
+      if( !InputTraits::SharedExtrema )
+        {
+        maxima[ InputTraits::Maximum( p ) ]++;
+        }
+      }
+    }
+
+  inline void RemovePixel( const TInputPixel &p )
+    {
+    sum -= InputTraits::Mean( p );
+    sumOfSquares -= InputTraits::MeanOfSquares( p );
+    assert( count > 0 );
+    count--;
+    if( TrackExtrema )
+      {
+      Remove( minima, InputTraits::Minimum( p ) );
+      if( !InputTraits::SharedExtrema )
+        {
+        Remove( maxima, InputTraits::Maximum( p ) );
+        }
+      }
+    }
+
+  inline TOutputPixel GetValue( const TInputPixel & )
+    {
+    TOutputPixel value;
+    const double n = static_cast< double >( count );
+    const double mean = static_cast< double >( sum ) / n;
+    // the variance can be slightly negative because of the rounding
+    // errors on a constant neighborhood
+    const double variance = std::max( ( static_cast< double >( sumOfSquares ) - static_cast< double >( sum ) * mean ) / n, 0.0 );
+    value[StatisticsComponents::Mean] = static_cast< OutputValueType >( mean );
+    value[StatisticsComponents::Variance] = static_cast< OutputValueType >( variance );
+    value[StatisticsComponents::Sigma] = static_cast< OutputValueType >( std::sqrt( variance ) );
+    if( TrackExtrema )
+      {
+      const ExtremumMapType & maxMap = InputTraits::SharedExtrema ? minima : maxima;
+      value[StatisticsComponents::Minimum] = static_cast< OutputValueType >( minima.begin()->first );
+      value[StatisticsComponents::Maximum] = static_cast< OutputValueType >( maxMap.rbegin()->first );
+      }
+    return value;
+    }
+
+  SumType sum;
+  SumOfSquaresType sumOfSquares;
+  unsigned long count;
+
+  typedef std::map< ExtremumType, unsigned long > ExtremumMapType;
+  ExtremumMapType minima;
+  ExtremumMapType maxima;
+
+private:
+  static inline void Remove( ExtremumMapType & m, const ExtremumType & v )
+    {
+    typename ExtremumMapType::iterator it = m.find( v );
+    assert( it != m.end() );
+    if( --( it->second ) == 0 )
+      {
+      m.erase( it );
+      }
+    }
+};
+
+} // end namespace Function
+
+
+/**
+ * \class MovingWindowStatisticsImageFilter
+ * \brief Local mean, variance, standard deviation, minimum and maximum
+ *
+ * This filter computes several statistics of the pixels in the
+ * neighborhood in a single pass, with the moving window used by
+ * MovingWindowMeanImageFilter. The sum and the sum of the squares of
+ * the pixels are updated together, so the local standard deviation
+ * doesn't require to filter the image and its squared copy separately.
+ * As in MovingWindowMeanImageFilter, the sum is an integer for the
+ * integer pixel types up to 32 bits, and the sum of the squares for the
+ * ones up to 16 bits, so these sums are exact.
+ *
+ * The output pixel type must be an array of at least 3 values, like
+ * itk::Vector< float, 3 >: the mean, the variance and the standard
+ * deviation (see Function::StatisticsComponents). The variance is the
+ * one of the population of the neighborhood: the sum of the squared
+ * differences to the mean is divided by the number of pixels. When the
+ * output pixel has 5 components, the minimum and the maximum are stored
+ * in the last two. They are computed with an ordered map of the values,
+ * so they make the filter slower.
+ *
+ * As in MovingWindowMeanImageFilter, the neighborhood is cropped at the
+ * border. SeparableStatisticsImageFilter produces the same statistics
+ * for the box kernels.
+ *
+ * \sa MovingWindowMeanImageFilter, SeparableStatisticsImageFilter
+ */
+
+template<class TInputImage, class TOutputImage, class TKernel >
+class ITK_EXPORT MovingWindowStatisticsImageFilter :
+    public MovingHistogramImageFilter<TInputImage, TOutputImage, TKernel, typename  Function::StatisticsHistogram< typename TInputImage::PixelType, typename TOutputImage::PixelType > >
+{
+public:
+  /** Standard class typedefs. */
+  typedef MovingWindowStatisticsImageFilter Self;
+  typedef MovingHistogramImageFilter<TInputImage,TOutputImage, TKernel, typename  Function::StatisticsHistogram< typename TInputImage::PixelType, typename TOutputImage::PixelType > >  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(MovingWindowStatisticsImageFilter,
+               MovingHistogramImageFilter);
+
+  /** Image related typedefs. */
+  typedef TInputImage InputImageType;
+  typedef TOutputImage OutputImageType;
+  typedef typename TInputImage::RegionType RegionType ;
+  typedef typename TInputImage::SizeType SizeType ;
+  typedef typename TInputImage::IndexType IndexType ;
+  typedef typename TInputImage::PixelType PixelType ;
+  typedef typename TInputImage::OffsetType OffsetType ;
+  typedef typename Superclass::OutputImageRegionType OutputImageRegionType;
+  typedef typename TOutputImage::PixelType OutputPixelType ;
+  typedef typename TInputImage::PixelType InputPixelType ;
+
+  /** Image related typedefs. */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+
+  /** Kernel typedef. */
+  typedef TKernel KernelType;
+
+  /** Kernel (structuring element) iterator. */
+  typedef typename KernelType::ConstIterator KernelIteratorType ;
+
+  /** n-dimensional Kernel radius. */
+  typedef typename KernelType::SizeType RadiusType ;
+
+  /** The positions of the statistics in the output pixels */
+  typedef Function::StatisticsComponents ComponentsType;
+
+protected:
+  MovingWindowStatisticsImageFilter() {};
+  ~MovingWindowStatisticsImageFilter() {};
+
+private:
+  MovingWindowStatisticsImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+} ; // end of class
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,447 @@
+// histograms keeping track of several ranks in the same moving
+// histogram pass
+#ifndef __itkMultiRankHistogram_h
+#define __itkMultiRankHistogram_h
+#include "itkRankHistogram.h"
+#include "itkVariableLengthVector.h"
+#include <vector>
+
+namespace itk {
+
+// These histograms store the pixels only once, like the single rank
+// histograms they are derived from, but keep one rank cursor per
+// requested rank. GetValue() returns all the rank values in a
+// VariableLengthVector.
+//
+// The returned vector doesn't own its data: it refers to a buffer of the
+// histogram which is overwritten by the next call to GetValue(), so
+// nothing is allocated per pixel. It must be copied (in the output image
+// for example) before the next call.
+//
+// SetRanks() must be called before the first call to GetValue().
+
+// The buffer used to return the rank values. The histograms are copied
+// at each line change of the moving histogram traversal: a copy only
+// keeps the size of the buffer, as its content is recomputed by the next
+// GetValue() anyway, and doesn't allocate anything once the sizes match.
+template <class TValue>
+class MultiRankValueBuffer
+{
+public:
+  typedef VariableLengthVector< TValue > VectorType;
+
+  MultiRankValueBuffer()
+  {
+  }
+
+  MultiRankValueBuffer(const MultiRankValueBuffer & b)
+  {
+    m_Values.SetSize( b.m_Values.Size() );
+  }
+
+  MultiRankValueBuffer & operator=(const MultiRankValueBuffer & b)
+  {
+    if( m_Values.Size() != b.m_Values.Size() )
+      {
+      m_Values.SetSize( b.m_Values.Size() );
+      }
+    return *this;
+  }
+
+  void SetSize(unsigned int size)
+  {
+    m_Values.SetSize( size );
+  }
+
+  TValue & operator[](unsigned int i)
+  {
+    return m_Values[i];
+  }
+
+  // a vector referring to the buffer, without copy
+  VectorType GetVector()
+  {
+    return VectorType( m_Values.GetDataPointer(), m_Values.Size(), false );
+  }
+
+private:
+  VectorType m_Values;
+};
+
+template <class TInputPixel, class TCompare>
+class MultiRankHistogramVec : public RankHistogramVec<TInputPixel, TCompare>
+{
+public:
+  typedef VariableLengthVector< TInputPixel > ValueType;
+
+  MultiRankHistogramVec()
+  {
+  }
+
+  ~MultiRankHistogramVec()
+  {
+  }
+
+  void SetRanks(const std::vector<float> & ranks)
+  {
+    m_Ranks = ranks;
+    m_Values.SetSize( ranks.size() );
+    // start at the end of the histogram, as the single rank histogram
+    Cursor c;
+    c.Pos = this->m_Size - 1;
+    c.Below = this->m_Entries;
+    m_Cursors.assign( ranks.size(), c );
+  }
+
+  ValueType GetValue( const TInputPixel & )
+  {
+    assert( this->m_Entries > 0 );
+    for( unsigned int i=0; i<m_Cursors.size(); i++ )
+      {
+      Cursor & c = m_Cursors[i];
+      unsigned long target = (unsigned long)(m_Ranks[i] * (this->m_Entries-1)) + 1;
+      this->Locate( c.Pos, c.Below, target );
+      m_Values[i] = (TInputPixel)(c.Pos + NumericTraits< TInputPixel >::NonpositiveMin());
+      }
+    return m_Values.GetVector();
+  }
+
+  void AddPixel(const TInputPixel &p)
+  {
+    unsigned long idx = (unsigned long)(p - NumericTraits< TInputPixel >::NonpositiveMin());
+    this->m_Vec[ idx ]++;
+    ++this->m_Entries;
+    for( typename CursorVecType::iterator it=m_Cursors.begin(); it!=m_Cursors.end(); it++ )
+      {
+      if( idx <= it->Pos )
+        {
+        ++it->Below;
+        }
+      }
+  }
+
+  void RemovePixel(const TInputPixel &p)
+  {
+    unsigned long idx = (unsigned long)(p - NumericTraits< TInputPixel >::NonpositiveMin());
+    assert( this->m_Entries >= 1 );
+    this->m_Vec[ idx ]--;
+    --this->m_Entries;
+    for( typename CursorVecType::iterator it=m_Cursors.begin(); it!=m_Cursors.end(); it++ )
+      {
+      if( idx <= it->Pos )
+        {
+        --it->Below;
+        }
+      }
+  }
+
+  MultiRankHistogramVec * Clone()
+   {
+    return new MultiRankHistogramVec(*this);
+   }
+
+private:
+  // the bin of the last rank value, and the number of pixels up to it
+  struct Cursor
+  {
+    unsigned long Pos;
+    unsigned long Below;
+  };
+  typedef typename std::vector<Cursor> CursorVecType;
+
+  std::vector<float> m_Ranks;
+  CursorVecType m_Cursors;
+  MultiRankValueBuffer< TInputPixel > m_Values;
+};
+
+
+template <class TInputPixel, class TCompare>
+class MultiRankHistogramRadix : public RankHistogramRadix<TInputPixel, TCompare>
+{
+public:
+  typedef VariableLengthVector< TInputPixel > ValueType;
+  typedef typename RankHistogramRadix<TInputPixel, TCompare>::KeyType KeyType;
+
+  MultiRankHistogramRadix()
+  {
+  }
+
+  ~MultiRankHistogramRadix()
+  {
+  }
+
+  void SetRanks(const std::vector<float> & ranks)
+  {
+    m_Ranks = ranks;
+    m_Values.SetSize( ranks.size() );
+    Cursor c;
+    c.Pos = this->ToKey( NumericTraits< TInputPixel >::max() );
+    c.Below = this->m_Entries;
+    m_Cursors.assign( ranks.size(), c );
+  }
+
+  ValueType GetValue( const TInputPixel & )
+  {
+    assert( this->m_Entries > 0 );
+    for( unsigned int i=0; i<m_Cursors.size(); i++ )
+      {
+      Cursor & c = m_Cursors[i];
+      unsigned long target = (unsigned long)(m_Ranks[i] * (this->m_Entries-1)) + 1;
+      this->Locate( c.Pos, c.Below, target );
+      m_Values[i] = this->ToPixel( c.Pos );
+      }
+    return m_Values.GetVector();
+  }
+
+  void AddPixel(const TInputPixel &p)
+  {
+    KeyType key = this->ToKey( p );
+    this->AddKey( key );
+    for( typename CursorVecType::iterator it=m_Cursors.begin(); it!=m_Cursors.end(); it++ )
+      {
+      if( key <= it->Pos )
+        {
+        ++it->Below;
+        }
+      }
+  }
+
+  void RemovePixel(const TInputPixel &p)
+  {
+    KeyType key = this->ToKey( p );
+    this->RemoveKey( key );
+    for( typename CursorVecType::iterator it=m_Cursors.begin(); it!=m_Cursors.end(); it++ )
+      {
+      if( key <= it->Pos )
+        {
+        --it->Below;
+        }
+      }
+  }
+
+  MultiRankHistogramRadix * Clone()
+   {
+    return new MultiRankHistogramRadix(*this);
+   }
+
+private:
+  struct Cursor
+  {
+    KeyType Pos;
+    unsigned long Below;
+  };
+  typedef typename std::vector<Cursor> CursorVecType;
+
+  std::vector<float> m_Ranks;
+  CursorVecType m_Cursors;
+  MultiRankValueBuffer< TInputPixel > m_Values;
+};
+
+
+// the tree doesn't need any cursor: each rank value is found by a
+// descent from the root
+template <class TInputPixel, class TCompare>
+class MultiRankHistogramTree : public RankHistogramTree<TInputPixel, TCompare>
+{
+public:
+  typedef VariableLengthVector< TInputPixel > ValueType;
+
+  MultiRankHistogramTree()
+  {
+  }
+
+  ~MultiRankHistogramTree()
+  {
+  }
+
+  void SetRanks(const std::vector<float> & ranks)
+  {
+    m_Ranks = ranks;
+    m_Values.SetSize( ranks.size() );
+  }
+
+  ValueType GetValue( const TInputPixel & )
+  {
+    assert( this->m_Entries > 0 );
+    for( unsigned int i=0; i<m_Ranks.size(); i++ )
+      {
+      unsigned long target = (unsigned long)(m_Ranks[i] * (this->m_Entries-1)) + 1;
+      m_Values[i] = this->ValueAt( target );
+      }
+    return m_Values.GetVector();
+  }
+
+  MultiRankHistogramTree * Clone()
+   {
+    return new MultiRankHistogramTree(*this);
+   }
+
+private:
+  std::vector<float> m_Ranks;
+  MultiRankValueBuffer< TInputPixel > m_Values;
+};
+
+
+// A histogram of vector pixels, where each component has its own single
+// rank histogram and its own rank. It is used to apply a different rank
+// to each component of a VectorImage, in the last steps of the separable
+// filter.
+template <class TInputPixel>
+class ComponentRankHistogram
+{
+public:
+  typedef typename TInputPixel::ValueType ComponentType;
+  typedef typename RankHistogramSelector< ComponentType >::Type ComponentHistogramType;
+  typedef VariableLengthVector< ComponentType > ValueType;
+
+  ComponentRankHistogram()
+  {
+  }
+
+  ~ComponentRankHistogram()
+  {
+  }
+
+  void SetRanks(const std::vector<float> & ranks)
+  {
+    m_Histograms.clear();
+    m_Histograms.resize( ranks.size() );
+    for( unsigned int i=0; i<ranks.size(); i++ )
+      {
+      m_Histograms[i].SetRank( ranks[i] );
+      }
+    m_Values.SetSize( ranks.size() );
+  }
+
+  void AddBoundary(){}
+
+  void RemoveBoundary(){}
+
+  ValueType GetValue( const TInputPixel & p )
+  {
+    for( unsigned int i=0; i<m_Histograms.size(); i++ )
+      {
+      m_Values[i] = m_Histograms[i].GetValue( p[i] );
+      }
+    return m_Values.GetVector();
+  }
+
+  void AddPixel(const TInputPixel &p)
+  {
+    for( unsigned int i=0; i<m_Histograms.size(); i++ )
+      {
+      m_Histograms[i].AddPixel( p[i] );
+      }
+  }
+
+  void RemovePixel(const TInputPixel &p)
+  {
+    for( unsigned int i=0; i<m_Histograms.size(); i++ )
+      {
+      m_Histograms[i].RemovePixel( p[i] );
+      }
+  }
+
+  ComponentRankHistogram * Clone()
+   {
+    return new ComponentRankHistogram(*this);
+   }
+
+private:
+  std::vector< ComponentHistogramType > m_Histograms;
+  MultiRankValueBuffer< ComponentType > m_Values;
+};
+
+
+// Tell if the multi rank histogram of a pixel type applies one rank per
+// component, instead of all the ranks to the whole pixel
+template <class TInputPixel>
+class MultiRankIsComponentWise
+{
+public:
+  enum { Value = false };
+};
+
+template <class TComponent>
+class MultiRankIsComponentWise< VariableLengthVector< TComponent > >
+{
+public:
+  enum { Value = true };
+};
+
+
+// Select at compile time the multi rank histogram to use for a pixel
+// type, with the same rules as RankHistogramSelector. The vector pixels
+// use one histogram per component.
+template <class TInputPixel, class TCompare = std::less< TInputPixel > >
+class MultiRankHistogramSelector
+{
+public:
+  typedef MultiRankHistogramTree< TInputPixel, TCompare > Type;
+};
+
+template <class TComponent, class TCompare>
+class MultiRankHistogramSelector< VariableLengthVector< TComponent >, TCompare >
+{
+public:
+  typedef ComponentRankHistogram< VariableLengthVector< TComponent > > Type;
+};
+
+template <class TCompare>
+class MultiRankHistogramSelector< bool, TCompare >
+{
+public:
+  typedef MultiRankHistogramVec< bool, TCompare > Type;
+};
+
+template <class TCompare>
+class MultiRankHistogramSelector< char, TCompare >
+{
+public:
+  typedef MultiRankHistogramVec< char, TCompare > Type;
+};
+
+template <class TCompare>
+class MultiRankHistogramSelector< signed char, TCompare >
+{
+public:
+  typedef MultiRankHistogramVec< signed char, TCompare > Type;
+};
+
+template <class TCompare>
+class MultiRankHistogramSelector< unsigned char, TCompare >
+{
+public:
+  typedef MultiRankHistogramVec< unsigned char, TCompare > Type;
+};
+
+template <class TCompare>
+class MultiRankHistogramSelector< short, TCompare >
+{
+public:
+  typedef MultiRankHistogramRadix< short, TCompare > Type;
+};
+
+template <class TCompare>
+class MultiRankHistogramSelector< unsigned short, TCompare >
+{
+public:
+  typedef MultiRankHistogramRadix< unsigned short, TCompare > Type;
+};
+
+template <class TCompare>
+class MultiRankHistogramSelector< int, TCompare >
+{
+public:
+  typedef MultiRankHistogramRadix< int, TCompare > Type;
+};
+
+template <class TCompare>
+class MultiRankHistogramSelector< unsigned int, TCompare >
+{
+public:
+  typedef MultiRankHistogramRadix< unsigned int, TCompare > Type;
+};
+
+} // end namespace itk
+#endif
@@ -0,0 +1,135 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkMultiRankImageFilter.h,v $
+  Language:  C++
+  Date:      $Date: 2004/04/30 21:02:03 $
+  Version:   $Revision: 1.15 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkMultiRankImageFilter_h
+#define __itkMultiRankImageFilter_h
+
+#include "itkMovingHistogramImageFilter.h"
+#include "itkMultiRankHistogram.h"
+#include <vector>
+
+namespace itk {
+
+/**
+ * \class MultiRankImageFilter
+ * \brief Several ranks of a greyscale image in a single pass
+ *
+ * This filter computes several user defined ranks of the input pixels
+ * in a user defined neighborhood, as several RankImageFilter would do,
+ * but with a single traversal of the image and a single histogram: the
+ * histogram keeps one rank position per requested rank. The rank values
+ * are stored in the components of the output pixels, in the order of
+ * the ranks given to SetRanks(). The output image must be a VectorImage.
+ * To avoid a copy of the rank values for each pixel, the output
+ * component type should be the same as the input pixel type.
+ *
+ * If the input image is a VectorImage, the pixels are not considered as
+ * a whole: each component has its own histogram and the rank i is
+ * applied to the component i. There must be as many ranks as components
+ * in that case, or an exception is thrown. This mode is used by
+ * FastApproxMultiRankImageFilter.
+ *
+ * The boundary conditions are the same as the ones of RankImageFilter:
+ * the neighborhood is cropped at the boundary.
+ *
+ * \sa RankImageFilter, FastApproxMultiRankImageFilter
+ * \author Richard Beare
+ */
+
+template<class TInputImage, class TOutputImage, class TKernel >
+class ITK_EXPORT MultiRankImageFilter :
+    public MovingHistogramImageFilter<TInputImage, TOutputImage, TKernel, typename MultiRankHistogramSelector< typename TInputImage::PixelType >::Type >
+{
+public:
+  /** Standard class typedefs. */
+  typedef MultiRankImageFilter Self;
+  typedef MovingHistogramImageFilter<TInputImage,TOutputImage, TKernel, typename MultiRankHistogramSelector< typename TInputImage::PixelType >::Type >  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(MultiRankImageFilter,
+               MovingHistogramImageFilter);
+
+  /** Image related typedefs. */
+  typedef TInputImage InputImageType;
+  typedef TOutputImage OutputImageType;
+  typedef typename TInputImage::RegionType RegionType ;
+  typedef typename TInputImage::SizeType SizeType ;
+  typedef typename TInputImage::IndexType IndexType ;
+  typedef typename TInputImage::PixelType PixelType ;
+  typedef typename TInputImage::OffsetType OffsetType ;
+  typedef typename Superclass::OutputImageRegionType OutputImageRegionType;
+  typedef typename TOutputImage::PixelType OutputPixelType ;
+  typedef typename TInputImage::PixelType InputPixelType ;
+
+  /** Image related typedefs. */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+
+  /** Kernel typedef. */
+  typedef TKernel KernelType;
+
+  /** Kernel (structuring element) iterator. */
+  typedef typename KernelType::ConstIterator KernelIteratorType ;
+
+  /** n-dimensional Kernel radius. */
+  typedef typename KernelType::SizeType RadiusType ;
+
+  typedef std::vector<float> RanksType;
+
+  /** The ranks to compute, between 0 and 1. There is one output
+   * component per rank. Defaults to a single rank of 0.5 (median). */
+  itkSetMacro(Ranks, RanksType);
+  itkGetConstReferenceMacro(Ranks, RanksType);
+
+protected:
+  MultiRankImageFilter();
+  ~MultiRankImageFilter() {};
+
+  /** Set the number of components of the output to the number of
+   * ranks */
+  void GenerateOutputInformation();
+
+  /** Check that a VectorImage input has one component per rank */
+  void BeforeThreadedGenerateData();
+
+  typedef typename Superclass::HistogramType HistogramType;
+
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  virtual HistogramType * NewHistogram();
+
+private:
+  MultiRankImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  RanksType m_Ranks;
+
+} ; // end of class
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkMultiRankImageFilter.txx"
+#endif
+
+#endif
+
+
@@ -0,0 +1,93 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkMultiRankImageFilter.txx,v $
+  Language:  C++
+  Date:      $Date: 2004/04/30 21:02:03 $
+  Version:   $Revision: 1.14 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkMultiRankImageFilter_txx
+#define __itkMultiRankImageFilter_txx
+
+#include "itkMultiRankImageFilter.h"
+#include "itkNumericTraits.h"
+
+namespace itk {
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+MultiRankImageFilter<TInputImage, TOutputImage, TKernel>
+::MultiRankImageFilter()
+{
+  m_Ranks.push_back( 0.5 );
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+void
+MultiRankImageFilter<TInputImage, TOutputImage, TKernel>
+::GenerateOutputInformation()
+{
+  Superclass::GenerateOutputInformation();
+
+  if( m_Ranks.empty() )
+    {
+    itkExceptionMacro( << "At least one rank must be set." );
+    }
+  this->GetOutput()->SetVectorLength( m_Ranks.size() );
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+void
+MultiRankImageFilter<TInputImage, TOutputImage, TKernel>
+::BeforeThreadedGenerateData()
+{
+  Superclass::BeforeThreadedGenerateData();
+
+  // the histogram of a vector pixel reads one component per rank
+  if( MultiRankIsComponentWise< InputPixelType >::Value
+      && this->GetInput()->GetNumberOfComponentsPerPixel() != m_Ranks.size() )
+    {
+    itkExceptionMacro( << "The input image has " << this->GetInput()->GetNumberOfComponentsPerPixel()
+                       << " components, but " << m_Ranks.size() << " ranks are set." );
+    }
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+typename MultiRankImageFilter<TInputImage, TOutputImage, TKernel>::HistogramType *
+MultiRankImageFilter<TInputImage, TOutputImage, TKernel>
+::NewHistogram()
+{
+  HistogramType * hist = new HistogramType();
+  hist->SetRanks( m_Ranks );
+  return hist;
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+void
+MultiRankImageFilter<TInputImage, TOutputImage, TKernel>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Ranks:";
+  for( unsigned int i=0; i<m_Ranks.size(); i++ )
+    {
+    os << " " << static_cast<typename NumericTraits< float >::PrintType>( m_Ranks[i] );
+    }
+  os << std::endl;
+}
+
+}// end namespace itk
+#endif
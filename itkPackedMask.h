@@ -0,0 +1,254 @@
+#ifndef __itkPackedMask_h
+#define __itkPackedMask_h
+
+#include "itkImageRegion.h"
+#include "itkImageRegionConstIterator.h"
+#include <vector>
+#include <algorithm>
+
+namespace itk {
+
+/**
+ * \class PackedMask
+ * \brief A binary mask stored with one bit per pixel
+ *
+ * The masked filters only need to know if a pixel is in the mask or
+ * not, but a mask image stores a whole MaskPixelType for each pixel.
+ * This class stores the same information in the bits of an array of
+ * words, so it takes 8 to 16 times less memory and bandwidth than the
+ * usual unsigned char and unsigned short masks.
+ *
+ * The bits are stored in the order of the pixels of an image buffered
+ * on the region of the mask: the offset of a pixel is the same in the
+ * mask and in such an image, and the lines along the first axis are
+ * contiguous. FindNext() uses this to skip a whole word of identical
+ * bits at once.
+ *
+ * This is not a DataObject: the filters give their packed masks to each
+ * other directly, outside of the pipeline.
+ *
+ * \sa MaskedMovingHistogramImageFilter, FastApproxMaskRankImageFilter
+ */
+template <unsigned int VImageDimension>
+class PackedMask
+{
+public:
+  typedef ImageRegion< VImageDimension > RegionType;
+  typedef typename RegionType::IndexType IndexType;
+  typedef typename RegionType::SizeType SizeType;
+  typedef long OffsetValueType;
+  typedef unsigned long WordType;
+
+  enum { WordBits = sizeof( WordType ) * 8 };
+
+  PackedMask()
+    {
+    for( unsigned int a=0; a<VImageDimension; a++ )
+      {
+      m_OffsetTable[a] = 0;
+      }
+    }
+
+  /** Set the region of the mask. All the bits are cleared. */
+  void SetRegion( const RegionType & region )
+    {
+    m_Region = region;
+    OffsetValueType n = 1;
+    for( unsigned int a=0; a<VImageDimension; a++ )
+      {
+      m_OffsetTable[a] = n;
+      n *= region.GetSize()[a];
+      }
+    m_Words.assign( ( n + WordBits - 1 ) / WordBits, 0 );
+    }
+
+  const RegionType & GetRegion() const
+    {
+    return m_Region;
+    }
+
+  const OffsetValueType * GetOffsetTable() const
+    {
+    return m_OffsetTable;
+    }
+
+  /** The position of the bit of a pixel of the region */
+  inline OffsetValueType ComputeOffset( const IndexType & idx ) const
+    {
+    OffsetValueType o = 0;
+    for( unsigned int a=0; a<VImageDimension; a++ )
+      {
+      o += ( idx[a] - m_Region.GetIndex()[a] ) * m_OffsetTable[a];
+      }
+    return o;
+    }
+
+  inline bool Test( OffsetValueType o ) const
+    {
+    return ( m_Words[o / WordBits] >> ( o % WordBits ) ) & 1;
+    }
+
+  inline void Set( OffsetValueType o )
+    {
+    m_Words[o / WordBits] |= WordType( 1 ) << ( o % WordBits );
+    }
+
+  inline void Reset( OffsetValueType o )
+    {
+    m_Words[o / WordBits] &= ~( WordType( 1 ) << ( o % WordBits ) );
+    }
+
+  /** The position of the first bit equal to value from o to end
+   * (excluded), or end if there is none */
+  OffsetValueType FindNext( OffsetValueType o, OffsetValueType end, bool value ) const
+    {
+    while( o < end )
+      {
+      WordType word = m_Words[o / WordBits];
+      if( !value )
+        {
+        word = ~word;
+        }
+      word >>= o % WordBits;
+      if( word == 0 )
+        {
+        // nothing in the rest of the word
+        o = ( o / WordBits + 1 ) * WordBits;
+        continue;
+        }
+      while( !( word & 1 ) )
+        {
+        word >>= 1;
+        o++;
+        }
+      return o < end ? o : end;
+      }
+    return end;
+    }
+
+  /** Set the region of the mask to the buffered region of the image,
+   * and set the bits of the pixels equal to value */
+  template <class TImage>
+  void Pack( const TImage * image, const typename TImage::PixelType & value )
+    {
+    this->SetRegion( image->GetBufferedRegion() );
+    ImageRegionConstIterator< TImage > it( image, m_Region );
+    OffsetValueType o = 0;
+    WordType word = 0;
+    for( it.GoToBegin(); !it.IsAtEnd(); ++it, o++ )
+      {
+      if( it.Get() == value )
+        {
+        word |= WordType( 1 ) << ( o % WordBits );
+        }
+      if( o % WordBits == WordBits - 1 )
+        {
+        m_Words[o / WordBits] = word;
+        word = 0;
+        }
+      }
+    if( o % WordBits != 0 )
+      {
+      m_Words[o / WordBits] = word;
+      }
+    }
+
+  /** Set the region of the mask, and copy the bits of that region from
+   * an other mask, which must contain it. The lines along the first
+   * axis are copied a word at a time. */
+  void CopyRegion( const PackedMask & mask, const RegionType & region )
+    {
+    this->SetRegion( region );
+    if( region.GetNumberOfPixels() == 0 )
+      {
+      return;
+      }
+    const long length = region.GetSize()[0];
+    IndexType idx = region.GetIndex();
+    OffsetValueType o = 0;
+    do
+      {
+      this->CopyBits( mask, mask.ComputeOffset( idx ), o, length );
+      o += length;
+      }
+    while( NextLine( region, idx ) );
+    }
+
+  /** Copy all the bits of an other mask, whose region must be inside
+   * the region of this mask. The other bits are kept. */
+  void PasteRegion( const PackedMask & mask )
+    {
+    const RegionType & region = mask.GetRegion();
+    if( region.GetNumberOfPixels() == 0 )
+      {
+      return;
+      }
+    const long length = region.GetSize()[0];
+    IndexType idx = region.GetIndex();
+    OffsetValueType o = 0;
+    do
+      {
+      this->CopyBits( mask, o, this->ComputeOffset( idx ), length );
+      o += length;
+      }
+    while( NextLine( region, idx ) );
+    }
+
+private:
+  /** Move idx to the start of the next line along the first axis of
+   * the region. Returns false after the last line. */
+  static bool NextLine( const RegionType & region, IndexType & idx )
+    {
+    for( unsigned int a=1; a<VImageDimension; a++ )
+      {
+      idx[a]++;
+      if( idx[a] < region.GetIndex()[a] + (long)region.GetSize()[a] )
+        {
+        return true;
+        }
+      idx[a] = region.GetIndex()[a];
+      }
+    return false;
+    }
+
+  /** The WordBits bits from the position o, or less at the end of the
+   * mask */
+  inline WordType GetBits( OffsetValueType o ) const
+    {
+    const OffsetValueType w = o / WordBits;
+    const OffsetValueType shift = o % WordBits;
+    WordType bits = m_Words[w] >> shift;
+    if( shift != 0 && w + 1 < (OffsetValueType)m_Words.size() )
+      {
+      bits |= m_Words[w + 1] << ( WordBits - shift );
+      }
+    return bits;
+    }
+
+  /** Copy length bits of an other mask, from the position src, to the
+   * position dst of this mask. The other bits of the words of this mask
+   * are kept. */
+  void CopyBits( const PackedMask & mask, OffsetValueType src, OffsetValueType dst, OffsetValueType length )
+    {
+    const OffsetValueType end = dst + length;
+    while( dst < end )
+      {
+      // the bits of the current word of this mask
+      const OffsetValueType shift = dst % WordBits;
+      const OffsetValueType n = std::min( (OffsetValueType)WordBits - shift, end - dst );
+      const WordType keep = n == WordBits ? ~WordType( 0 ) : ( WordType( 1 ) << n ) - 1;
+      WordType & word = m_Words[dst / WordBits];
+      word = ( word & ~( keep << shift ) ) | ( ( mask.GetBits( src ) & keep ) << shift );
+      src += n;
+      dst += n;
+      }
+    }
+
+  RegionType m_Region;
+  OffsetValueType m_OffsetTable[VImageDimension];
+  std::vector< WordType > m_Words;
+};
+
+} // end namespace itk
+
+#endif
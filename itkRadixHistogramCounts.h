@@ -0,0 +1,237 @@
+#ifndef __itkRadixHistogramCounts_h
+#define __itkRadixHistogramCounts_h
+
+#include <vector>
+#include <cassert>
+
+namespace itk {
+
+/**
+ * \class RadixHistogramCounts
+ * \brief The bins of a histogram of VKeyBits bits keys, in a radix tree
+ *
+ * The key is split in digits of 8 bits. The tree has one level per
+ * digit, and each node has 256 entries: the entries of the leaves are the
+ * bins of the histogram, and the entries of the other nodes count the
+ * pixels in their subtrees. The rank search can jump over the subtrees
+ * which don't contain the rank value, so a rank value is found in at
+ * most 512 steps per level: 2 levels for 16 bits keys, 4 levels for 32
+ * bits keys.
+ *
+ * A node is only allocated while its subtree contains a pixel, so the
+ * size of the tree depends on the number of distinct values in the
+ * kernel, not on the range of the pixel type. The removed nodes are kept
+ * in a free list and reused by the next insertions.
+ */
+template <unsigned int VKeyBits>
+class RadixHistogramCounts
+{
+public:
+  typedef unsigned long KeyType;
+
+  RadixHistogramCounts()
+  {
+    this->Reset();
+  }
+
+  // remove all the pixels, but keep the allocated memory
+  void Reset()
+  {
+    m_Counts.assign( Base, 0 );
+    m_Children.assign( Base, NoNode );
+    m_FreeNodes.clear();
+  }
+
+  void AddKey(const KeyType &key)
+  {
+    NodeIdType node = Root;
+    for( unsigned int level=Levels-1; level>0; level-- )
+      {
+      const unsigned int d = Digit( key, level );
+      m_Counts[ node * Base + d ]++;
+      NodeIdType child = m_Children[ node * Base + d ];
+      if( child == NoNode )
+        {
+        child = this->NewNode();
+        m_Children[ node * Base + d ] = child;
+        }
+      node = child;
+      }
+    m_Counts[ node * Base + Digit( key, 0 ) ]++;
+  }
+
+  void RemoveKey(const KeyType &key)
+  {
+    NodeIdType node = Root;
+    for( unsigned int level=Levels-1; level>0; level-- )
+      {
+      const unsigned int d = Digit( key, level );
+      assert( m_Counts[ node * Base + d ] > 0 );
+      const NodeIdType child = m_Children[ node * Base + d ];
+      if( --m_Counts[ node * Base + d ] == 0 )
+        {
+        // the subtree only contained that pixel: the nodes below are on
+        // its path, and their counts are all 0 once it is removed
+        m_Children[ node * Base + d ] = NoNode;
+        m_FreeNodes.push_back( child );
+        }
+      node = child;
+      }
+    assert( m_Counts[ node * Base + Digit( key, 0 ) ] > 0 );
+    m_Counts[ node * Base + Digit( key, 0 ) ]--;
+  }
+
+  // move the key pos, with total pixels up to and including pos, to the
+  // first key where the number of pixels reaches target
+  void Locate(KeyType &pos, unsigned long &total, unsigned long target) const
+  {
+    // the nodes on the path of pos - a missing node has no pixel. The
+    // root is never missing, although its id is NoNode.
+    NodeIdType path[Levels];
+    path[Levels-1] = Root;
+    for( unsigned int level=Levels-1; level>0; level-- )
+      {
+      path[level-1] = IsMissing( path, level ) ? NoNode
+        : m_Children[ path[level] * Base + Digit( pos, level ) ];
+      }
+
+    // climb the path of pos until a node contains the rank value in an
+    // entry after (or before) the one on the path
+    const bool up = total < target;
+    unsigned int level = 0;
+    int d = Digit( pos, 0 );
+    if( up )
+      {
+      while( IsMissing( path, level ) || !this->ScanUp( path[level], d, total, target ) )
+        {
+        ++level;
+        assert( level < Levels );
+        d = Digit( pos, level );
+        }
+      }
+    else
+      {
+      // the bin of pos is included in total
+      if( !IsMissing( path, 0 ) )
+        {
+        const unsigned long c = m_Counts[ path[0] * Base + d ];
+        if( total - c < target )
+          {
+          return;
+          }
+        total -= c;
+        }
+      while( IsMissing( path, level ) || !this->ScanDown( path[level], d, total, target ) )
+        {
+        ++level;
+        assert( level < Levels );
+        d = Digit( pos, level );
+        }
+      }
+
+    // then go down to the bin of the rank value
+    NodeIdType node = path[level];
+    KeyType prefix = ( level + 1 < Levels ) ? ( pos >> ( ( level + 1 ) * LevelBits ) ) : 0;
+    while( true )
+      {
+      prefix = ( prefix << LevelBits ) | d;
+      if( level == 0 )
+        {
+        break;
+        }
+      node = m_Children[ node * Base + d ];
+      assert( node != NoNode );
+      --level;
+      if( up )
+        {
+        d = -1;
+        this->ScanUp( node, d, total, target );
+        }
+      else
+        {
+        d = Base;
+        this->ScanDown( node, d, total, target );
+        }
+      }
+    if( up )
+      {
+      total += m_Counts[ node * Base + d ];
+      }
+    pos = prefix;
+  }
+
+private:
+  typedef unsigned int NodeIdType;
+
+  enum { LevelBits = 8,
+         Base = 1 << LevelBits,
+         Levels = ( VKeyBits + LevelBits - 1 ) / LevelBits };
+
+  // the root is never the child of another node
+  enum { Root = 0, NoNode = 0 };
+
+  std::vector< unsigned long > m_Counts;
+  std::vector< NodeIdType > m_Children;
+  std::vector< NodeIdType > m_FreeNodes;
+
+  static unsigned int Digit(const KeyType &key, unsigned int level)
+  {
+    return ( key >> ( level * LevelBits ) ) & ( Base - 1 );
+  }
+
+  static bool IsMissing(const NodeIdType * path, unsigned int level)
+  {
+    return level + 1 < Levels && path[level] == NoNode;
+  }
+
+  NodeIdType NewNode()
+  {
+    if( !m_FreeNodes.empty() )
+      {
+      const NodeIdType node = m_FreeNodes.back();
+      m_FreeNodes.pop_back();
+      return node;
+      }
+    const NodeIdType node = static_cast< NodeIdType >( m_Counts.size() / Base );
+    m_Counts.resize( m_Counts.size() + Base, 0 );
+    m_Children.resize( m_Children.size() + Base, NoNode );
+    return node;
+  }
+
+  // search the entries of node after d for the one where the number of
+  // pixels reaches target. total is not updated with the found entry.
+  bool ScanUp(NodeIdType node, int &d, unsigned long &total, unsigned long target) const
+  {
+    const unsigned long * counts = &m_Counts[ node * Base ];
+    for( ++d; d<Base; ++d )
+      {
+      if( total + counts[d] >= target )
+        {
+        return true;
+        }
+      total += counts[d];
+      }
+    return false;
+  }
+
+  // search the entries of node before d for the last one where the number
+  // of pixels is still at least target. total includes the found entry.
+  bool ScanDown(NodeIdType node, int &d, unsigned long &total, unsigned long target) const
+  {
+    const unsigned long * counts = &m_Counts[ node * Base ];
+    while( d > 0 )
+      {
+      --d;
+      if( total - counts[d] < target )
+        {
+        return true;
+        }
+      total -= counts[d];
+      }
+    return false;
+  }
+};
+
+} // end namespace itk
+
+#endif
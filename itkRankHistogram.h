@@ -2,6 +2,20 @@
 #ifndef __itkRankHistogram_h
 #define __itkRankHistogram_h
 #include "itkNumericTraits.h"
+#include <functional>
+
+#include "itkRebindHistogramCount.h"
+#include "itkRadixHistogramCounts.h"
+
+// the vector instructions used to sum the bins of RankHistogramVec
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ITK_RANK_HISTOGRAM_AVX2
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define ITK_RANK_HISTOGRAM_SSE2
+#endif
 
 namespace itk {
 
@@ -13,6 +27,11 @@ namespace itk {
 // Support for different TCompare hasn't been tested, and shouldn't be
 // necessary for the rank filters.
 //
+// The base class only stores the rank: there is no virtual method, and
+// the filters are instantiated with the concrete histogram type chosen
+// by RankHistogramSelector, so the histogram methods can be inlined in
+// the moving histogram loop.
+//
 #include <sstream>
 
 template <class TInputPixel>
@@ -23,27 +42,17 @@ public:
   {
     m_Rank = 0.5;
   }
-  virtual ~RankHistogram(){}
+  ~RankHistogram(){}
 
-  virtual RankHistogram *Clone(){return 0;}
-  
-  virtual void AddPixel(const TInputPixel &p){}
-
-  virtual void RemovePixel(const TInputPixel &p){}
- 
   void AddBoundary(){}
 
   void RemoveBoundary(){}
  
-  virtual TInputPixel GetValue( const TInputPixel & ){return 0;}
-
   void SetRank(float rank)
   {
     m_Rank = rank;
   }
 
-//   virtual std::string PrintHist(){return("");}
-
 protected:
   float m_Rank;
 };
@@ -191,28 +200,107 @@ public:
 
   }
 
-  RankHistogramMap * Clone()
-   {
-    RankHistogramMap *result = new RankHistogramMap();
-    result->m_Map = this->m_Map;
-    result->m_Rank = this->m_Rank;
-    result->m_Below = this->m_Below;
-    result->m_Entries = this->m_Entries;
-    result->m_InitVal = this->m_InitVal;
-    result->m_RankValue = this->m_RankValue;
-    result->m_Initialized = this->m_Initialized;
-    if (result->m_Initialized)
-      result->m_RankIt = result->m_Map.find(this->m_RankValue);
-    return(result);
-   }
+  // the rank iterator points in the map of the source histogram: it
+  // must be looked up again in the copy
+  RankHistogramMap(const RankHistogramMap & h) : RankHistogram<TInputPixel>(h)
+  {
+    *this = h;
+  }
+
+  RankHistogramMap & operator=(const RankHistogramMap & h)
+  {
+    if (this != &h)
+      {
+      m_Map = h.m_Map;
+      this->m_Rank = h.m_Rank;
+      m_Below = h.m_Below;
+      m_Entries = h.m_Entries;
+      m_InitVal = h.m_InitVal;
+      m_RankValue = h.m_RankValue;
+      m_Initialized = h.m_Initialized;
+      if (m_Initialized)
+        m_RankIt = m_Map.find(m_RankValue);
+      else
+        m_RankIt = m_Map.begin();
+      }
+    return *this;
+  }
+
+  RankHistogramMap *Clone()
+  {
+    return new RankHistogramMap(*this);
+  }
 
 };
 
-template <class TInputPixel, class TCompare>
+// the sum of the 8 counts starting at p, used by the rank search of
+// RankHistogramVec. The sum can't overflow the count type: it is at
+// most the number of pixels in the histogram.
+template <class TCount>
+inline unsigned long RankHistogramSumBlock( const TCount * p )
+{
+  return (unsigned long)( ( p[0] + p[1] ) + ( p[2] + p[3] ) + ( p[4] + p[5] ) + ( p[6] + p[7] ) );
+}
+
+#if defined(ITK_RANK_HISTOGRAM_SSE2)
+inline unsigned long RankHistogramHorizontalSum( __m128i s )
+{
+  s = _mm_add_epi32( s, _mm_shuffle_epi32( s, _MM_SHUFFLE(1, 0, 3, 2) ) );
+  s = _mm_add_epi32( s, _mm_shuffle_epi32( s, _MM_SHUFFLE(2, 3, 0, 1) ) );
+  return (unsigned int)_mm_cvtsi128_si32( s );
+}
+
+template <>
+inline unsigned long RankHistogramSumBlock<unsigned short>( const unsigned short * p )
+{
+  __m128i v = _mm_loadu_si128( (const __m128i *)p );
+  __m128i zero = _mm_setzero_si128();
+  return RankHistogramHorizontalSum( _mm_add_epi32( _mm_unpacklo_epi16( v, zero ),
+                                                    _mm_unpackhi_epi16( v, zero ) ) );
+}
+
+template <>
+inline unsigned long RankHistogramSumBlock<unsigned int>( const unsigned int * p )
+{
+  return RankHistogramHorizontalSum( _mm_add_epi32( _mm_loadu_si128( (const __m128i *)p ),
+                                                    _mm_loadu_si128( (const __m128i *)(p + 4) ) ) );
+}
+#endif
+
+// the 64 bit version, where unsigned long is a 64 bit integer
+#if defined(__LP64__) && defined(ITK_RANK_HISTOGRAM_AVX2)
+template <>
+inline unsigned long RankHistogramSumBlock<unsigned long>( const unsigned long * p )
+{
+  __m256i s = _mm256_add_epi64( _mm256_loadu_si256( (const __m256i *)p ),
+                                _mm256_loadu_si256( (const __m256i *)(p + 4) ) );
+  __m128i h = _mm_add_epi64( _mm256_castsi256_si128( s ),
+                             _mm256_extracti128_si256( s, 1 ) );
+  h = _mm_add_epi64( h, _mm_unpackhi_epi64( h, h ) );
+  return (unsigned long)_mm_cvtsi128_si64( h );
+}
+#elif defined(__LP64__) && defined(ITK_RANK_HISTOGRAM_SSE2)
+template <>
+inline unsigned long RankHistogramSumBlock<unsigned long>( const unsigned long * p )
+{
+  __m128i s = _mm_add_epi64(
+    _mm_add_epi64( _mm_loadu_si128( (const __m128i *)p ),
+                   _mm_loadu_si128( (const __m128i *)(p + 2) ) ),
+    _mm_add_epi64( _mm_loadu_si128( (const __m128i *)(p + 4) ),
+                   _mm_loadu_si128( (const __m128i *)(p + 6) ) ) );
+  s = _mm_add_epi64( s, _mm_unpackhi_epi64( s, s ) );
+  return (unsigned long)_mm_cvtsi128_si64( s );
+}
+#endif
+
+// TCount is the type used to count the pixels in a bin. The moving
+// histogram filters select the narrowest type able to count all the
+// pixels of the kernel, through RebindHistogramCount.
+template <class TInputPixel, class TCompare, class TCount = unsigned long>
 class RankHistogramVec : public RankHistogram<TInputPixel>
 {
-private:
-  typedef typename std::vector<unsigned long> VecType;
+protected:
+  typedef typename std::vector<TCount> VecType;
   
   VecType m_Vec;
   unsigned int m_Size;
@@ -224,6 +312,9 @@ private:
   int m_Below;
   int m_Entries;
 
+  // the number of bins summed at once by Locate()
+  enum { BlockSize = 8 };
+
 public:
   RankHistogramVec() 
   {
@@ -262,6 +353,21 @@ public:
   }
 
 
+  // the same histogram, with another count type
+  template <class TOtherCount>
+  explicit RankHistogramVec( const RankHistogramVec<TInputPixel, TCompare, TOtherCount> & h )
+  {
+    m_Vec.assign( h.m_Vec.begin(), h.m_Vec.end() );
+    m_Size = h.m_Size;
+    m_InitVal = h.m_InitVal;
+    m_Entries = h.m_Entries;
+    m_Below = h.m_Below;
+    this->m_Rank = h.m_Rank;
+    m_RankValue = h.m_RankValue;
+  }
+
+  template <class, class, class> friend class RankHistogramVec;
+
   ~RankHistogramVec()
   {
   }
@@ -272,8 +378,31 @@ public:
     unsigned long total = m_Below;
     long unsigned int pos = (long unsigned int)(m_RankValue - NumericTraits< TInputPixel >::NonpositiveMin()); 
 
+    Locate( pos, total, target );
+
+    m_RankValue = (TInputPixel)(pos + NumericTraits< TInputPixel >::NonpositiveMin());
+    m_Below = total;
+    return(m_RankValue);
+  }
+
+  // move the bin position pos, with total pixels up to and including
+  // pos, to the first bin where the number of pixels reaches target.
+  // Whole blocks of bins are skipped while the target is not reached
+  // inside them, then the search ends bin by bin. The result is the same
+  // as with a walk over single bins, as the total is monotonic in a
+  // block.
+  void Locate(unsigned long &pos, unsigned long &total, unsigned long target) const
+  {
     if (total < target)
       {
+      while (pos + BlockSize < m_Size)
+	{
+	unsigned long sum = RankHistogramSumBlock( &m_Vec[pos + 1] );
+	if (total + sum >= target)
+	  break;
+	total += sum;
+	pos += BlockSize;
+	}
       while (pos < m_Size)
 	{
 	++pos;
@@ -284,19 +413,23 @@ public:
       }
     else
       {
+      while (pos >= BlockSize)
+	{
+	unsigned long sum = RankHistogramSumBlock( &m_Vec[pos + 1 - BlockSize] );
+	if (total - sum < target)
+	  break;
+	total -= sum;
+	pos -= BlockSize;
+	}
       while(pos > 0)
 	{
-	unsigned int tbelow = total - m_Vec[pos];
+	unsigned long tbelow = total - m_Vec[pos];
 	if (tbelow < target) // we've overshot
 	  break;
 	total = tbelow;
 	--pos;
 	}
       }
-
-    m_RankValue = (TInputPixel)(pos + NumericTraits< TInputPixel >::NonpositiveMin());
-    m_Below = total;
-    return(m_RankValue);
   }
 
   void AddPixel(const TInputPixel &p)
@@ -340,5 +473,447 @@ public:
 
 };
 
+// A radix histogram for the integer types which are too large to be
+// stored in a flat vector (16 and 32 bits). The bins are the leaves of a
+// tree of 256 entries nodes, one level per byte of the value, where the
+// other nodes count the pixels of their subtrees - see
+// RadixHistogramCounts. The rank search jumps over the subtrees which
+// don't contain the rank value instead of walking all the bins between
+// the old and the new rank value, and the nodes are only allocated while
+// they contain a pixel.
+//
+// With 16 bits pixels, a rank value is found in at most 1024 steps, and
+// the histogram of a 12 bits image stays smaller than 60 KB. With 32 bits
+// pixels, the histogram only grows with the number of distinct values in
+// the kernel.
+template <class TInputPixel, class TCompare>
+class RankHistogramRadix : public RankHistogram<TInputPixel>
+{
+protected:
+  typedef RadixHistogramCounts< sizeof(TInputPixel) * 8 > CountsType;
+
+  // the offset of the pixel value from the smallest possible value
+  typedef typename CountsType::KeyType KeyType;
+
+  CountsType m_Counts;
+  KeyType m_RankKey;
+  unsigned long m_Below;
+  unsigned long m_Entries;
+
+  static KeyType ToKey(const TInputPixel &p)
+  {
+    // the computation is done in the unsigned type, so it can't
+    // overflow, even for the 32 bits signed types
+    return static_cast< KeyType >( p ) - 
+      static_cast< KeyType >( NumericTraits< TInputPixel >::NonpositiveMin() );
+  }
+
+  static TInputPixel ToPixel(const KeyType &k)
+  {
+    return static_cast< TInputPixel >( k + 
+      static_cast< KeyType >( NumericTraits< TInputPixel >::NonpositiveMin() ) );
+  }
+
+public:
+  RankHistogramRadix() 
+  {
+    // start at the end of the histogram: all the added pixels are
+    // below the rank value, and the first search goes down
+    m_RankKey = ToKey( NumericTraits< TInputPixel >::max() );
+    m_Entries = m_Below = 0;
+  }
+
+  ~RankHistogramRadix()
+  {
+  }
+
+  TInputPixel GetValue( const TInputPixel & )
+  {
+    unsigned long target = (unsigned long)(this->m_Rank * (m_Entries-1)) + 1;
+
+    assert( m_Entries > 0 );
+
+    Locate( m_RankKey, m_Below, target );
+    return ToPixel( m_RankKey );
+  }
+
+  void AddPixel(const TInputPixel &p)
+  {
+    KeyType key = ToKey( p );
+    AddKey( key );
+    if( key <= m_RankKey )
+      {
+      ++m_Below;
+      }
+  }
+
+  void RemovePixel(const TInputPixel &p)
+  {
+    KeyType key = ToKey( p );
+    RemoveKey( key );
+    if( key <= m_RankKey )
+      {
+      --m_Below;
+      }
+  }
+ 
+  // move the key pos, with total pixels up to and including pos, to the
+  // first key where the number of pixels reaches target
+  void Locate(KeyType &pos, unsigned long &total, unsigned long target) const
+  {
+    m_Counts.Locate( pos, total, target );
+  }
+
+  // update the bins, but not the position of the rank value
+  void AddKey(const KeyType &key)
+  {
+    m_Counts.AddKey( key );
+    ++m_Entries;
+  }
+
+  void RemoveKey(const KeyType &key)
+  {
+    assert( m_Entries >= 1 );
+    m_Counts.RemoveKey( key );
+    --m_Entries;
+  }
+
+  RankHistogramRadix * Clone()
+   {
+    RankHistogramRadix *result = new RankHistogramRadix(*this);
+    return(result);
+   }
+
+};
+
+// An order statistic tree for the pixel types which can't be stored in a
+// vector (float, double, 64 bits integers...). It is a treap where each
+// node stores the number of pixels of its value and the number of pixels
+// in its subtree, so the rank value is found in O(log n) by a single
+// descent from the root, without walking over the values in between.
+//
+// The nodes are stored in a single vector and refer to each other by
+// their position, so the tree can be copied in one block. The nodes
+// removed from the tree are chained in a free list and reused by the
+// next insertions: once the histogram has seen the largest number of
+// distinct values in the kernel, it doesn't allocate memory anymore.
+template <class TInputPixel, class TCompare>
+class RankHistogramTree : public RankHistogram<TInputPixel>
+{
+protected:
+  typedef unsigned int NodeIdType;
+
+  struct Node
+  {
+    TInputPixel value;
+    unsigned long count;
+    // number of pixels in the subtree
+    unsigned long sum;
+    NodeIdType left;
+    NodeIdType right;
+    unsigned int priority;
+  };
+
+  typedef typename std::vector<Node> NodeVecType;
+
+  // the node 0 is a sentinel with an empty subtree - it is used as the
+  // null pointer
+  NodeVecType m_Nodes;
+  NodeIdType m_Root;
+  NodeIdType m_FreeList;
+  unsigned int m_Seed;
+  unsigned long m_Entries;
+  TCompare m_Compare;
+
+  unsigned int NextPriority()
+  {
+    // xorshift - the priorities only have to be random enough to keep
+    // the tree balanced, and must be reproducible
+    m_Seed ^= m_Seed << 13;
+    m_Seed ^= m_Seed >> 17;
+    m_Seed ^= m_Seed << 5;
+    return m_Seed;
+  }
+
+  NodeIdType NewNode(const TInputPixel &p)
+  {
+    NodeIdType n = m_FreeList;
+    if( n != 0 )
+      {
+      m_FreeList = m_Nodes[n].left;
+      }
+    else
+      {
+      n = static_cast< NodeIdType >( m_Nodes.size() );
+      m_Nodes.push_back( m_Nodes[0] );
+      }
+    Node & node = m_Nodes[n];
+    node.value = p;
+    node.count = 1;
+    node.sum = 1;
+    node.left = 0;
+    node.right = 0;
+    node.priority = NextPriority();
+    return n;
+  }
+
+  void FreeNode(NodeIdType n)
+  {
+    m_Nodes[n].left = m_FreeList;
+    m_FreeList = n;
+  }
+
+  void UpdateSum(NodeIdType n)
+  {
+    Node & node = m_Nodes[n];
+    node.sum = node.count + m_Nodes[node.left].sum + m_Nodes[node.right].sum;
+  }
+
+  NodeIdType RotateRight(NodeIdType n)
+  {
+    NodeIdType l = m_Nodes[n].left;
+    m_Nodes[n].left = m_Nodes[l].right;
+    m_Nodes[l].right = n;
+    UpdateSum( n );
+    UpdateSum( l );
+    return l;
+  }
+
+  NodeIdType RotateLeft(NodeIdType n)
+  {
+    NodeIdType r = m_Nodes[n].right;
+    m_Nodes[n].right = m_Nodes[r].left;
+    m_Nodes[r].left = n;
+    UpdateSum( n );
+    UpdateSum( r );
+    return r;
+  }
+
+  NodeIdType Insert(NodeIdType n, const TInputPixel &p)
+  {
+    if( n == 0 )
+      {
+      return NewNode( p );
+      }
+    // don't keep a reference on the node: the vector may be reallocated
+    // by NewNode()
+    m_Nodes[n].sum++;
+    if( m_Compare( p, m_Nodes[n].value ) )
+      {
+      NodeIdType l = Insert( m_Nodes[n].left, p );
+      m_Nodes[n].left = l;
+      if( m_Nodes[l].priority > m_Nodes[n].priority )
+        {
+        n = RotateRight( n );
+        }
+      }
+    else if( m_Compare( m_Nodes[n].value, p ) )
+      {
+      NodeIdType r = Insert( m_Nodes[n].right, p );
+      m_Nodes[n].right = r;
+      if( m_Nodes[r].priority > m_Nodes[n].priority )
+        {
+        n = RotateLeft( n );
+        }
+      }
+    else
+      {
+      m_Nodes[n].count++;
+      }
+    return n;
+  }
+
+  NodeIdType Merge(NodeIdType a, NodeIdType b)
+  {
+    if( a == 0 )
+      {
+      return b;
+      }
+    if( b == 0 )
+      {
+      return a;
+      }
+    if( m_Nodes[a].priority > m_Nodes[b].priority )
+      {
+      m_Nodes[a].right = Merge( m_Nodes[a].right, b );
+      UpdateSum( a );
+      return a;
+      }
+    m_Nodes[b].left = Merge( a, m_Nodes[b].left );
+    UpdateSum( b );
+    return b;
+  }
+
+  NodeIdType Remove(NodeIdType n, const TInputPixel &p)
+  {
+    assert( n != 0 );
+    Node & node = m_Nodes[n];
+    node.sum--;
+    if( m_Compare( p, node.value ) )
+      {
+      node.left = Remove( node.left, p );
+      }
+    else if( m_Compare( node.value, p ) )
+      {
+      node.right = Remove( node.right, p );
+      }
+    else if( --node.count == 0 )
+      {
+      // the value is not in the kernel anymore - recycle the node
+      NodeIdType m = Merge( node.left, node.right );
+      FreeNode( n );
+      return m;
+      }
+    return n;
+  }
+
+public:
+  RankHistogramTree() 
+  {
+    Node sentinel;
+    sentinel.value = NumericTraits< TInputPixel >::Zero;
+    sentinel.count = sentinel.sum = 0;
+    sentinel.left = sentinel.right = 0;
+    sentinel.priority = 0;
+    m_Nodes.push_back( sentinel );
+    m_Root = m_FreeList = 0;
+    m_Seed = 2463534242U;
+    m_Entries = 0;
+  }
+
+  ~RankHistogramTree()
+  {
+  }
+
+  void AddPixel(const TInputPixel &p)
+  {
+    m_Root = Insert( m_Root, p );
+    ++m_Entries;
+  }
+
+  void RemovePixel(const TInputPixel &p)
+  {
+    assert( m_Entries >= 1 );
+    m_Root = Remove( m_Root, p );
+    --m_Entries;
+  }
+
+  TInputPixel GetValue( const TInputPixel & )
+  {
+    unsigned long target = (unsigned long)(this->m_Rank * (m_Entries-1)) + 1;
+
+    // an assert is better than a log message in that case
+    assert( m_Entries > 0 );
+
+    return ValueAt( target );
+  }
+
+  // the smallest value with at least target pixels up to it
+  TInputPixel ValueAt(unsigned long target) const
+  {
+    NodeIdType n = m_Root;
+    while( true )
+      {
+      const Node & node = m_Nodes[n];
+      unsigned long left = m_Nodes[node.left].sum;
+      if( target <= left )
+        {
+        n = node.left;
+        }
+      else if( target <= left + node.count )
+        {
+        return node.value;
+        }
+      else
+        {
+        target -= left + node.count;
+        n = node.right;
+        }
+      }
+  }
+
+  RankHistogramTree * Clone()
+   {
+    RankHistogramTree *result = new RankHistogramTree(*this);
+    return(result);
+   }
+
+};
+
+// The flat vector histogram counting its pixels with TCount
+template <class TInputPixel, class TCompare, class TOldCount, class TCount>
+class RebindHistogramCount< RankHistogramVec< TInputPixel, TCompare, TOldCount >, TCount >
+{
+public:
+  typedef RankHistogramVec< TInputPixel, TCompare, TCount > Type;
+};
+
+// Select at compile time the histogram to use for a pixel type: a flat
+// vector for the 8 bits types, the radix histogram for the 16 and 32
+// bits integers and the order statistic tree for all the other types.
+
+template <class TInputPixel, class TCompare = std::less< TInputPixel > >
+class RankHistogramSelector
+{
+public:
+  typedef RankHistogramTree< TInputPixel, TCompare > Type;
+};
+
+template <class TCompare>
+class RankHistogramSelector< bool, TCompare >
+{
+public:
+  typedef RankHistogramVec< bool, TCompare > Type;
+};
+
+template <class TCompare>
+class RankHistogramSelector< char, TCompare >
+{
+public:
+  typedef RankHistogramVec< char, TCompare > Type;
+};
+
+template <class TCompare>
+class RankHistogramSelector< signed char, TCompare >
+{
+public:
+  typedef RankHistogramVec< signed char, TCompare > Type;
+};
+
+template <class TCompare>
+class RankHistogramSelector< unsigned char, TCompare >
+{
+public:
+  typedef RankHistogramVec< unsigned char, TCompare > Type;
+};
+
+template <class TCompare>
+class RankHistogramSelector< short, TCompare >
+{
+public:
+  typedef RankHistogramRadix< short, TCompare > Type;
+};
+
+template <class TCompare>
+class RankHistogramSelector< unsigned short, TCompare >
+{
+public:
+  typedef RankHistogramRadix< unsigned short, TCompare > Type;
+};
+
+template <class TCompare>
+class RankHistogramSelector< int, TCompare >
+{
+public:
+  typedef RankHistogramRadix< int, TCompare > Type;
+};
+
+template <class TCompare>
+class RankHistogramSelector< unsigned int, TCompare >
+{
+public:
+  typedef RankHistogramRadix< unsigned int, TCompare > Type;
+};
+
 } // end namespace itk
 #endif
@@ -2,6 +2,9 @@
 #ifndef __itkRankHistogramMask_h
 #define __itkRankHistogramMask_h
 #include "itkNumericTraits.h"
+#include "itkRebindHistogramCount.h"
+#include "itkRadixHistogramCounts.h"
+#include <functional>
 
 namespace itk {
 
@@ -15,6 +18,9 @@ namespace itk {
 //
 // This is a modified version for use with masks. Need to allow for
 // the situation in which the map is empty
+//
+// As for RankHistogram, the base class has no virtual method: the
+// concrete type is chosen at compile time by RankHistogramMaskSelector.
 template <class TInputPixel>
 class RankHistogramMask
 {
@@ -23,24 +29,7 @@ public:
   {
     m_Rank = 0.5;
   }
-  virtual ~RankHistogramMask(){}
-
-  virtual RankHistogramMask *Clone(){return 0;}
-  
-  virtual void Reset(){}
-    
-  virtual void AddPixel(const TInputPixel &p){}
-
-  virtual void RemovePixel(const TInputPixel &p){}
- 
-  // For the map based version - to be called after there is some data
-  // included. Meant to be an optimization so that the rank value
-  // iterator is properly set.
-//  virtual void Initialize(){};
-
-  virtual bool IsValid() {}
-
-  virtual TInputPixel GetValue( const TInputPixel & ){}
+  ~RankHistogramMask(){}
 
   void SetRank(float rank)
   {
@@ -91,19 +80,35 @@ public:
   {
   }
 
+  // the rank iterator points in the map of the source histogram: it
+  // must be looked up again in the copy
+  RankHistogramMaskMap(const RankHistogramMaskMap & h) : RankHistogramMask<TInputPixel>(h)
+  {
+    *this = h;
+  }
+
+  RankHistogramMaskMap & operator=(const RankHistogramMaskMap & h)
+  {
+    if (this != &h)
+      {
+      m_Map = h.m_Map;
+      this->m_Rank = h.m_Rank;
+      m_Below = h.m_Below;
+      m_Entries = h.m_Entries;
+      m_InitVal = h.m_InitVal;
+      m_RankValue = h.m_RankValue;
+      m_Initialized = h.m_Initialized;
+      if (m_Initialized)
+        m_RankIt = m_Map.find(m_RankValue);
+      else
+        m_RankIt = m_Map.begin();
+      }
+    return *this;
+  }
+
   RankHistogramMaskMap *Clone()
   {
-    RankHistogramMaskMap *result = new RankHistogramMaskMap();
-    result->m_Map = this->m_Map;
-    result->m_Rank = this->m_Rank;
-    result->m_Below = this->m_Below;
-    result->m_Entries = this->m_Entries;
-    result->m_InitVal = this->m_InitVal;
-    result->m_RankValue = this->m_RankValue;
-    result->m_Initialized = this->m_Initialized;
-    if (result->m_Initialized)
-      result->m_RankIt = result->m_Map.find(this->m_RankValue);
-    return(result);
+    return new RankHistogramMaskMap(*this);
   }
   void Reset()
   {
@@ -152,7 +157,7 @@ public:
 //     m_RankIt = m_Map.begin();
 //   }
 
-  virtual bool IsValid()
+  bool IsValid()
    {
    return m_Initialized;
    }
@@ -258,11 +263,13 @@ public:
 #endif
 };
 
-template <class TInputPixel, class TCompare>
+// TCount is the type used to count the pixels in a bin - see
+// RankHistogramVec
+template <class TInputPixel, class TCompare, class TCount = unsigned long>
 class RankHistogramMaskVec : public RankHistogramMask<TInputPixel>
 {
 private:
-  typedef typename std::vector<unsigned long> VecType;
+  typedef typename std::vector<TCount> VecType;
   
   VecType m_Vec;
   unsigned int m_Size;
@@ -312,6 +319,21 @@ public:
   }
 
 
+  // the same histogram, with another count type
+  template <class TOtherCount>
+  explicit RankHistogramMaskVec( const RankHistogramMaskVec<TInputPixel, TCompare, TOtherCount> & h )
+  {
+    m_Vec.assign( h.m_Vec.begin(), h.m_Vec.end() );
+    m_Size = h.m_Size;
+    m_InitVal = h.m_InitVal;
+    m_Entries = h.m_Entries;
+    m_Below = h.m_Below;
+    this->m_Rank = h.m_Rank;
+    m_RankValue = h.m_RankValue;
+  }
+
+  template <class, class, class> friend class RankHistogramMaskVec;
+
   ~RankHistogramMaskVec()
   {
   }
@@ -330,7 +352,7 @@ public:
     return(result);
   }
 
-  virtual bool IsValid()
+  bool IsValid()
    {
    return m_Entries > 0;
    }
@@ -370,7 +392,7 @@ public:
   }
 
   void Reset(){
-    std::fill(&(m_Vec[0]), &(m_Vec[m_Size-1]),0);
+    std::fill(m_Vec.begin(), m_Vec.end(), 0);
     m_RankValue = m_InitVal;
     m_Entries = m_Below = 0;
   }
@@ -402,5 +424,428 @@ public:
  
 };
 
+// A radix histogram for the integer types which are too large to be
+// stored in a flat vector (16 and 32 bits).
+//
+// This is the version for use with masks - see RankHistogramRadix.
+template <class TInputPixel, class TCompare>
+class RankHistogramMaskRadix : public RankHistogramMask<TInputPixel>
+{
+private:
+  typedef RadixHistogramCounts< sizeof(TInputPixel) * 8 > CountsType;
+
+  // the offset of the pixel value from the smallest possible value
+  typedef typename CountsType::KeyType KeyType;
+
+  CountsType m_Counts;
+  KeyType m_RankKey;
+  unsigned long m_Below;
+  unsigned long m_Entries;
+
+  static KeyType ToKey(const TInputPixel &p)
+  {
+    // the computation is done in the unsigned type, so it can't
+    // overflow, even for the 32 bits signed types
+    return static_cast< KeyType >( p ) - 
+      static_cast< KeyType >( NumericTraits< TInputPixel >::NonpositiveMin() );
+  }
+
+  static TInputPixel ToPixel(const KeyType &k)
+  {
+    return static_cast< TInputPixel >( k + 
+      static_cast< KeyType >( NumericTraits< TInputPixel >::NonpositiveMin() ) );
+  }
+
+public:
+  RankHistogramMaskRadix() 
+  {
+    // start at the end of the histogram: all the added pixels are
+    // below the rank value, and the first search goes down
+    m_RankKey = ToKey( NumericTraits< TInputPixel >::max() );
+    m_Entries = m_Below = 0;
+  }
+
+  ~RankHistogramMaskRadix()
+  {
+  }
+
+  TInputPixel GetValue( const TInputPixel & )
+  {
+    unsigned long target = (unsigned long)(this->m_Rank * (m_Entries-1)) + 1;
+
+    assert( m_Entries > 0 );
+
+    m_Counts.Locate( m_RankKey, m_Below, target );
+    return ToPixel( m_RankKey );
+  }
+
+  void AddPixel(const TInputPixel &p)
+  {
+    KeyType key = ToKey( p );
+    m_Counts.AddKey( key );
+    if( key <= m_RankKey )
+      {
+      ++m_Below;
+      }
+    ++m_Entries;
+  }
+
+  void RemovePixel(const TInputPixel &p)
+  {
+    KeyType key = ToKey( p );
+    assert( m_Entries >= 1 );
+    m_Counts.RemoveKey( key );
+    --m_Entries;
+    if( key <= m_RankKey )
+      {
+      --m_Below;
+      }
+  }
+ 
+  RankHistogramMaskRadix * Clone()
+   {
+    RankHistogramMaskRadix *result = new RankHistogramMaskRadix(*this);
+    return(result);
+   }
+
+  void Reset()
+  {
+    // keep the allocated nodes - they are likely to be used again
+    m_Counts.Reset();
+    m_RankKey = ToKey( NumericTraits< TInputPixel >::max() );
+    m_Entries = m_Below = 0;
+  }
+
+  bool IsValid()
+   {
+   return m_Entries > 0;
+   }
+
+};
+
+// This is the version for use with masks - see RankHistogramTree.
+template <class TInputPixel, class TCompare>
+class RankHistogramMaskTree : public RankHistogramMask<TInputPixel>
+{
+private:
+  typedef unsigned int NodeIdType;
+
+  struct Node
+  {
+    TInputPixel value;
+    unsigned long count;
+    // number of pixels in the subtree
+    unsigned long sum;
+    NodeIdType left;
+    NodeIdType right;
+    unsigned int priority;
+  };
+
+  typedef typename std::vector<Node> NodeVecType;
+
+  // the node 0 is a sentinel with an empty subtree - it is used as the
+  // null pointer
+  NodeVecType m_Nodes;
+  NodeIdType m_Root;
+  NodeIdType m_FreeList;
+  unsigned int m_Seed;
+  unsigned long m_Entries;
+  TCompare m_Compare;
+
+  unsigned int NextPriority()
+  {
+    // xorshift - the priorities only have to be random enough to keep
+    // the tree balanced, and must be reproducible
+    m_Seed ^= m_Seed << 13;
+    m_Seed ^= m_Seed >> 17;
+    m_Seed ^= m_Seed << 5;
+    return m_Seed;
+  }
+
+  NodeIdType NewNode(const TInputPixel &p)
+  {
+    NodeIdType n = m_FreeList;
+    if( n != 0 )
+      {
+      m_FreeList = m_Nodes[n].left;
+      }
+    else
+      {
+      n = static_cast< NodeIdType >( m_Nodes.size() );
+      m_Nodes.push_back( m_Nodes[0] );
+      }
+    Node & node = m_Nodes[n];
+    node.value = p;
+    node.count = 1;
+    node.sum = 1;
+    node.left = 0;
+    node.right = 0;
+    node.priority = NextPriority();
+    return n;
+  }
+
+  void FreeNode(NodeIdType n)
+  {
+    m_Nodes[n].left = m_FreeList;
+    m_FreeList = n;
+  }
+
+  void UpdateSum(NodeIdType n)
+  {
+    Node & node = m_Nodes[n];
+    node.sum = node.count + m_Nodes[node.left].sum + m_Nodes[node.right].sum;
+  }
+
+  NodeIdType RotateRight(NodeIdType n)
+  {
+    NodeIdType l = m_Nodes[n].left;
+    m_Nodes[n].left = m_Nodes[l].right;
+    m_Nodes[l].right = n;
+    UpdateSum( n );
+    UpdateSum( l );
+    return l;
+  }
+
+  NodeIdType RotateLeft(NodeIdType n)
+  {
+    NodeIdType r = m_Nodes[n].right;
+    m_Nodes[n].right = m_Nodes[r].left;
+    m_Nodes[r].left = n;
+    UpdateSum( n );
+    UpdateSum( r );
+    return r;
+  }
+
+  NodeIdType Insert(NodeIdType n, const TInputPixel &p)
+  {
+    if( n == 0 )
+      {
+      return NewNode( p );
+      }
+    // don't keep a reference on the node: the vector may be reallocated
+    // by NewNode()
+    m_Nodes[n].sum++;
+    if( m_Compare( p, m_Nodes[n].value ) )
+      {
+      NodeIdType l = Insert( m_Nodes[n].left, p );
+      m_Nodes[n].left = l;
+      if( m_Nodes[l].priority > m_Nodes[n].priority )
+        {
+        n = RotateRight( n );
+        }
+      }
+    else if( m_Compare( m_Nodes[n].value, p ) )
+      {
+      NodeIdType r = Insert( m_Nodes[n].right, p );
+      m_Nodes[n].right = r;
+      if( m_Nodes[r].priority > m_Nodes[n].priority )
+        {
+        n = RotateLeft( n );
+        }
+      }
+    else
+      {
+      m_Nodes[n].count++;
+      }
+    return n;
+  }
+
+  NodeIdType Merge(NodeIdType a, NodeIdType b)
+  {
+    if( a == 0 )
+      {
+      return b;
+      }
+    if( b == 0 )
+      {
+      return a;
+      }
+    if( m_Nodes[a].priority > m_Nodes[b].priority )
+      {
+      m_Nodes[a].right = Merge( m_Nodes[a].right, b );
+      UpdateSum( a );
+      return a;
+      }
+    m_Nodes[b].left = Merge( a, m_Nodes[b].left );
+    UpdateSum( b );
+    return b;
+  }
+
+  NodeIdType Remove(NodeIdType n, const TInputPixel &p)
+  {
+    assert( n != 0 );
+    Node & node = m_Nodes[n];
+    node.sum--;
+    if( m_Compare( p, node.value ) )
+      {
+      node.left = Remove( node.left, p );
+      }
+    else if( m_Compare( node.value, p ) )
+      {
+      node.right = Remove( node.right, p );
+      }
+    else if( --node.count == 0 )
+      {
+      // the value is not in the kernel anymore - recycle the node
+      NodeIdType m = Merge( node.left, node.right );
+      FreeNode( n );
+      return m;
+      }
+    return n;
+  }
+
+public:
+  RankHistogramMaskTree() 
+  {
+    Node sentinel;
+    sentinel.value = NumericTraits< TInputPixel >::Zero;
+    sentinel.count = sentinel.sum = 0;
+    sentinel.left = sentinel.right = 0;
+    sentinel.priority = 0;
+    m_Nodes.push_back( sentinel );
+    m_Root = m_FreeList = 0;
+    m_Seed = 2463534242U;
+    m_Entries = 0;
+  }
+
+  ~RankHistogramMaskTree()
+  {
+  }
+
+  void AddPixel(const TInputPixel &p)
+  {
+    m_Root = Insert( m_Root, p );
+    ++m_Entries;
+  }
+
+  void RemovePixel(const TInputPixel &p)
+  {
+    assert( m_Entries >= 1 );
+    m_Root = Remove( m_Root, p );
+    --m_Entries;
+  }
+
+  TInputPixel GetValue( const TInputPixel & )
+  {
+    unsigned long target = (unsigned long)(this->m_Rank * (m_Entries-1)) + 1;
+    NodeIdType n = m_Root;
+
+    assert( m_Entries > 0 );
+
+    while( true )
+      {
+      const Node & node = m_Nodes[n];
+      unsigned long left = m_Nodes[node.left].sum;
+      if( target <= left )
+        {
+        n = node.left;
+        }
+      else if( target <= left + node.count )
+        {
+        return node.value;
+        }
+      else
+        {
+        target -= left + node.count;
+        n = node.right;
+        }
+      }
+  }
+
+  RankHistogramMaskTree * Clone()
+   {
+    RankHistogramMaskTree *result = new RankHistogramMaskTree(*this);
+    return(result);
+   }
+
+  void Reset()
+  {
+    // keep the memory already allocated for the nodes
+    m_Nodes.resize( 1 );
+    m_Root = m_FreeList = 0;
+    m_Entries = 0;
+  }
+
+  bool IsValid()
+   {
+   return m_Entries > 0;
+   }
+
+};
+
+// The flat vector histogram counting its pixels with TCount
+template <class TInputPixel, class TCompare, class TOldCount, class TCount>
+class RebindHistogramCount< RankHistogramMaskVec< TInputPixel, TCompare, TOldCount >, TCount >
+{
+public:
+  typedef RankHistogramMaskVec< TInputPixel, TCompare, TCount > Type;
+};
+
+// Select at compile time the histogram to use for a pixel type - see
+// RankHistogramSelector.
+
+template <class TInputPixel, class TCompare = std::less< TInputPixel > >
+class RankHistogramMaskSelector
+{
+public:
+  typedef RankHistogramMaskTree< TInputPixel, TCompare > Type;
+};
+
+template <class TCompare>
+class RankHistogramMaskSelector< bool, TCompare >
+{
+public:
+  typedef RankHistogramMaskVec< bool, TCompare > Type;
+};
+
+template <class TCompare>
+class RankHistogramMaskSelector< char, TCompare >
+{
+public:
+  typedef RankHistogramMaskVec< char, TCompare > Type;
+};
+
+template <class TCompare>
+class RankHistogramMaskSelector< signed char, TCompare >
+{
+public:
+  typedef RankHistogramMaskVec< signed char, TCompare > Type;
+};
+
+template <class TCompare>
+class RankHistogramMaskSelector< unsigned char, TCompare >
+{
+public:
+  typedef RankHistogramMaskVec< unsigned char, TCompare > Type;
+};
+
+template <class TCompare>
+class RankHistogramMaskSelector< short, TCompare >
+{
+public:
+  typedef RankHistogramMaskRadix< short, TCompare > Type;
+};
+
+template <class TCompare>
+class RankHistogramMaskSelector< unsigned short, TCompare >
+{
+public:
+  typedef RankHistogramMaskRadix< unsigned short, TCompare > Type;
+};
+
+template <class TCompare>
+class RankHistogramMaskSelector< int, TCompare >
+{
+public:
+  typedef RankHistogramMaskRadix< int, TCompare > Type;
+};
+
+template <class TCompare>
+class RankHistogramMaskSelector< unsigned int, TCompare >
+{
+public:
+  typedef RankHistogramMaskRadix< unsigned int, TCompare > Type;
+};
+
 } // end namespace itk
 #endif
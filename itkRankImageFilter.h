@@ -23,6 +23,9 @@
 #include <set>
 #include "itkOffsetLexicographicCompare.h"
 #include "itkRankHistogram.h"
+#include "itkRankSelectionNetwork.h"
+#include "itkVanHerkGilWermanLine.h"
+#include <vector>
 
 namespace itk {
 
@@ -42,6 +45,23 @@ namespace itk {
  * implementation. The extensions to Huang are support for arbitary
  * pixel types (using c++ maps) and arbitary neighborhoods. I presume
  * that these are not new ideas.
+ *
+ * The histogram implementation is chosen at compile time from the
+ * input pixel type (see RankHistogramSelector), so the per pixel
+ * histogram updates are not virtual calls.
+ *
+ * The small box kernels, with at most 32 pixels (3x3, 5x5, 3x3x3, ...),
+ * don't use the moving histogram by default: the rank is selected with
+ * a compare-exchange network (see RankSelectionNetwork) applied at once
+ * to many adjacent pixels of a line. The 3x3 median sorts the columns of
+ * three pixels once, and reuses them for the three neighborhoods they
+ * belong to. The moving histogram is still used at the image boundary,
+ * where the neighborhood is cropped.
+ *
+ * With a box kernel, the ranks 0 and 1 are the minimum and the maximum
+ * in the box, which are separable. They are computed by default with
+ * the algorithm of van Herk and Gil-Werman along each axis (see
+ * VanHerkGilWermanLine), at a cost per pixel independent of the radius.
  * 
  * This filter is based on the sliding window code from the
  * consolidatedMorphology package on InsightJournal.
@@ -55,12 +75,12 @@ namespace itk {
 
 template<class TInputImage, class TOutputImage, class TKernel >
 class ITK_EXPORT RankImageFilter : 
-    public MovingHistogramImageFilter<TInputImage, TOutputImage, TKernel, RankHistogram< typename TInputImage::PixelType > >
+    public MovingHistogramImageFilter<TInputImage, TOutputImage, TKernel, typename RankHistogramSelector< typename TInputImage::PixelType >::Type >
 {
 public:
   /** Standard class typedefs. */
   typedef RankImageFilter Self;
-  typedef MovingHistogramImageFilter<TInputImage,TOutputImage, TKernel, RankHistogram< typename TInputImage::PixelType > >  Superclass;
+  typedef MovingHistogramImageFilter<TInputImage,TOutputImage, TKernel, typename RankHistogramSelector< typename TInputImage::PixelType >::Type >  Superclass;
   typedef SmartPointer<Self>        Pointer;
   typedef SmartPointer<const Self>  ConstPointer;
   
@@ -99,37 +119,156 @@ public:
   itkSetMacro(Rank, float)
   itkGetMacro(Rank, float)
 
+  /** Replace the input values by their position in the sorted table of
+   * the distinct values of the input image before computing the rank,
+   * and map the result back to the input values. The result is exactly
+   * the same, but the rank is computed with the vector based histograms
+   * on the positions, instead of the tree based histogram on the values.
+   * This is mostly useful for float and double images. The table is
+   * built with a sort of the image, so the option is only worth for
+   * the large enough kernels. The NaN values are ordered after all the
+   * other values, +infinity included, and are all in the same position
+   * of the table: a rank falling on a NaN pixel of the neighborhood
+   * gives NaN. Defaults to false. */
+  itkSetMacro(UseRankRemapping, bool);
+  itkGetMacro(UseRankRemapping, bool);
+  itkBooleanMacro(UseRankRemapping);
+
+  /** Select the rank with a compare-exchange network instead of the
+   * moving histogram when the kernel is a box of at most
+   * RankSelectionNetwork::MaximumSize pixels. The result is the same.
+   * Defaults to true. */
+  itkSetMacro(UseSelectionNetwork, bool);
+  itkGetMacro(UseSelectionNetwork, bool);
+  itkBooleanMacro(UseSelectionNetwork);
+
+  /** Compute the ranks 0 and 1 of a box kernel with the algorithm of
+   * van Herk and Gil-Werman instead of the moving histogram. The result
+   * is the same. Defaults to true. */
+  itkSetMacro(UseVanHerkGilWerman, bool);
+  itkGetMacro(UseVanHerkGilWerman, bool);
+  itkBooleanMacro(UseVanHerkGilWerman);
+
 protected:
   RankImageFilter();
   ~RankImageFilter() {};
 
-  typedef RankHistogram<InputPixelType> HistogramType;
-  
-  typedef RankHistogramVec<InputPixelType, std::less< InputPixelType> > VHistogram;
-  typedef RankHistogramMap<InputPixelType, std::less< InputPixelType>  > MHistogram;
-  
-  void PrintSelf(std::ostream& os, Indent indent) const;
-  
-  bool useVectorBasedHistogram()
-  {
-    // bool, short and char are acceptable for vector based algorithm: they do not require
-    // too much memory. Other types are not usable with that algorithm
-    return typeid(InputPixelType) == typeid(unsigned char)
-      || typeid(InputPixelType) == typeid(signed char)
-//       || typeid(InputPixelType) == typeid(unsigned short)
-//       || typeid(InputPixelType) == typeid(signed short)
-      || typeid(InputPixelType) == typeid(bool);
-  }
+  /** Choose between the moving histogram, the van Herk/Gil-Werman
+   * algorithm and the selection network, and build the network */
+  void BeforeThreadedGenerateData();
+
+  void ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+                            int threadId);
+
+  /** Compute the output with the moving histogram, or with the rank
+   * remapping if UseRankRemapping is on */
+  void GenerateData();
+
+  typedef std::vector<InputPixelType> ValueTableType;
+
+  /** The order of the value table: the usual order, with the NaN values
+   * after all the other ones, so the sort and the search are well
+   * defined on the float images with NaN pixels */
+  static bool RemapLess( const InputPixelType & a, const InputPixelType & b )
+    {
+    return a < b || ( b != b && a == a );
+    }
+
+  static bool RemapEqual( const InputPixelType & a, const InputPixelType & b )
+    {
+    return !RemapLess( a, b ) && !RemapLess( b, a );
+    }
 
+  /** Compute the output on the positions of the pixels in the value
+   * table, stored in an image of type TCodeImage */
+  template <class TCodeImage>
+  void GenerateDataWithCodes( const ValueTableType & values );
+
+  typedef typename Superclass::HistogramType HistogramType;
+
+  void PrintSelf(std::ostream& os, Indent indent) const;
 
   virtual HistogramType * NewHistogram();
 
+  typedef typename Superclass::FaceListType FaceListType;
+  typedef typename Superclass::OffsetListType OffsetListType;
+  typedef typename Superclass::OffsetValueType OffsetValueType;
+  typedef typename Superclass::InputInternalPixelType InputInternalPixelType;
+  typedef typename Superclass::InputAccessorType InputAccessorType;
+  typedef typename Superclass::OutputInternalPixelType OutputInternalPixelType;
+  typedef typename Superclass::OutputAccessorType OutputAccessorType;
+
+  /** Run the selection network on the interior block of the faces, and
+   * the moving histogram on the boundary faces */
+  void ThreadedGenerateDataWithNetworkOnFaces(const FaceListType& faces,
+                                              const HistogramType & emptyHistogram,
+                                              std::vector<HistogramType> & HistVec,
+                                              InputPixelType * values,
+                                              ProgressReporter & progress);
+
+  /** Run the selection network on a region where the kernel is inside
+   * the input requested region. The lines along the first axis are
+   * processed by batches of NetworkBatchSize pixels. values is the work
+   * area of the network. */
+  void ThreadedGenerateDataWithNetworkOnRegion(const OutputImageRegionType& region,
+                                               InputPixelType * values,
+                                               ProgressReporter & progress);
+
+  /** The 3x3 median of n adjacent pixels, from the three lines of the
+   * neighborhood, starting one pixel before the first output pixel */
+  void ColumnMedian3x3(const InputInternalPixelType * up,
+                       const InputInternalPixelType * center,
+                       const InputInternalPixelType * down,
+                       InputPixelType * low,
+                       InputPixelType * mid,
+                       InputPixelType * high,
+                       const InputAccessorType & accessor,
+                       OutputInternalPixelType * outPtr,
+                       const OutputAccessorType & outAccessor,
+                       unsigned int n);
+
+  /** Compute the minimum (TCompare is std::less) or the maximum
+   * (TCompare is std::greater) in the box with the van Herk/Gil-Werman
+   * algorithm. identity is used for the pixels outside the image. */
+  template <class TCompare>
+  void ThreadedGenerateDataWithVanHerkGilWerman(const OutputImageRegionType& outputRegionForThread,
+                                                int threadId,
+                                                const InputPixelType & identity);
+
+  /** Run one pass of van Herk/Gil-Werman per axis on the region. The
+   * passes work on the region, padded by the radius on the axes not
+   * processed yet, in a buffer allocated for the region. */
+  template <class TCompare>
+  void VanHerkGilWermanOnRegion(const OutputImageRegionType& region,
+                                const InputPixelType & identity,
+                                ProgressReporter & progress);
+
 private:
   RankImageFilter(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
 
   float m_Rank;
 
+  bool m_UseRankRemapping;
+
+  bool m_UseSelectionNetwork;
+
+  bool m_UseVanHerkGilWerman;
+
+  // the number of pixels processed at once by the network
+  enum { NetworkBatchSize = 64 };
+
+  // whether van Herk/Gil-Werman is used in the current execution
+  bool m_VanHerkGilWermanEnabled;
+
+  // whether the network is used in the current execution, and the
+  // network and the offsets of the kernel in the input buffer. They are
+  // only valid during the execution of the filter.
+  bool m_NetworkEnabled;
+  bool m_ColumnMedian3x3;
+  RankSelectionNetwork m_Network;
+  std::vector< OffsetValueType > m_NetworkOffsets;
+
 } ; // end of class
 
 } // end namespace itk
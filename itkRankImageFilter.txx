@@ -27,9 +27,12 @@
 #include "itkImageRegionIterator.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkImageLinearConstIteratorWithIndex.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkProgressAccumulator.h"
 
 #include <iomanip>
 #include <sstream>
+#include <algorithm>
 
 namespace itk {
 
@@ -39,6 +42,12 @@ RankImageFilter<TInputImage, TOutputImage, TKernel>
 ::RankImageFilter()
 {
   m_Rank = 0.5;
+  m_UseRankRemapping = false;
+  m_UseSelectionNetwork = true;
+  m_UseVanHerkGilWerman = true;
+  m_VanHerkGilWermanEnabled = false;
+  m_NetworkEnabled = false;
+  m_ColumnMedian3x3 = false;
 }
 
 
@@ -47,17 +56,525 @@ typename RankImageFilter<TInputImage, TOutputImage, TKernel>::HistogramType *
 RankImageFilter<TInputImage, TOutputImage, TKernel>
 ::NewHistogram()
 {
-  HistogramType * hist;
-  if (useVectorBasedHistogram())
+  HistogramType * hist = new HistogramType();
+  hist->SetRank( this->GetRank() );
+  return hist;
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+void
+RankImageFilter<TInputImage, TOutputImage, TKernel>
+::GenerateData()
+{
+  if( !m_UseRankRemapping )
     {
-    hist = new VHistogram();
+    // the usual multithreaded moving histogram
+    Superclass::GenerateData();
+    return;
+    }
+
+  this->AllocateOutputs();
+
+  // build the sorted table of the distinct values of the input image
+  const InputImageType * inputImage = this->GetInput();
+  ValueTableType values;
+  values.reserve( inputImage->GetRequestedRegion().GetNumberOfPixels() );
+  ImageRegionConstIterator< InputImageType > it( inputImage, inputImage->GetRequestedRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    values.push_back( it.Get() );
+    }
+  std::sort( values.begin(), values.end(), RemapLess );
+  values.erase( std::unique( values.begin(), values.end(), RemapEqual ), values.end() );
+
+  // and use the smallest type able to store the positions in the table,
+  // so the rank filter on the positions uses the smallest histogram
+  if( values.size() <= 256 )
+    {
+    this->template GenerateDataWithCodes< Image< unsigned char, ImageDimension > >( values );
+    }
+  else if( values.size() <= 65536 )
+    {
+    this->template GenerateDataWithCodes< Image< unsigned short, ImageDimension > >( values );
     }
   else
     {
-    hist = new MHistogram();
+    this->template GenerateDataWithCodes< Image< unsigned int, ImageDimension > >( values );
+    }
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+template<class TCodeImage>
+void
+RankImageFilter<TInputImage, TOutputImage, TKernel>
+::GenerateDataWithCodes( const ValueTableType & values )
+{
+  typedef TCodeImage CodeImageType;
+  typedef typename CodeImageType::PixelType CodeType;
+  typedef RankImageFilter< CodeImageType, CodeImageType, TKernel > CodeRankType;
+
+  const InputImageType * inputImage = this->GetInput();
+  OutputImageType * outputImage = this->GetOutput();
+
+  // replace the values by their position in the table
+  typename CodeImageType::Pointer codes = CodeImageType::New();
+  codes->CopyInformation( inputImage );
+  codes->SetBufferedRegion( inputImage->GetRequestedRegion() );
+  codes->SetRequestedRegion( inputImage->GetRequestedRegion() );
+  codes->Allocate();
+
+  ImageRegionConstIterator< InputImageType > iit( inputImage, inputImage->GetRequestedRegion() );
+  ImageRegionIterator< CodeImageType > cit( codes, inputImage->GetRequestedRegion() );
+  for( iit.GoToBegin(), cit.GoToBegin(); !iit.IsAtEnd(); ++iit, ++cit )
+    {
+    cit.Set( static_cast< CodeType >( 
+      std::lower_bound( values.begin(), values.end(), iit.Get(), RemapLess ) - values.begin() ) );
+    }
+
+  // the ranks are the same on the positions and on the values
+  typename CodeRankType::Pointer rank = CodeRankType::New();
+  rank->SetInput( codes );
+  rank->SetKernel( this->GetKernel() );
+  rank->SetRank( m_Rank );
+  rank->SetNumberOfThreads( this->GetNumberOfThreads() );
+  rank->SetUseDynamicScheduling( this->GetUseDynamicScheduling() );
+  rank->SetNumberOfLinesPerChunk( this->GetNumberOfLinesPerChunk() );
+  rank->SetUseSelectionNetwork( m_UseSelectionNetwork );
+  rank->SetUseVanHerkGilWerman( m_UseVanHerkGilWerman );
+
+  ProgressAccumulator::Pointer progress = ProgressAccumulator::New();
+  progress->SetMiniPipelineFilter( this );
+  progress->RegisterInternalFilter( rank, 1.0f );
+
+  rank->GetOutput()->SetRequestedRegion( outputImage->GetRequestedRegion() );
+  rank->Update();
+
+  // map the positions back to the values
+  ImageRegionConstIterator< CodeImageType > rit( rank->GetOutput(), outputImage->GetRequestedRegion() );
+  ImageRegionIterator< OutputImageType > oit( outputImage, outputImage->GetRequestedRegion() );
+  for( rit.GoToBegin(), oit.GoToBegin(); !oit.IsAtEnd(); ++rit, ++oit )
+    {
+    oit.Set( static_cast< OutputPixelType >( values[ rit.Get() ] ) );
+    }
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+void
+RankImageFilter<TInputImage, TOutputImage, TKernel>
+::BeforeThreadedGenerateData()
+{
+  Superclass::BeforeThreadedGenerateData();
+
+  // the other algorithms are only used on the box kernels: all the
+  // pixels of the kernel are in the neighborhood
+  const unsigned long count = this->GetKernelPixelCount();
+  const bool box = count == this->GetKernel().Size();
+
+  // the minimum and the maximum in a box are separable
+  m_VanHerkGilWermanEnabled = m_UseVanHerkGilWerman && box
+    && ( m_Rank == 0 || m_Rank == 1 );
+
+  // the network is only used on the small kernels
+  m_NetworkEnabled = m_UseSelectionNetwork && box && !m_VanHerkGilWermanEnabled
+    && count <= (unsigned long)RankSelectionNetwork::MaximumSize;
+  m_ColumnMedian3x3 = false;
+  m_NetworkOffsets.clear();
+  if( !m_NetworkEnabled )
+    {
+    return;
+    }
+
+  // the same position as the one reached by the histograms
+  const unsigned long rank = (unsigned long)( m_Rank * ( count - 1 ) );
+  m_Network.Initialize( count, rank );
+  m_ColumnMedian3x3 = ImageDimension == 2 && count == 9 && rank == 4
+    && this->GetKernel().GetSize()[0] == 3;
+
+  const OffsetValueType * offsetTable = this->GetInput()->GetOffsetTable();
+  for( typename OffsetListType::const_iterator listIt = this->m_KernelOffsets.begin(); listIt != this->m_KernelOffsets.end(); listIt++ )
+    {
+    OffsetValueType l = 0;
+    for( unsigned int axis=0; axis<ImageDimension; axis++ )
+      {
+      l += (*listIt)[axis] * offsetTable[axis];
+      }
+    m_NetworkOffsets.push_back( l );
+    }
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+void
+RankImageFilter<TInputImage, TOutputImage, TKernel>
+::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+                       int threadId)
+{
+  if( m_VanHerkGilWermanEnabled )
+    {
+    if( m_Rank == 0 )
+      {
+      this->template ThreadedGenerateDataWithVanHerkGilWerman< std::less< InputPixelType > >(
+        outputRegionForThread, threadId, VanHerkGilWermanIdentity< InputPixelType >::Minimum() );
+      }
+    else
+      {
+      this->template ThreadedGenerateDataWithVanHerkGilWerman< std::greater< InputPixelType > >(
+        outputRegionForThread, threadId, VanHerkGilWermanIdentity< InputPixelType >::Maximum() );
+      }
+    return;
+    }
+
+  if( !m_NetworkEnabled )
+    {
+    Superclass::ThreadedGenerateData( outputRegionForThread, threadId );
+    return;
+    }
+
+  // the histogram is only used on the boundary faces, where the
+  // neighborhood is cropped
+  HistogramType * histogram = this->NewHistogram();
+  std::vector<HistogramType> HistVec( ImageDimension, *histogram );
+  // the work area of the network. It is not a std::vector, which
+  // doesn't give a pointer to its values when the pixel type is bool
+  InputPixelType * values = new InputPixelType[ m_Network.GetSize() * NetworkBatchSize ];
+  FaceListType faces;
+
+  if( this->m_UseDynamicScheduling )
+    {
+    ProgressReporter progress(this, threadId, this->m_NumberOfLinesPerThread);
+    OutputImageRegionType chunk;
+    while( this->GetNextChunk( chunk ) )
+      {
+      this->ComputeFaces( chunk, faces );
+      this->ThreadedGenerateDataWithNetworkOnFaces( faces, *histogram, HistVec, values, progress );
+      }
+    }
+  else
+    {
+    this->ComputeFaces( outputRegionForThread, faces );
+    // the interior block is traversed along the first axis by the
+    // network, instead of the line direction of the histogram
+    unsigned long nbOfLines = this->GetNumberOfLines( faces );
+    const OutputImageRegionType & interior = faces.front();
+    if( interior.GetNumberOfPixels() > 0 )
+      {
+      nbOfLines += interior.GetNumberOfPixels() / interior.GetSize()[0]
+        - interior.GetNumberOfPixels() / interior.GetSize()[this->m_Axes[ImageDimension - 1]];
+      }
+    ProgressReporter progress(this, threadId, nbOfLines);
+    this->ThreadedGenerateDataWithNetworkOnFaces( faces, *histogram, HistVec, values, progress );
+    }
+  delete [] values;
+  delete histogram;
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+template<class TCompare>
+void
+RankImageFilter<TInputImage, TOutputImage, TKernel>
+::ThreadedGenerateDataWithVanHerkGilWerman(const OutputImageRegionType& outputRegionForThread,
+                                           int threadId,
+                                           const InputPixelType & identity)
+{
+  if( this->m_UseDynamicScheduling )
+    {
+    ProgressReporter progress(this, threadId, this->m_NumberOfLinesPerThread);
+    OutputImageRegionType chunk;
+    while( this->GetNextChunk( chunk ) )
+      {
+      this->template VanHerkGilWermanOnRegion< TCompare >( chunk, identity, progress );
+      }
+    }
+  else if( outputRegionForThread.GetNumberOfPixels() > 0 )
+    {
+    // the progress is reported on the lines of the last pass
+    ProgressReporter progress(this, threadId, outputRegionForThread.GetNumberOfPixels()
+                              / outputRegionForThread.GetSize()[ImageDimension - 1]);
+    this->template VanHerkGilWermanOnRegion< TCompare >( outputRegionForThread, identity, progress );
+    }
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+template<class TCompare>
+void
+RankImageFilter<TInputImage, TOutputImage, TKernel>
+::VanHerkGilWermanOnRegion(const OutputImageRegionType& region,
+                           const InputPixelType & identity,
+                           ProgressReporter & progress)
+{
+  if( region.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+
+  const InputImageType * inputImage = this->GetInput();
+  OutputImageType * outputImage = this->GetOutput();
+  const RegionType & inputRegion = inputImage->GetRequestedRegion();
+  const RadiusType radius = this->GetKernel().GetRadius();
+
+  InputAccessorType inAccessor = inputImage->GetNeighborhoodAccessor();
+  const InputInternalPixelType * inBuffer = inputImage->GetBufferPointer();
+  inAccessor.SetBegin( inBuffer );
+  OutputAccessorType outAccessor = outputImage->GetNeighborhoodAccessor();
+  OutputInternalPixelType * outBuffer = outputImage->GetBufferPointer();
+  outAccessor.SetBegin( outBuffer );
+
+  // available[a] is the region where the values are known before the
+  // pass along the axis a: the region, padded by the radius on the axes
+  // a and above, and cropped by the input requested region
+  RegionType available[ImageDimension + 1];
+  available[0] = region;
+  available[0].PadByRadius( radius );
+  available[0].Crop( inputRegion );
+  long maxLength = 0;
+  for( unsigned int a=0; a<ImageDimension; a++ )
+    {
+    IndexType idx = available[a].GetIndex();
+    SizeType size = available[a].GetSize();
+    maxLength = std::max( maxLength, (long)size[a] );
+    idx[a] = region.GetIndex()[a];
+    size[a] = region.GetSize()[a];
+    available[a+1] = RegionType( idx, size );
+    }
+
+  // the results of the passes before the last one are stored in a
+  // buffer covering the largest of these regions. It is not a
+  // std::vector, which doesn't give a pointer to its values when the
+  // pixel type is bool.
+  const RegionType & bufferRegion = available[1];
+  InputPixelType * buffer = 0;
+  OffsetValueType bufferStrides[ImageDimension];
+  OffsetValueType stride = 1;
+  for( unsigned int a=0; a<ImageDimension; a++ )
+    {
+    bufferStrides[a] = stride;
+    stride *= bufferRegion.GetSize()[a];
+    }
+  if( ImageDimension > 1 )
+    {
+    buffer = new InputPixelType[ bufferRegion.GetNumberOfPixels() ];
+    }
+
+  InputPixelType * line = new InputPixelType[ maxLength ];
+  InputPixelType * result = new InputPixelType[ maxLength ];
+  VanHerkGilWermanLine< InputPixelType, TCompare > engine( identity );
+
+  for( unsigned int a=0; a<ImageDimension; a++ )
+    {
+    // the first pass reads the input, and the last one writes the output
+    const bool fromInput = ( a == 0 );
+    const bool toOutput = ( a == ImageDimension - 1 );
+    const long n = available[a].GetSize()[a];
+    const long begin = region.GetIndex()[a] - available[a].GetIndex()[a];
+    const long end = begin + region.GetSize()[a];
+    const OffsetValueType inStride = fromInput ? inputImage->GetOffsetTable()[a] : bufferStrides[a];
+    const OffsetValueType outStride = toOutput ? outputImage->GetOffsetTable()[a] : bufferStrides[a];
+
+    // one line per position of the region computed by the pass, with
+    // the axis a removed
+    SizeType linesSize = available[a+1].GetSize();
+    linesSize[a] = 1;
+    RegionType lines( available[a+1].GetIndex(), linesSize );
+    ImageRegionConstIteratorWithIndex< InputImageType > lineIt( inputImage, lines );
+    for( lineIt.GoToBegin(); !lineIt.IsAtEnd(); ++lineIt )
+      {
+      IndexType idx = lineIt.GetIndex();
+      idx[a] = available[a].GetIndex()[a];
+      OffsetValueType bufferOffset = 0;
+      for( unsigned int i=0; i<ImageDimension; i++ )
+        {
+        bufferOffset += ( idx[i] - bufferRegion.GetIndex()[i] ) * bufferStrides[i];
+        }
+
+      if( fromInput )
+        {
+        const InputInternalPixelType * inPtr = inBuffer + inputImage->ComputeOffset( idx );
+        for( long k=0; k<n; k++, inPtr += inStride )
+          {
+          line[k] = inAccessor.Get( inPtr );
+          }
+        }
+      else
+        {
+        const InputPixelType * inPtr = buffer + bufferOffset;
+        for( long k=0; k<n; k++, inPtr += inStride )
+          {
+          line[k] = *inPtr;
+          }
+        }
+
+      engine.Compute( line, n, begin, end, radius[a], result );
+
+      if( toOutput )
+        {
+        idx[a] = region.GetIndex()[a];
+        OutputInternalPixelType * outPtr = outBuffer + outputImage->ComputeOffset( idx );
+        for( long k=0; k<end-begin; k++, outPtr += outStride )
+          {
+          outAccessor.Set( outPtr, static_cast< OutputPixelType >( result[k] ) );
+          }
+        progress.CompletedPixel();
+        }
+      else
+        {
+        InputPixelType * outPtr = buffer + ( bufferOffset + begin * outStride );
+        for( long k=0; k<end-begin; k++, outPtr += outStride )
+          {
+          *outPtr = result[k];
+          }
+        }
+      }
+    }
+
+  delete [] line;
+  delete [] result;
+  delete [] buffer;
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+void
+RankImageFilter<TInputImage, TOutputImage, TKernel>
+::ThreadedGenerateDataWithNetworkOnFaces(const FaceListType& faces,
+                                         const HistogramType & emptyHistogram,
+                                         std::vector<HistogramType> & HistVec,
+                                         InputPixelType * values,
+                                         ProgressReporter & progress)
+{
+  bool interior = true;
+  for( typename FaceListType::const_iterator fit = faces.begin(); fit != faces.end(); fit++ )
+    {
+    if( fit->GetNumberOfPixels() > 0 )
+      {
+      if( interior )
+        {
+        this->ThreadedGenerateDataWithNetworkOnRegion( *fit, values, progress );
+        }
+      else
+        {
+        this->ThreadedGenerateDataOnRegion( *fit, false, emptyHistogram, HistVec, progress );
+        }
+      }
+    interior = false;
+    }
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+void
+RankImageFilter<TInputImage, TOutputImage, TKernel>
+::ThreadedGenerateDataWithNetworkOnRegion(const OutputImageRegionType& region,
+                                          InputPixelType * values,
+                                          ProgressReporter & progress)
+{
+  const InputImageType * inputImage = this->GetInput();
+  OutputImageType * outputImage = this->GetOutput();
+
+  InputAccessorType inAccessor = inputImage->GetNeighborhoodAccessor();
+  const InputInternalPixelType * inBuffer = inputImage->GetBufferPointer();
+  inAccessor.SetBegin( inBuffer );
+  OutputAccessorType outAccessor = outputImage->GetNeighborhoodAccessor();
+  OutputInternalPixelType * outBuffer = outputImage->GetBufferPointer();
+  outAccessor.SetBegin( outBuffer );
+
+  const long lineLength = region.GetSize()[0];
+  const unsigned int size = m_Network.GetSize();
+  const unsigned int rank = m_Network.GetRank();
+  // only used by the 3x3 median
+  const OffsetValueType lineStride = inputImage->GetOffsetTable()[1];
+  InputPixelType * v = values;
+
+  typedef ImageLinearConstIteratorWithIndex< InputImageType > InputLineIteratorType;
+  InputLineIteratorType lineIt( inputImage, region );
+  lineIt.SetDirection( 0 );
+  lineIt.GoToBegin();
+  while( !lineIt.IsAtEnd() )
+    {
+    const IndexType lineStart = lineIt.GetIndex();
+    const InputInternalPixelType * inPtr = inBuffer + inputImage->ComputeOffset( lineStart );
+    OutputInternalPixelType * outPtr = outBuffer + outputImage->ComputeOffset( lineStart );
+    for( long x=0; x<lineLength; x+=NetworkBatchSize, inPtr+=NetworkBatchSize, outPtr+=NetworkBatchSize )
+      {
+      const unsigned int n = std::min( (long)NetworkBatchSize, lineLength - x );
+      if( m_ColumnMedian3x3 )
+        {
+        this->ColumnMedian3x3( inPtr - lineStride - 1, inPtr - 1, inPtr + lineStride - 1,
+                               v, v + NetworkBatchSize + 2, v + 2 * ( NetworkBatchSize + 2 ),
+                               inAccessor, outPtr, outAccessor, n );
+        }
+      else
+        {
+        // store the neighborhoods of the n pixels side by side, by
+        // position in the kernel
+        for( unsigned int k=0; k<size; k++ )
+          {
+          const InputInternalPixelType * p = inPtr + m_NetworkOffsets[k];
+          InputPixelType * vk = v + k * NetworkBatchSize;
+          for( unsigned int j=0; j<n; j++ )
+            {
+            vk[j] = inAccessor.Get( p + j );
+            }
+          }
+        m_Network.Select( v, NetworkBatchSize, n );
+        const InputPixelType * selected = v + rank * NetworkBatchSize;
+        for( unsigned int j=0; j<n; j++ )
+          {
+          outAccessor.Set( outPtr + j, static_cast< OutputPixelType >( selected[j] ) );
+          }
+        }
+      }
+    progress.CompletedPixel();
+    lineIt.NextLine();
+    }
+}
+
+
+template<class TInputImage, class TOutputImage, class TKernel>
+void
+RankImageFilter<TInputImage, TOutputImage, TKernel>
+::ColumnMedian3x3(const InputInternalPixelType * up,
+                  const InputInternalPixelType * center,
+                  const InputInternalPixelType * down,
+                  InputPixelType * low,
+                  InputPixelType * mid,
+                  InputPixelType * high,
+                  const InputAccessorType & accessor,
+                  OutputInternalPixelType * outPtr,
+                  const OutputAccessorType & outAccessor,
+                  unsigned int n)
+{
+  // sort the n+2 columns once: each of them is shared by three
+  // neighborhoods
+  for( unsigned int c=0; c<n+2; c++ )
+    {
+    const InputPixelType a = accessor.Get( up + c );
+    const InputPixelType b = accessor.Get( center + c );
+    const InputPixelType d = accessor.Get( down + c );
+    const InputPixelType mn = std::min( a, b );
+    const InputPixelType mx = std::max( a, b );
+    low[c] = std::min( mn, d );
+    mid[c] = std::max( mn, std::min( mx, d ) );
+    high[c] = std::max( mx, d );
+    }
+
+  // the median of the nine values is the median of the largest low, of
+  // the median of the middles and of the smallest high
+  for( unsigned int j=0; j<n; j++ )
+    {
+    const InputPixelType lo = std::max( std::max( low[j], low[j+1] ), low[j+2] );
+    const InputPixelType hi = std::min( std::min( high[j], high[j+1] ), high[j+2] );
+    const InputPixelType mn = std::min( mid[j], mid[j+1] );
+    const InputPixelType mx = std::max( mid[j], mid[j+1] );
+    const InputPixelType me = std::max( mn, std::min( mx, mid[j+2] ) );
+    const InputPixelType a = std::min( lo, me );
+    const InputPixelType b = std::max( lo, me );
+    outAccessor.Set( outPtr + j, static_cast< OutputPixelType >( std::max( a, std::min( b, hi ) ) ) );
     }
-  hist->SetRank( this->GetRank() );
-  return hist;
 }
 
 
@@ -69,6 +586,9 @@ RankImageFilter<TInputImage, TOutputImage, TKernel>
   Superclass::PrintSelf(os, indent);
 
   os << indent << "Rank: " << static_cast<typename NumericTraits< float >::PrintType>( m_Rank ) << std::endl;
+  os << indent << "UseRankRemapping: " << m_UseRankRemapping << std::endl;
+  os << indent << "UseSelectionNetwork: " << m_UseSelectionNetwork << std::endl;
+  os << indent << "UseVanHerkGilWerman: " << m_UseVanHerkGilWerman << std::endl;
 }
 
 }// end namespace itk
@@ -0,0 +1,166 @@
+#ifndef __itkRankSelectionNetwork_h
+#define __itkRankSelectionNetwork_h
+
+#include <vector>
+#include <algorithm>
+
+namespace itk {
+
+/**
+ * \class RankSelectionNetwork
+ * \brief A compare-exchange network selecting one rank in a small set of values
+ *
+ * The network is the odd-even merge sort of Batcher, reduced to the
+ * compare-exchanges which have an effect on the value found at the
+ * selected position once the values are sorted. The compare-exchanges
+ * touching a position past the last value are removed too: the values
+ * behave as if they were padded with the largest value, so the number of
+ * values doesn't have to be a power of two.
+ *
+ * The network is applied to many sets of values at once. The values are
+ * stored by position, with the sets side by side, so a compare-exchange
+ * is a loop of std::min and std::max over the sets, without any branch
+ * depending on the values, which the compiler can vectorize.
+ *
+ * RankImageFilter uses it on the small box kernels, where it is cheaper
+ * than the moving histogram.
+ */
+class RankSelectionNetwork
+{
+public:
+  /** The largest number of values supported */
+  enum { MaximumSize = 32 };
+
+  RankSelectionNetwork()
+    {
+    m_Size = 0;
+    m_Rank = 0;
+    }
+
+  /** Build the network selecting the value at position rank (starting
+   * at 0) among size sorted values */
+  void Initialize( unsigned int size, unsigned int rank )
+    {
+    m_Size = size;
+    m_Rank = rank;
+    m_Comparisons.clear();
+
+    // the odd-even merge sort on the next power of two
+    unsigned int n = 1;
+    while( n < size )
+      {
+      n <<= 1;
+      }
+    std::vector< Comparison > sort;
+    for( unsigned int p=1; p<n; p<<=1 )
+      {
+      for( unsigned int k=p; k>=1; k>>=1 )
+        {
+        for( unsigned int j=k%p; j+k<n; j+=2*k )
+          {
+          for( unsigned int i=0; i<std::min( k, n-j-k ); i++ )
+            {
+            if( (i+j)/(2*p) == (i+j+k)/(2*p) && i+j+k < size )
+              {
+              Comparison c;
+              c.Low = i + j;
+              c.High = i + j + k;
+              sort.push_back( c );
+              }
+            }
+          }
+        }
+      }
+
+    // walk the sort backward, and keep the compare-exchanges producing
+    // a value needed later. Their two inputs are then needed.
+    std::vector< bool > needed( size, false );
+    if( rank < size )
+      {
+      needed[rank] = true;
+      }
+    for( std::vector< Comparison >::reverse_iterator it=sort.rbegin(); it!=sort.rend(); it++ )
+      {
+      it->WriteLow = needed[it->Low];
+      it->WriteHigh = needed[it->High];
+      if( it->WriteLow || it->WriteHigh )
+        {
+        needed[it->Low] = true;
+        needed[it->High] = true;
+        m_Comparisons.push_back( *it );
+        }
+      }
+    std::reverse( m_Comparisons.begin(), m_Comparisons.end() );
+    }
+
+  unsigned int GetSize() const
+    {
+    return m_Size;
+    }
+
+  unsigned int GetRank() const
+    {
+    return m_Rank;
+    }
+
+  unsigned int GetNumberOfComparisons() const
+    {
+    return m_Comparisons.size();
+    }
+
+  /** Apply the network to nb sets of values. The value at the position i
+   * of the set j is values[i*stride+j]. The selected value of the set j
+   * is then values[GetRank()*stride+j]. The other positions are left in
+   * an unspecified order. */
+  template <class TValue>
+  void Select( TValue * values, unsigned int stride, unsigned int nb ) const
+    {
+    for( std::vector< Comparison >::const_iterator it=m_Comparisons.begin(); it!=m_Comparisons.end(); it++ )
+      {
+      TValue * low = values + it->Low * stride;
+      TValue * high = values + it->High * stride;
+      if( it->WriteLow && it->WriteHigh )
+        {
+        for( unsigned int j=0; j<nb; j++ )
+          {
+          const TValue a = low[j];
+          const TValue b = high[j];
+          low[j] = std::min( a, b );
+          high[j] = std::max( a, b );
+          }
+        }
+      else if( it->WriteLow )
+        {
+        for( unsigned int j=0; j<nb; j++ )
+          {
+          low[j] = std::min( low[j], high[j] );
+          }
+        }
+      else
+        {
+        for( unsigned int j=0; j<nb; j++ )
+          {
+          high[j] = std::max( low[j], high[j] );
+          }
+        }
+      }
+    }
+
+private:
+  struct Comparison
+    {
+    unsigned int Low;
+    unsigned int High;
+    // whether the minimum and the maximum are used later
+    bool WriteLow;
+    bool WriteHigh;
+    };
+
+  unsigned int m_Size;
+  unsigned int m_Rank;
+  std::vector< Comparison > m_Comparisons;
+};
+
+} // end namespace itk
+
+#endif
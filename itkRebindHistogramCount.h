@@ -0,0 +1,28 @@
+#ifndef __itkRebindHistogramCount_h
+#define __itkRebindHistogramCount_h
+
+namespace itk {
+
+/**
+ * \class RebindHistogramCount
+ * \brief Give the version of a histogram counting the pixels with TCount
+ *
+ * The number of pixels in a bin of a moving histogram can't be larger
+ * than the number of pixels in the kernel. The moving histogram filters
+ * use this class to run with the narrowest counter type able to store
+ * that number, so the histograms take less room in the cache.
+ *
+ * By default the histogram is used unchanged. The histograms with a
+ * counter type specialize this class, and must be constructible from the
+ * histogram they are derived from.
+ */
+template <class THistogram, class TCount>
+class RebindHistogramCount
+{
+public:
+  typedef THistogram Type;
+};
+
+} // end namespace itk
+
+#endif
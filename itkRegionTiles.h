@@ -0,0 +1,97 @@
+#ifndef __itkRegionTiles_h
+#define __itkRegionTiles_h
+
+#include <vector>
+#include <algorithm>
+
+namespace itk {
+
+/** Cut a region in tiles such that a tile, padded by the radius,
+ * contains at most maximumSize pixels, so the work area of a tile stays
+ * small whatever the size of the region.
+ *
+ * The axes are cut from the last one: the tiles keep the whole lines
+ * along the first axis when the slices allow it. The tiles are never
+ * thinner than the kernel, so the pixels read several times because of
+ * the padding stay a small part of the work: with a large radius, the
+ * padded tiles can be larger than maximumSize, but never larger than
+ * the kernel padded by the radius. The tiles are appended to tiles, in
+ * the order of the pixels of the region.
+ *
+ * \sa FusedSeparableImageFilter, MovingWindowMeanImageFilter
+ */
+template <class TRegion, class TRadius>
+void ComputeRegionTiles( const TRegion & region,
+                         const TRadius & radius,
+                         unsigned long maximumSize,
+                         std::vector< TRegion > & tiles )
+{
+  typedef typename TRegion::SizeType SizeType;
+  typedef typename TRegion::IndexType IndexType;
+  const unsigned int dimension = TRegion::ImageDimension;
+
+  if( region.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+
+  const SizeType & regionSize = region.GetSize();
+  SizeType tileSize = regionSize;
+  for( int a=dimension-1; a>=0; a-- )
+    {
+    // the size of the padded tile, without its axis a
+    double others = 1;
+    for( unsigned int b=0; b<dimension; b++ )
+      {
+      if( b != (unsigned int)a )
+        {
+        others *= tileSize[b] + 2 * radius[b];
+        }
+      }
+    if( others * ( tileSize[a] + 2 * radius[a] ) <= maximumSize )
+      {
+      break;
+      }
+    const long minimum = std::min( 2 * (long)radius[a] + 1, (long)regionSize[a] );
+    const long fit = (long)( maximumSize / others ) - 2 * (long)radius[a];
+    tileSize[a] = std::max( std::min( fit, (long)tileSize[a] ), minimum );
+    }
+
+  // the positions of the tiles in the region
+  long pos[dimension];
+  for( unsigned int a=0; a<dimension; a++ )
+    {
+    pos[a] = 0;
+    }
+  while( true )
+    {
+    IndexType idx;
+    SizeType size;
+    for( unsigned int a=0; a<dimension; a++ )
+      {
+      idx[a] = region.GetIndex()[a] + pos[a];
+      size[a] = std::min( (long)tileSize[a], (long)regionSize[a] - pos[a] );
+      }
+    tiles.push_back( TRegion( idx, size ) );
+
+    // next tile
+    unsigned int a = 0;
+    for( ; a<dimension; a++ )
+      {
+      pos[a] += tileSize[a];
+      if( pos[a] < (long)regionSize[a] )
+        {
+        break;
+        }
+      pos[a] = 0;
+      }
+    if( a == dimension )
+      {
+      break;
+      }
+    }
+}
+
+} // end namespace itk
+
+#endif
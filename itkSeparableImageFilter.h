@@ -18,6 +18,17 @@ namespace itk {
  * defined by the SetRadius() method, like the BoxImageFilter and its
  * subcalsses.
  *
+ * The filters of the axes are connected in a pipeline, so each
+ * intermediate image is as large as the requested region. When
+ * NumberOfStreamDivisions is greater than 1, the requested region is
+ * instead produced in that number of slabs along its last axis. The
+ * pipeline is run once per slab, and only requests the slab padded by
+ * the radius: the intermediate images are never larger than a padded
+ * slab, and are released before the next one is computed. The input
+ * requested region doesn't depend on the number of divisions, so a
+ * StreamingImageFilter placed after this filter is still required to
+ * read a volume larger than the memory by pieces.
+ *
  * \author Gaetan Lehmann
  * \author Richard Beare
  */
@@ -72,16 +83,25 @@ public:
 
   virtual void SetNumberOfThreads( int nb );
 
+  /** The number of slabs in which the requested region is produced. The
+   * default is 1: the whole requested region is computed at once. */
+  itkSetMacro(NumberOfStreamDivisions, unsigned int);
+  itkGetConstMacro(NumberOfStreamDivisions, unsigned int);
+
 protected:
   SeparableImageFilter();
   ~SeparableImageFilter() {};
 
   void GenerateData();
 
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
   typename FilterType::Pointer m_Filters[ImageDimension];
   
   typename CastType::Pointer m_Cast;
 
+  unsigned int m_NumberOfStreamDivisions;
+
 private:
   SeparableImageFilter(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
@@ -3,6 +3,9 @@
 
 #include "itkSeparableImageFilter.h"
 #include "itkProgressAccumulator.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include <algorithm>
 
 namespace itk {
 
@@ -24,6 +27,8 @@ SeparableImageFilter<TInputImage, TOutputImage, TFilter>
   m_Cast = CastType::New();
   m_Cast->SetInput( m_Filters[ImageDimension-1]->GetOutput() );
   m_Cast->SetInPlace( true );
+
+  m_NumberOfStreamDivisions = 1;
 }
 
 
@@ -83,18 +88,78 @@ SeparableImageFilter<TInputImage, TOutputImage, TFilter>
   // set up the pipeline
   m_Filters[0]->SetInput( this->GetInput() );
 
+  // the slabs are cut along the last axis of the requested region which
+  // is not flat
+  typedef typename OutputImageType::RegionType OutputRegionType;
+  OutputImageType * output = this->GetOutput();
+  const OutputRegionType outputRegion = output->GetRequestedRegion();
+  unsigned int axis = ImageDimension - 1;
+  while( axis > 0 && outputRegion.GetSize()[axis] == 1 )
+    {
+    axis--;
+    }
+  const unsigned long length = outputRegion.GetSize()[axis];
+  const unsigned long divisions = std::max( 1UL, std::min( (unsigned long)m_NumberOfStreamDivisions, length ) );
+
   // Create a process accumulator for tracking the progress of this minipipeline
   ProgressAccumulator::Pointer progress = ProgressAccumulator::New();
   progress->SetMiniPipelineFilter(this);
   for( unsigned i = 0; i< ImageDimension; i++ )
     {
-    progress->RegisterInternalFilter( m_Filters[i], 1.0/ImageDimension );
+    progress->RegisterInternalFilter( m_Filters[i], 1.0/(ImageDimension * divisions) );
+    }
+
+  if( divisions == 1 )
+    {
+    m_Cast->GraftOutput( this->GetOutput() ); 
+    m_Cast->Update();
+    this->GraftOutput( m_Cast->GetOutput() );
+    return;
     }
 
-  m_Cast->GraftOutput( this->GetOutput() ); 
-  m_Cast->Update();
-  this->GraftOutput( m_Cast->GetOutput() );
+  // the requested regions are propagated slab by slab, so the largest
+  // possible regions of the pipeline must be known first. The output of
+  // the cast may also still share its buffer with the output of a
+  // previous update, grafted above: give it a buffer of its own.
+  m_Cast->UpdateOutputInformation();
+  OutputImageType * slabOutput = m_Cast->GetOutput();
+  slabOutput->ReleaseData();
+
+  for( unsigned long d=0; d<divisions; d++ )
+    {
+    IndexType idx = outputRegion.GetIndex();
+    SizeType size = outputRegion.GetSize();
+    const unsigned long start = length * d / divisions;
+    idx[axis] += start;
+    size[axis] = length * ( d + 1 ) / divisions - start;
+    const OutputRegionType slab( idx, size );
+
+    // run the pipeline on the slab only, the same way StreamingImageFilter
+    // does
+    slabOutput->SetRequestedRegion( slab );
+    slabOutput->PropagateRequestedRegion();
+    slabOutput->UpdateOutputData();
+
+    ImageRegionConstIterator< OutputImageType > slabIt( slabOutput, slab );
+    ImageRegionIterator< OutputImageType > outIt( output, slab );
+    for( slabIt.GoToBegin(), outIt.GoToBegin(); !slabIt.IsAtEnd(); ++slabIt, ++outIt )
+      {
+      outIt.Set( slabIt.Get() );
+      }
+    slabOutput->ReleaseData();
+    progress->ResetFilterProgressAndKeepAccumulatedProgress();
+    }
+}
+
+
+template <class TInputImage, class TOutputImage, class TFilter>
+void
+SeparableImageFilter<TInputImage, TOutputImage, TFilter>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
 
+  os << indent << "NumberOfStreamDivisions: " << m_NumberOfStreamDivisions << std::endl;
 }
 
 }
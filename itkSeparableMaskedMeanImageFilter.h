@@ -0,0 +1,281 @@
+#ifndef __itkSeparableMaskedMeanImageFilter_h
+#define __itkSeparableMaskedMeanImageFilter_h
+
+#include "itkFusedSeparableImageFilter.h"
+#include "itkMovingWindowMeanImageFilter.h"
+#include "itkPackedMask.h"
+#include <vector>
+#include <algorithm>
+
+namespace itk {
+
+namespace Function {
+
+/** The line function of SeparableMaskedMeanImageFilter: the values are
+ * the sums and the numbers of the pixels of the mask, computed together
+ * with a moving window along each axis. GetValue() returns the mean of
+ * the pixels of the mask, with the division given by the filter. */
+template <class TInputPixel, class TOutputPixel>
+class SeparableMaskedMeanLine
+{
+public:
+  typedef typename MeanAccumulator< TInputPixel >::Type AccumulateType;
+  typedef MeanDivision< TInputPixel, TOutputPixel > DivisionType;
+
+  /** The sum and the number of the pixels of the mask */
+  class ValueType
+  {
+  public:
+    ValueType()
+      {
+      sum = 0;
+      count = 0;
+      }
+
+    /** A pixel of the mask */
+    explicit ValueType( const AccumulateType & p )
+      {
+      sum = p;
+      count = 1;
+      }
+
+    AccumulateType sum;
+    unsigned long count;
+  };
+
+  inline void SetAxis( unsigned int ) {}
+
+  inline void Compute( const ValueType * in, long n, long begin, long end, long radius, ValueType * out )
+    {
+    AccumulateType sum = 0;
+    unsigned long count = 0;
+    for( long k=std::max( begin - radius, 0L ); k<=std::min( begin + radius, n - 1 ); k++ )
+      {
+      sum += in[k].sum;
+      count += in[k].count;
+      }
+    out[0].sum = sum;
+    out[0].count = count;
+    for( long p=begin+1; p<end; p++ )
+      {
+      if( p + radius < n )
+        {
+        sum += in[p + radius].sum;
+        count += in[p + radius].count;
+        }
+      if( p - radius - 1 >= 0 )
+        {
+        sum -= in[p - radius - 1].sum;
+        count -= in[p - radius - 1].count;
+        }
+      out[p - begin].sum = sum;
+      out[p - begin].count = count;
+      }
+    }
+
+  void SetDivision( const DivisionType & division )
+    {
+    m_Division = division;
+    }
+
+  // the number of pixels of the box is ignored: only the pixels of the
+  // mask are counted, and there must be at least one
+  inline TOutputPixel GetValue( const ValueType & v, unsigned long ) const
+    {
+    assert( v.count > 0 );
+    return m_Division( v.sum, v.count );
+    }
+
+private:
+  DivisionType m_Division;
+};
+
+} // end namespace Function
+
+/**
+ * \class SeparableMaskedMeanImageFilter
+ * \brief A separable mean of the pixels of a mask
+ *
+ * Each output pixel is the mean of the input pixels of the mask in the
+ * box of the given radius centered on it: this is a normalized box
+ * filter. The sums and the numbers of the pixels of the mask are
+ * separable: they are computed together along each axis by
+ * FusedSeparableImageFilter, so the image and the mask are read once
+ * and the output is written once, without running a separable mean on
+ * the product of the image by the mask and an other one on the mask.
+ * The sums are exact for the integer pixel types, so the result is the
+ * one of MaskedMovingWindowMeanImageFilter with a box kernel, unlike the
+ * separable masked rank of FastApproxMaskRankImageFilter.
+ *
+ * As in FastApproxMaskRankImageFilter, the value is written for the
+ * pixels of the mask by default. When WriteInsideMask is off, it is
+ * written for the pixels out of the mask instead, to fill them with the
+ * mean of the pixels of the mask around them, or for all the pixels if
+ * ReturnUnion is on. The other pixels, and the ones without any pixel
+ * of the mask in their box, are set to FillValue.
+ *
+ * The integer output pixels are rounded to the nearest value, unless
+ * RoundOutput is off.
+ *
+ * \sa MaskedMovingWindowMeanImageFilter, SeparableMeanImageFilter, FastApproxMaskRankImageFilter
+ */
+
+template<class TInputImage, class TMaskImage, class TOutputImage>
+class ITK_EXPORT SeparableMaskedMeanImageFilter :
+public FusedSeparableImageFilter<TInputImage, TOutputImage, Function::SeparableMaskedMeanLine< typename TInputImage::PixelType, typename TOutputImage::PixelType > >
+{
+public:
+  /** Standard class typedefs. */
+  typedef SeparableMaskedMeanImageFilter Self;
+  typedef FusedSeparableImageFilter<TInputImage, TOutputImage, Function::SeparableMaskedMeanLine< typename TInputImage::PixelType, typename TOutputImage::PixelType > > Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(SeparableMaskedMeanImageFilter,
+               FusedSeparableImageFilter);
+
+  /** Image related typedefs. */
+  typedef TInputImage InputImageType;
+  typedef TMaskImage MaskImageType;
+  typedef typename TInputImage::RegionType RegionType ;
+  typedef typename TInputImage::SizeType SizeType ;
+  typedef typename TInputImage::IndexType IndexType ;
+  typedef typename TInputImage::PixelType PixelType ;
+  typedef typename TInputImage::OffsetType OffsetType ;
+  typedef typename TInputImage::PixelType InputPixelType ;
+  typedef typename MaskImageType::PixelType MaskPixelType;
+  typedef TOutputImage OutputImageType;
+  typedef typename TOutputImage::PixelType OutputPixelType ;
+  typedef typename Superclass::OutputImageRegionType OutputImageRegionType ;
+
+  /** Image related typedefs. */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+  /** n-dimensional Kernel radius. */
+  typedef typename TInputImage::SizeType RadiusType ;
+
+  typedef typename Superclass::LineFunctionType LineFunctionType;
+  typedef typename Superclass::ValueType ValueType;
+  typedef typename LineFunctionType::DivisionType DivisionType;
+
+  /** The mask stored with one bit per pixel */
+  typedef PackedMask< itkGetStaticConstMacro(ImageDimension) > PackedMaskType;
+
+  /** Set the mask image */
+  void SetMaskImage(MaskImageType *input)
+     {
+     // Process object is not const-correct so the const casting is required.
+     this->SetNthInput( 1, const_cast<TMaskImage *>(input) );
+     }
+
+  /** Get the mask image */
+  MaskImageType * GetMaskImage()
+    {
+    return static_cast<MaskImageType*>(const_cast<DataObject *>(this->ProcessObject::GetInput(1)));
+    }
+
+   /** Set the input image */
+  void SetInput1(InputImageType *input)
+     {
+     this->SetInput( input );
+     }
+
+   /** Set the mask image */
+  void SetInput2(MaskImageType *input)
+     {
+     this->SetMaskImage( input );
+     }
+
+  /** The value of the pixels of the mask. Defaults to the maximum of
+   * MaskPixelType, as in MaskedMovingHistogramImageFilter. */
+  itkSetMacro(MaskValue, MaskPixelType);
+  itkGetMacro(MaskValue, MaskPixelType);
+
+  /** The value of the pixels which don't get a mean. Defaults to
+   * zero. */
+  itkSetMacro(FillValue, OutputPixelType);
+  itkGetMacro(FillValue, OutputPixelType);
+
+  itkSetMacro(WriteInsideMask, bool);
+  itkGetMacro(WriteInsideMask, bool);
+
+  // if WriteInsideMask is false then the option is to return just the
+  // region outside the mask or both inside and outside
+  itkSetMacro(ReturnUnion, bool);
+  itkGetMacro(ReturnUnion, bool);
+
+  /** Round the integer output pixels to the nearest value instead of
+   * truncating them. Defaults to true. */
+  itkSetMacro(RoundOutput, bool);
+  itkGetMacro(RoundOutput, bool);
+  itkBooleanMacro(RoundOutput);
+
+protected:
+  SeparableMaskedMeanImageFilter();
+  ~SeparableMaskedMeanImageFilter() {};
+
+  /** The mask is read on the same region as the input */
+  void GenerateInputRequestedRegion();
+
+  /** Pack the mask and compute the table of the reciprocals */
+  void BeforeThreadedGenerateData();
+
+  typedef typename Superclass::OffsetValueType OffsetValueType;
+  typedef typename Superclass::InputInternalPixelType InputInternalPixelType;
+  typedef typename Superclass::InputAccessorType InputAccessorType;
+  typedef typename Superclass::OutputInternalPixelType OutputInternalPixelType;
+  typedef typename Superclass::OutputAccessorType OutputAccessorType;
+
+  /** Copy the pixels of the mask in the work area, and an empty value
+   * for the other ones */
+  void CopyInputOnTile(const RegionType& padded,
+                       const OffsetValueType * strides,
+                       ValueType * values);
+
+  /** Write the mean of the pixels of the mask where it is required */
+  void WriteOutputOnTile(const OutputImageRegionType& tile,
+                         const RegionType& padded,
+                         const OffsetValueType * strides,
+                         const ValueType * values,
+                         LineFunctionType & line,
+                         ProgressReporter & progress);
+
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+private:
+  SeparableMaskedMeanImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  MaskPixelType m_MaskValue;
+
+  OutputPixelType m_FillValue;
+
+  bool m_WriteInsideMask;
+
+  bool m_ReturnUnion;
+
+  bool m_RoundOutput;
+
+  // the largest number of reciprocals in the table of the division, as
+  // in MovingWindowMeanImageFilter
+  enum { MaximumNumberOfReciprocals = 1 << 16 };
+
+  std::vector< double > m_Reciprocals;
+
+  DivisionType m_Division;
+
+  // the mask read by the threads
+  PackedMaskType m_PackedMask;
+};
+
+}
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkSeparableMaskedMeanImageFilter.txx"
+#endif
+
+#endif
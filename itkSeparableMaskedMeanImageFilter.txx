@@ -0,0 +1,179 @@
+#ifndef __itkSeparableMaskedMeanImageFilter_txx
+#define __itkSeparableMaskedMeanImageFilter_txx
+
+#include "itkSeparableMaskedMeanImageFilter.h"
+#include "itkImageLinearConstIteratorWithIndex.h"
+#include "itkNumericTraits.h"
+#include <algorithm>
+
+namespace itk {
+
+template <class TInputImage, class TMaskImage, class TOutputImage>
+SeparableMaskedMeanImageFilter<TInputImage, TMaskImage, TOutputImage>
+::SeparableMaskedMeanImageFilter()
+{
+  this->SetNumberOfRequiredInputs( 2 );
+  m_MaskValue = NumericTraits< MaskPixelType >::max();
+  m_FillValue = NumericTraits< OutputPixelType >::Zero;
+  m_WriteInsideMask = true;
+  m_ReturnUnion = false;
+  m_RoundOutput = true;
+}
+
+
+template <class TInputImage, class TMaskImage, class TOutputImage>
+void
+SeparableMaskedMeanImageFilter<TInputImage, TMaskImage, TOutputImage>
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  MaskImageType * mask = this->GetMaskImage();
+  if( mask && this->GetInput() )
+    {
+    mask->SetRequestedRegion( this->GetInput()->GetRequestedRegion() );
+    }
+}
+
+
+template <class TInputImage, class TMaskImage, class TOutputImage>
+void
+SeparableMaskedMeanImageFilter<TInputImage, TMaskImage, TOutputImage>
+::BeforeThreadedGenerateData()
+{
+  Superclass::BeforeThreadedGenerateData();
+
+  // the threads only read the bits of the mask
+  m_PackedMask.Pack( this->GetMaskImage(), m_MaskValue );
+
+  // the box has at most that number of pixels of the mask
+  const RadiusType radius = this->GetRadius();
+  unsigned long count = 1;
+  for( unsigned i = 0; i < ImageDimension; i++ )
+    {
+    count *= 2 * radius[i] + 1;
+    }
+  const unsigned long size = std::min( count + 1, (unsigned long)MaximumNumberOfReciprocals );
+  DivisionType::ComputeReciprocals( m_Reciprocals, size );
+  m_Division.SetReciprocals( m_Reciprocals );
+  m_Division.SetRound( m_RoundOutput );
+}
+
+
+template <class TInputImage, class TMaskImage, class TOutputImage>
+void
+SeparableMaskedMeanImageFilter<TInputImage, TMaskImage, TOutputImage>
+::CopyInputOnTile(const RegionType& padded,
+                  const OffsetValueType * strides,
+                  ValueType * values)
+{
+  const InputImageType * inputImage = this->GetInput();
+  InputAccessorType inAccessor = inputImage->GetNeighborhoodAccessor();
+  const InputInternalPixelType * inBuffer = inputImage->GetBufferPointer();
+  inAccessor.SetBegin( inBuffer );
+  const IndexType & areaIndex = padded.GetIndex();
+
+  typedef ImageLinearConstIteratorWithIndex< InputImageType > InputLineIteratorType;
+  const long areaLength = padded.GetSize()[0];
+  InputLineIteratorType inLineIt( inputImage, padded );
+  inLineIt.SetDirection( 0 );
+  for( inLineIt.GoToBegin(); !inLineIt.IsAtEnd(); inLineIt.NextLine() )
+    {
+    const IndexType idx = inLineIt.GetIndex();
+    OffsetValueType o = 0;
+    for( unsigned int a=0; a<ImageDimension; a++ )
+      {
+      o += ( idx[a] - areaIndex[a] ) * strides[a];
+      }
+    const InputInternalPixelType * inPtr = inBuffer + inputImage->ComputeOffset( idx );
+    // the bits of a line along the first axis are contiguous
+    const OffsetValueType maskOffset = m_PackedMask.ComputeOffset( idx );
+    ValueType * v = values + o;
+    for( long k=0; k<areaLength; k++ )
+      {
+      if( m_PackedMask.Test( maskOffset + k ) )
+        {
+        v[k] = ValueType( static_cast< typename LineFunctionType::AccumulateType >( inAccessor.Get( inPtr + k ) ) );
+        }
+      else
+        {
+        v[k] = ValueType();
+        }
+      }
+    }
+}
+
+
+template <class TInputImage, class TMaskImage, class TOutputImage>
+void
+SeparableMaskedMeanImageFilter<TInputImage, TMaskImage, TOutputImage>
+::WriteOutputOnTile(const OutputImageRegionType& tile,
+                    const RegionType& padded,
+                    const OffsetValueType * strides,
+                    const ValueType * values,
+                    LineFunctionType & line,
+                    ProgressReporter & progress)
+{
+  // the division of the filter, with its table of reciprocals and its
+  // rounding
+  line.SetDivision( m_Division );
+
+  OutputImageType * outputImage = this->GetOutput();
+  OutputAccessorType outAccessor = outputImage->GetNeighborhoodAccessor();
+  OutputInternalPixelType * outBuffer = outputImage->GetBufferPointer();
+  outAccessor.SetBegin( outBuffer );
+  const IndexType & areaIndex = padded.GetIndex();
+
+  const bool writeInside = m_WriteInsideMask || m_ReturnUnion;
+  const bool writeOutside = !m_WriteInsideMask;
+
+  const long lineLength = tile.GetSize()[0];
+  typedef ImageLinearConstIteratorWithIndex< InputImageType > InputLineIteratorType;
+  InputLineIteratorType lineIt( this->GetInput(), tile );
+  lineIt.SetDirection( 0 );
+  for( lineIt.GoToBegin(); !lineIt.IsAtEnd(); lineIt.NextLine() )
+    {
+    const IndexType idx = lineIt.GetIndex();
+    OffsetValueType o = 0;
+    for( unsigned int a=0; a<ImageDimension; a++ )
+      {
+      o += ( idx[a] - areaIndex[a] ) * strides[a];
+      }
+    const ValueType * v = values + o;
+    const OffsetValueType maskOffset = m_PackedMask.ComputeOffset( idx );
+    OutputInternalPixelType * outPtr = outBuffer + outputImage->ComputeOffset( idx );
+    for( long k=0; k<lineLength; k++ )
+      {
+      const bool inMask = m_PackedMask.Test( maskOffset + k );
+      if( ( inMask ? writeInside : writeOutside ) && v[k].count > 0 )
+        {
+        outAccessor.Set( outPtr + k, line.GetValue( v[k], 0 ) );
+        }
+      else
+        {
+        outAccessor.Set( outPtr + k, m_FillValue );
+        }
+      }
+    progress.CompletedPixel();
+    }
+}
+
+
+template<class TInputImage, class TMaskImage, class TOutputImage>
+void
+SeparableMaskedMeanImageFilter<TInputImage, TMaskImage, TOutputImage>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "MaskValue: " << static_cast<typename NumericTraits<MaskPixelType>::PrintType>(m_MaskValue) << std::endl;
+  os << indent << "FillValue: " << static_cast<typename NumericTraits<OutputPixelType>::PrintType>(m_FillValue) << std::endl;
+  os << indent << "WriteInsideMask: " << m_WriteInsideMask << std::endl;
+  os << indent << "ReturnUnion: " << m_ReturnUnion << std::endl;
+  os << indent << "RoundOutput: " << m_RoundOutput << std::endl;
+}
+
+}
+
+
+#endif
@@ -2,13 +2,88 @@
 #define __itkSeparableMeanImageFilter_h
 
 #include "itkSeparableImageFilter.h"
+#include "itkFusedSeparableImageFilter.h"
 #include "itkMovingWindowMeanImageFilter.h"
 
 namespace itk {
 
+namespace Function {
+
+/** The line function of FusedSeparableImageFilter for the mean: the
+ * values are the sums of the pixels, computed with a moving window. They
+ * are divided by the number of pixels of the box only for the output,
+ * so the integer pixels give the same result as
+ * MovingWindowMeanImageFilter. */
+template <class TInputPixel, class TOutputPixel>
+class SeparableMeanLine
+{
+public:
+  typedef typename MeanAccumulator< TInputPixel >::Type ValueType;
+  typedef MeanDivision< TInputPixel, TOutputPixel > DivisionType;
+
+  void SetDivision( const DivisionType & division )
+    {
+    m_Division = division;
+    }
+
+  const DivisionType & GetDivision() const
+    {
+    return m_Division;
+    }
+
+  inline void SetAxis( unsigned int ) {}
+
+  inline void Compute( const ValueType * in, long n, long begin, long end, long radius, ValueType * out )
+    {
+    ValueType sum = static_cast< ValueType >( 0 );
+    for( long k=std::max( begin - radius, 0L ); k<=std::min( begin + radius, n - 1 ); k++ )
+      {
+      sum += in[k];
+      }
+    out[0] = sum;
+    for( long p=begin+1; p<end; p++ )
+      {
+      if( p + radius < n )
+        {
+        sum += in[p + radius];
+        }
+      if( p - radius - 1 >= 0 )
+        {
+        sum -= in[p - radius - 1];
+        }
+      out[p - begin] = sum;
+      }
+    }
+
+  // the same computation as MeanHistogram
+  inline TOutputPixel GetValue( const ValueType & sum, unsigned long count ) const
+    {
+    return m_Division( sum, count );
+    }
+
+private:
+  DivisionType m_Division;
+};
+
+} // end namespace Function
+
 /**
  * \class SeparableMeanImageFilter
  * \brief A separable mean filter
+ *
+ * By default, all the axes are processed at once by
+ * FusedSeparableImageFilter: the sums of the pixels along each axis
+ * are kept in a work area of the size of a few slices, and the input
+ * and the output images are read and written once. The sums are exact
+ * for the integer pixel types, so the result is the one of
+ * MovingWindowMeanImageFilter with a box kernel. UseFusedAxesOff()
+ * runs the mini-pipeline of SeparableImageFilter instead, which stores
+ * the mean along each axis in an intermediate image of the output type.
+ * NumberOfStreamDivisions only applies to that mini-pipeline: the work
+ * area of the fused filter is already bounded by a few slices.
+ *
+ * As in MovingWindowMeanImageFilter, the integer output pixels are
+ * rounded to the nearest value, unless RoundOutput is off.
  * 
  * \author Gaetan Lehmann
  */
@@ -46,15 +121,57 @@ public:
   /** n-dimensional Kernel radius. */
   typedef typename TInputImage::SizeType RadiusType ;
 
+  typedef typename TOutputImage::PixelType OutputPixelType ;
+  typedef Function::SeparableMeanLine< PixelType, OutputPixelType > LineFunctionType;
+  typedef FusedSeparableImageFilter< TInputImage, TOutputImage, LineFunctionType > FusedFilterType;
+
+  /** Process all the axes at once, without intermediate images.
+   * Defaults to true. */
+  itkSetMacro(UseFusedAxes, bool);
+  itkGetMacro(UseFusedAxes, bool);
+  itkBooleanMacro(UseFusedAxes);
+
+  /** Round the integer output pixels to the nearest value instead of
+   * truncating them. Defaults to true. */
+  virtual void SetRoundOutput( bool );
+  itkGetMacro(RoundOutput, bool);
+  itkBooleanMacro(RoundOutput);
+
+  virtual void Modified() const;
+
+  virtual void SetNumberOfThreads( int nb );
+
 protected:
-  SeparableMeanImageFilter() {};
+  SeparableMeanImageFilter();
   ~SeparableMeanImageFilter() {};
 
+  void GenerateData();
+
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  typename FusedFilterType::Pointer m_FusedFilter;
+
 private:
   SeparableMeanImageFilter(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
+
+  bool m_UseFusedAxes;
+
+  bool m_RoundOutput;
+
+  // the largest number of reciprocals in the table of the division, as
+  // in MovingWindowMeanImageFilter
+  enum { MaximumNumberOfReciprocals = 1 << 16 };
+
+  // the reciprocals of the numbers of pixels of the box, for the fused
+  // filter
+  std::vector< double > m_Reciprocals;
 };
 
 }
 
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkSeparableMeanImageFilter.txx"
+#endif
+
 #endif
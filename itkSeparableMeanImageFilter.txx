@@ -0,0 +1,113 @@
+#ifndef __itkSeparableMeanImageFilter_txx
+#define __itkSeparableMeanImageFilter_txx
+
+#include "itkSeparableMeanImageFilter.h"
+#include "itkProgressAccumulator.h"
+#include <algorithm>
+
+namespace itk {
+
+template <class TInputImage, class TOutputImage>
+SeparableMeanImageFilter<TInputImage, TOutputImage>
+::SeparableMeanImageFilter()
+{
+  m_UseFusedAxes = true;
+  m_FusedFilter = FusedFilterType::New();
+  m_RoundOutput = true;
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+SeparableMeanImageFilter<TInputImage, TOutputImage>
+::SetRoundOutput( bool round )
+{
+  if( m_RoundOutput != round )
+    {
+    m_RoundOutput = round;
+    for( unsigned i = 0; i < ImageDimension; i++ )
+      {
+      this->m_Filters[i]->SetRoundOutput( m_RoundOutput );
+      }
+    this->Modified();
+    }
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+SeparableMeanImageFilter<TInputImage, TOutputImage>
+::Modified() const
+{
+  Superclass::Modified();
+  m_FusedFilter->Modified();
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+SeparableMeanImageFilter<TInputImage, TOutputImage>
+::SetNumberOfThreads( int nb )
+{
+  Superclass::SetNumberOfThreads( nb );
+  m_FusedFilter->SetNumberOfThreads( nb );
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+SeparableMeanImageFilter<TInputImage, TOutputImage>
+::GenerateData()
+{
+  if( !m_UseFusedAxes )
+    {
+    Superclass::GenerateData();
+    return;
+    }
+
+  this->AllocateOutputs();
+
+  m_FusedFilter->SetInput( this->GetInput() );
+  m_FusedFilter->SetRadius( this->GetRadius() );
+
+  // the box, cropped at the border, has at most that number of pixels
+  const RadiusType radius = this->GetRadius();
+  unsigned long count = 1;
+  for( unsigned i = 0; i < ImageDimension; i++ )
+    {
+    count *= 2 * radius[i] + 1;
+    }
+  const unsigned long size = std::min( count + 1, (unsigned long)MaximumNumberOfReciprocals );
+  typename LineFunctionType::DivisionType division;
+  LineFunctionType::DivisionType::ComputeReciprocals( m_Reciprocals, size );
+  division.SetReciprocals( m_Reciprocals );
+  division.SetRound( m_RoundOutput );
+  LineFunctionType line;
+  line.SetDivision( division );
+  m_FusedFilter->SetLineFunction( line );
+
+  ProgressAccumulator::Pointer progress = ProgressAccumulator::New();
+  progress->SetMiniPipelineFilter(this);
+  progress->RegisterInternalFilter( m_FusedFilter, 1.0 );
+
+  m_FusedFilter->GraftOutput( this->GetOutput() );
+  m_FusedFilter->Update();
+  this->GraftOutput( m_FusedFilter->GetOutput() );
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+SeparableMeanImageFilter<TInputImage, TOutputImage>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "UseFusedAxes: " << m_UseFusedAxes << std::endl;
+  os << indent << "RoundOutput: " << m_RoundOutput << std::endl;
+}
+
+}
+
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef __itkSeparableStatisticsImageFilter_h
+#define __itkSeparableStatisticsImageFilter_h
+
+#include "itkBoxImageFilter.h"
+#include "itkMovingWindowStatisticsImageFilter.h"
+#include <vector>
+
+
+namespace itk {
+
+/**
+ * \class SeparableStatisticsImageFilter
+ * \brief A separable version of MovingWindowStatisticsImageFilter
+ *
+ * The statistics of a box are computed one axis after the other, as in
+ * SeparableImageFilter. The first filter computes the statistics along
+ * the first axis from the input pixels. The next ones combine the
+ * statistics of the lines of the box: the lines of a box cropped at the
+ * border all have the same number of pixels, so the mean of the box is
+ * the mean of the means of its lines, and the same goes for the mean of
+ * the squares, from which the variance is computed again. The minimum
+ * and the maximum, when the output pixel has 5 components, are the
+ * minimum of the minima and the maximum of the maxima.
+ *
+ * The statistics of the intermediate images are stored with the value
+ * type of the output pixel, so the output pixel should use double values
+ * when the variance of large values is needed.
+ *
+ * \sa MovingWindowStatisticsImageFilter, SeparableImageFilter
+ */
+
+template<class TInputImage, class TOutputImage>
+class ITK_EXPORT SeparableStatisticsImageFilter :
+public BoxImageFilter<TInputImage, TOutputImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef SeparableStatisticsImageFilter Self;
+  typedef BoxImageFilter<TInputImage,TOutputImage>  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(SeparableStatisticsImageFilter,
+               BoxImageFilter);
+
+  /** Image related typedefs. */
+  typedef TInputImage InputImageType;
+  typedef typename TInputImage::RegionType RegionType ;
+  typedef typename TInputImage::SizeType SizeType ;
+  typedef typename TInputImage::IndexType IndexType ;
+  typedef typename TInputImage::PixelType PixelType ;
+  typedef typename TInputImage::OffsetType OffsetType ;
+
+  typedef TOutputImage OutputImageType;
+  typedef typename TOutputImage::PixelType OutputPixelType ;
+
+  /** Image related typedefs. */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+  /** n-dimensional Kernel radius. */
+  typedef typename TInputImage::SizeType RadiusType ;
+
+  typedef Neighborhood<bool, TInputImage::ImageDimension> KernelType;
+
+  /** The filter of the first axis, which reads the input pixels */
+  typedef MovingWindowStatisticsImageFilter<TInputImage, TOutputImage, KernelType> FirstFilterType;
+
+  /** The filters of the other axes, which combine the statistics */
+  typedef MovingWindowStatisticsImageFilter<TOutputImage, TOutputImage, KernelType> FilterType;
+
+  /** The positions of the statistics in the output pixels */
+  typedef Function::StatisticsComponents ComponentsType;
+
+  virtual void SetRadius( const RadiusType & );
+
+  virtual void SetRadius( const unsigned long & radius )
+    {
+    // needed because of the overloading of the method
+    Superclass::SetRadius( radius );
+    }
+
+  virtual void Modified() const;
+
+  virtual void SetNumberOfThreads( int nb );
+
+protected:
+  SeparableStatisticsImageFilter();
+  ~SeparableStatisticsImageFilter() {};
+
+  void GenerateData();
+
+  typename FirstFilterType::Pointer m_FirstFilter;
+
+  // the filters of the axes 1 to ImageDimension-1
+  std::vector< typename FilterType::Pointer > m_Filters;
+
+private:
+  SeparableStatisticsImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+};
+
+}
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkSeparableStatisticsImageFilter.txx"
+#endif
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef __itkSeparableStatisticsImageFilter_txx
+#define __itkSeparableStatisticsImageFilter_txx
+
+#include "itkSeparableStatisticsImageFilter.h"
+#include "itkProgressAccumulator.h"
+
+namespace itk {
+
+template <class TInputImage, class TOutputImage>
+SeparableStatisticsImageFilter<TInputImage, TOutputImage>
+::SeparableStatisticsImageFilter()
+{
+  // create the pipeline
+  m_FirstFilter = FirstFilterType::New();
+  m_FirstFilter->ReleaseDataFlagOn();
+  for( unsigned i = 1; i < ImageDimension; i++ )
+    {
+    typename FilterType::Pointer filter = FilterType::New();
+    filter->ReleaseDataFlagOn();
+    if( i == 1 )
+      {
+      filter->SetInput( m_FirstFilter->GetOutput() );
+      }
+    else
+      {
+      filter->SetInput( m_Filters.back()->GetOutput() );
+      }
+    m_Filters.push_back( filter );
+    }
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+SeparableStatisticsImageFilter<TInputImage, TOutputImage>
+::Modified() const
+{
+  Superclass::Modified();
+  m_FirstFilter->Modified();
+  for (unsigned i = 0; i < m_Filters.size(); i++)
+    {
+    m_Filters[i]->Modified();
+    }
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+SeparableStatisticsImageFilter<TInputImage, TOutputImage>
+::SetNumberOfThreads( int nb )
+{
+  Superclass::SetNumberOfThreads( nb );
+  m_FirstFilter->SetNumberOfThreads( nb );
+  for (unsigned i = 0; i < m_Filters.size(); i++)
+    {
+    m_Filters[i]->SetNumberOfThreads( nb );
+    }
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+SeparableStatisticsImageFilter<TInputImage, TOutputImage>
+::SetRadius( const RadiusType & radius )
+{
+  Superclass::SetRadius( radius );
+
+  // set up the kernels
+  RadiusType rad;
+  rad.Fill(0);
+  rad[0] = radius[0];
+  m_FirstFilter->SetRadius( rad );
+  for (unsigned i = 1; i< ImageDimension; i++)
+    {
+    rad.Fill(0);
+    rad[i] = radius[i];
+    m_Filters[i-1]->SetRadius( rad );
+    }
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+SeparableStatisticsImageFilter<TInputImage, TOutputImage>
+::GenerateData()
+{
+  this->AllocateOutputs();
+
+  // set up the pipeline
+  m_FirstFilter->SetInput( this->GetInput() );
+
+  // Create a process accumulator for tracking the progress of this minipipeline
+  ProgressAccumulator::Pointer progress = ProgressAccumulator::New();
+  progress->SetMiniPipelineFilter(this);
+  progress->RegisterInternalFilter( m_FirstFilter, 1.0/ImageDimension );
+  for( unsigned i = 0; i< m_Filters.size(); i++ )
+    {
+    progress->RegisterInternalFilter( m_Filters[i], 1.0/ImageDimension );
+    }
+
+  // the last filter writes directly in the output
+  if( m_Filters.empty() )
+    {
+    m_FirstFilter->GraftOutput( this->GetOutput() );
+    m_FirstFilter->Update();
+    this->GraftOutput( m_FirstFilter->GetOutput() );
+    }
+  else
+    {
+    m_Filters.back()->GraftOutput( this->GetOutput() );
+    m_Filters.back()->Update();
+    this->GraftOutput( m_Filters.back()->GetOutput() );
+    }
+}
+
+}
+
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef __itkVanHerkGilWermanLine_h
+#define __itkVanHerkGilWermanLine_h
+
+#include "itkNumericTraits.h"
+#include <functional>
+#include <algorithm>
+#include <limits>
+
+namespace itk {
+
+/** The identities of the minimum and of the maximum for
+ * VanHerkGilWermanLine: the extreme values of the pixel type, or the
+ * infinities for the types which have them, so a window containing only
+ * infinite values keeps its infinite extremum. */
+template <class TValue, bool VHasInfinity = std::numeric_limits< TValue >::has_infinity >
+class VanHerkGilWermanIdentity
+{
+public:
+  static TValue Minimum()
+    {
+    return NumericTraits< TValue >::max();
+    }
+
+  static TValue Maximum()
+    {
+    return NumericTraits< TValue >::NonpositiveMin();
+    }
+};
+
+template <class TValue>
+class VanHerkGilWermanIdentity< TValue, true >
+{
+public:
+  static TValue Minimum()
+    {
+    return std::numeric_limits< TValue >::infinity();
+    }
+
+  static TValue Maximum()
+    {
+    return -std::numeric_limits< TValue >::infinity();
+    }
+};
+
+/**
+ * \class VanHerkGilWermanLine
+ * \brief The minimum or the maximum in a moving window along a line
+ *
+ * This class implements the algorithm of van Herk, and of Gil and
+ * Werman, for a window of 2*radius+1 values. The line is cut in blocks
+ * of the size of the window. The extremum of the values from the
+ * beginning of its block up to each position, and from each position up
+ * to the end of its block, are computed once. The extremum in a window
+ * is then the extremum of two of these values, whatever the radius.
+ *
+ * TCompare gives the extremum: std::less for the minimum, and
+ * std::greater for the maximum. The window is cropped at the ends of
+ * the line: the values outside the line are replaced by identity, which
+ * must never be preferred by TCompare to a value of the line - see
+ * VanHerkGilWermanIdentity.
+ *
+ * The work area is kept from one line to the next, so no memory is
+ * allocated once the longest line has been processed.
+ */
+template <class TValue, class TCompare = std::less< TValue > >
+class VanHerkGilWermanLine
+{
+public:
+  VanHerkGilWermanLine( const TValue & identity )
+    {
+    m_Identity = identity;
+    m_Capacity = 0;
+    m_Padded = 0;
+    m_Forward = 0;
+    m_Backward = 0;
+    }
+
+  ~VanHerkGilWermanLine()
+    {
+    delete [] m_Padded;
+    delete [] m_Forward;
+    delete [] m_Backward;
+    }
+
+  /** Compute the extremum in the window centered on the positions begin
+   * to end (excluded) of the n values of the line in, and store it at
+   * out[p-begin] */
+  void Compute( const TValue * in, long n, long begin, long end, long radius, TValue * out )
+    {
+    const long window = 2 * radius + 1;
+    // the first position used in the padded line, and the number of
+    // whole blocks covering the windows
+    const long first = begin - radius;
+    const long nbOfBlocks = ( end - begin + 2 * radius + window - 1 ) / window;
+    const long length = nbOfBlocks * window;
+    this->Reserve( length );
+
+    // copy the line, padded with the identity
+    const long lineStart = std::min( length, std::max( 0L, -first ) );
+    const long lineEnd = std::max( lineStart, std::min( length, n - first ) );
+    std::fill( m_Padded, m_Padded + lineStart, m_Identity );
+    std::copy( in + ( first + lineStart ), in + ( first + lineEnd ), m_Padded + lineStart );
+    std::fill( m_Padded + lineEnd, m_Padded + length, m_Identity );
+
+    for( long s=0; s<length; s+=window )
+      {
+      TValue v = m_Padded[s];
+      m_Forward[s] = v;
+      for( long k=s+1; k<s+window; k++ )
+        {
+        v = Extremum( v, m_Padded[k] );
+        m_Forward[k] = v;
+        }
+      v = m_Padded[s+window-1];
+      m_Backward[s+window-1] = v;
+      for( long k=s+window-2; k>=s; k-- )
+        {
+        v = Extremum( v, m_Padded[k] );
+        m_Backward[k] = v;
+        }
+      }
+
+    // the window of the position p starts at p-begin in the padded line
+    for( long p=0; p<end-begin; p++ )
+      {
+      out[p] = Extremum( m_Backward[p], m_Forward[p+window-1] );
+      }
+    }
+
+private:
+  VanHerkGilWermanLine(const VanHerkGilWermanLine&); //purposely not implemented
+  void operator=(const VanHerkGilWermanLine&); //purposely not implemented
+
+  static inline TValue Extremum( const TValue & a, const TValue & b )
+    {
+    TCompare compare;
+    return compare( b, a ) ? b : a;
+    }
+
+  void Reserve( long length )
+    {
+    if( length > m_Capacity )
+      {
+      delete [] m_Padded;
+      delete [] m_Forward;
+      delete [] m_Backward;
+      m_Padded = new TValue[length];
+      m_Forward = new TValue[length];
+      m_Backward = new TValue[length];
+      m_Capacity = length;
+      }
+    }
+
+  TValue m_Identity;
+  long m_Capacity;
+  TValue * m_Padded;
+  TValue * m_Forward;
+  TValue * m_Backward;
+};
+
+} // end namespace itk
+
+#endif
@@ -48,6 +48,12 @@ int main(int, char * argv[])
   maskedRank->SetMaskImage( reader2->GetOutput() );
   maskedRank->SetRadius( 5 );
 
+  MaskedRankType::Pointer maskedRankDynamic = MaskedRankType::New();
+  maskedRankDynamic->SetInput( reader->GetOutput() );
+  maskedRankDynamic->SetMaskImage( reader2->GetOutput() );
+  maskedRankDynamic->SetRadius( 5 );
+  maskedRankDynamic->SetUseDynamicScheduling( true );
+
   typedef itk::MovingWindowMeanImageFilter< IType, IType, KernelType > MovingWindowMeanType;
   MovingWindowMeanType::Pointer movingWindowMean = MovingWindowMeanType::New();
   movingWindowMean->SetInput( reader->GetOutput() );
@@ -70,6 +76,7 @@ int main(int, char * argv[])
             << "fastApproxMaskRank" << "\t"
             << "fastApproxRank" << "\t"
             << "maskedRank" << "\t"
+            << "maskedRankDynamic" << "\t"
             << "movingWindowMean" << "\t"
             << "rank" << "\t"
             << "separableMean" << "\t"
@@ -80,6 +87,7 @@ int main(int, char * argv[])
     itk::TimeProbe fastApproxMaskRankTime;
     itk::TimeProbe fastApproxRankTime;
     itk::TimeProbe maskedRankTime;
+    itk::TimeProbe maskedRankDynamicTime;
     itk::TimeProbe movingWindowMeanTime;
     itk::TimeProbe rankTime;
     itk::TimeProbe separableMeanTime;
@@ -87,6 +95,7 @@ int main(int, char * argv[])
     fastApproxMaskRank->SetNumberOfThreads( t );
     fastApproxRank->SetNumberOfThreads( t );
     maskedRank->SetNumberOfThreads( t );
+    maskedRankDynamic->SetNumberOfThreads( t );
     movingWindowMean->SetNumberOfThreads( t );
     rank->SetNumberOfThreads( t );
     separableMean->SetNumberOfThreads( t );
@@ -108,6 +117,11 @@ int main(int, char * argv[])
       maskedRank->Update();
       maskedRankTime.Stop();
 
+      maskedRankDynamic->Modified();
+      maskedRankDynamicTime.Start();
+      maskedRankDynamic->Update();
+      maskedRankDynamicTime.Stop();
+
       movingWindowMean->Modified();
       movingWindowMeanTime.Start();
       movingWindowMean->Update();
@@ -129,6 +143,7 @@ int main(int, char * argv[])
               << fastApproxMaskRankTime.GetMeanTime() << "\t"
               << fastApproxRankTime.GetMeanTime() << "\t"
               << maskedRankTime.GetMeanTime() << "\t"
+              << maskedRankDynamicTime.GetMeanTime() << "\t"
               << movingWindowMeanTime.GetMeanTime() << "\t"
               << rankTime.GetMeanTime() << "\t"
               << separableMeanTime.GetMeanTime() << "\t"
@@ -0,0 +1,81 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkCommand.h"
+#include "itkSimpleFilterWatcher.h"
+#include "itkCastImageFilter.h"
+#include "itkIteratedBoxGaussianImageFilter.h"
+#include "itkSeparableMeanImageFilter.h"
+#include "itkTimeProbe.h"
+
+int main(int, char * argv[])
+{
+  const int dim = 2;
+  
+  unsigned repeats = (unsigned)atoi(argv[1]);
+
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+  typedef itk::Image< double, dim > DType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[2] );
+  reader->Update();
+
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+
+  itk::TimeProbe GTime, PTime;
+
+  typedef itk::IteratedBoxGaussianImageFilter< IType, IType > GaussianType;
+  GaussianType::Pointer gaussian = GaussianType::New();
+  gaussian->SetInput( reader->GetOutput() );
+  gaussian->SetSigma( 4.0 );
+  gaussian->SetNumberOfPasses( 4 );
+  for (unsigned i=0;i<repeats; i++)
+    {
+    GTime.Start();
+    gaussian->Modified();
+    gaussian->Update();
+    GTime.Stop();
+    }
+  writer->SetInput( gaussian->GetOutput() );
+  writer->SetFileName( argv[3] );
+  writer->Update();
+
+  // the same passes, run one after the other on double images
+  typedef itk::CastImageFilter< IType, DType > CastType;
+  CastType::Pointer cast = CastType::New();
+  cast->SetInput( reader->GetOutput() );
+
+  typedef itk::SeparableMeanImageFilter< DType, DType > MeanType;
+  MeanType::Pointer means[4];
+  DType * last = cast->GetOutput();
+  for( unsigned int k=0; k<gaussian->GetNumberOfPasses(); k++ )
+    {
+    means[k] = MeanType::New();
+    means[k]->SetInput( last );
+    means[k]->SetRadius( gaussian->GetPassRadius( k ) );
+    last = means[k]->GetOutput();
+    }
+
+  // a null sigma only rounds the values
+  typedef itk::IteratedBoxGaussianImageFilter< DType, IType > RoundType;
+  RoundType::Pointer round = RoundType::New();
+  round->SetInput( last );
+  round->SetSigma( 0.0 );
+  for (unsigned i=0;i<repeats; i++)
+    {
+    PTime.Start();
+    cast->Modified();
+    round->Update();
+    PTime.Stop();
+    }
+  writer->SetInput( round->GetOutput() );
+  writer->SetFileName( argv[4] );
+  writer->Update();
+
+  std::cout << "Iterated box gaussian time " << GTime.GetMeanTime() << std::endl;
+  std::cout << "Separable means time " << PTime.GetMeanTime() << std::endl;
+  return 0;
+}
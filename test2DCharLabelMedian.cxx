@@ -0,0 +1,107 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkCommand.h"
+#include "itkSimpleFilterWatcher.h"
+#include "itkNeighborhood.h"
+#include "itkLabelRankImageFilter.h"
+#include "itkMaskedRankImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkTimeProbe.h"
+#include <set>
+
+int main(int, char * argv[])
+{
+  const int dim = 2;
+  
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  typedef unsigned char LPType;
+  typedef itk::Image< LPType, dim > LType;
+
+  unsigned repeats = (unsigned)atoi(argv[1]);
+  itk::TimeProbe LTime, MTime;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[2] );
+  reader->Update();
+
+  typedef itk::ImageFileReader< LType > LabelReaderType;
+  LabelReaderType::Pointer lreader = LabelReaderType::New();
+  lreader->SetFileName( argv[3] );
+  lreader->Update();
+
+  typedef itk::Neighborhood<bool, dim> KType;
+
+  KType kernel;
+  kernel.SetRadius(10);
+  for( KType::Iterator kit=kernel.Begin(); kit!=kernel.End(); kit++ )
+    {
+    *kit=1;
+    }
+
+  // all the labels in a single traversal
+  typedef itk::LabelRankImageFilter< IType, LType, IType, KType > FilterType;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( reader->GetOutput() );
+  filter->SetLabelImage( lreader->GetOutput() );
+  filter->SetKernel(kernel);
+  for (unsigned i=0;i<repeats; i++)
+    {
+    LTime.Start();
+    filter->Modified();
+    filter->Update();
+    LTime.Stop();
+    }
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( filter->GetOutput() );
+  writer->SetFileName( argv[4] );
+  writer->Update();
+
+  // one masked filter per label, merged on the pixels of each label
+  std::set< LPType > labels;
+  itk::ImageRegionConstIterator< LType > lit( lreader->GetOutput(), lreader->GetOutput()->GetBufferedRegion() );
+  for( lit.GoToBegin(); !lit.IsAtEnd(); ++lit )
+    {
+    labels.insert( lit.Get() );
+    }
+
+  IType::Pointer merged = IType::New();
+  merged->SetRegions( reader->GetOutput()->GetBufferedRegion() );
+  merged->Allocate();
+
+  typedef itk::MaskedRankImageFilter< IType, LType, IType, KType > MaskedFilterType;
+  MaskedFilterType::Pointer masked = MaskedFilterType::New();
+  masked->SetInput( reader->GetOutput() );
+  masked->SetMaskImage( lreader->GetOutput() );
+  masked->SetKernel(kernel);
+  for (unsigned i=0;i<repeats; i++)
+    {
+    MTime.Start();
+    for( std::set< LPType >::const_iterator it=labels.begin(); it!=labels.end(); it++ )
+      {
+      masked->SetMaskValue( *it );
+      masked->Update();
+      itk::ImageRegionConstIterator< IType > mit( masked->GetOutput(), masked->GetOutput()->GetBufferedRegion() );
+      itk::ImageRegionIterator< IType > oit( merged, merged->GetBufferedRegion() );
+      for( lit.GoToBegin(), mit.GoToBegin(), oit.GoToBegin(); !lit.IsAtEnd(); ++lit, ++mit, ++oit )
+        {
+        if( lit.Get() == *it )
+          {
+          oit.Set( mit.Get() );
+          }
+        }
+      }
+    MTime.Stop();
+    }
+  writer->SetInput( merged );
+  writer->SetFileName( argv[5] );
+  writer->Update();
+
+  std::cout << "Label time " << LTime.GetMeanTime() << std::endl;
+  std::cout << "Masked per label time " << MTime.GetMeanTime() << std::endl;
+  return 0;
+}
@@ -0,0 +1,145 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkCommand.h"
+#include "itkSimpleFilterWatcher.h"
+#include "itkNeighborhood.h"
+#include "itkMaskedMovingWindowMeanImageFilter.h"
+#include "itkSeparableMaskedMeanImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkTimeProbe.h"
+
+int main(int, char * argv[])
+{
+  const int dim = 2;
+
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  typedef unsigned char MPType;
+  typedef itk::Image< MPType, dim > MType;
+
+  unsigned repeats = (unsigned)atoi(argv[1]);
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[2] );
+  reader->Update();
+
+  typedef itk::ImageFileReader< MType > MaskReaderType;
+  MaskReaderType::Pointer mreader = MaskReaderType::New();
+  mreader->SetFileName( argv[3] );
+  mreader->Update();
+
+  typedef itk::Neighborhood<bool, dim> KType;
+
+  KType kernel;
+  kernel.SetRadius(10);
+  for( KType::Iterator kit=kernel.Begin(); kit!=kernel.End(); kit++ )
+    {
+    *kit=1;
+    }
+
+  typedef itk::MaskedMovingWindowMeanImageFilter< IType, MType, IType, KType > FilterType;
+  typedef itk::SeparableMaskedMeanImageFilter< IType, MType, IType > SepFilterType;
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+
+  // the reference: the sum and the number of the pixels of the mask in
+  // the kernel of each pixel, computed directly
+  typedef itk::Image< long, dim > SumImageType;
+  SumImageType::Pointer sums = SumImageType::New();
+  sums->SetRegions( reader->GetOutput()->GetLargestPossibleRegion() );
+  sums->Allocate();
+  SumImageType::Pointer counts = SumImageType::New();
+  counts->SetRegions( reader->GetOutput()->GetLargestPossibleRegion() );
+  counts->Allocate();
+  const IType::RegionType region = reader->GetOutput()->GetLargestPossibleRegion();
+  itk::ImageRegionIteratorWithIndex< SumImageType > sit( sums, region );
+  for( sit.GoToBegin(); !sit.IsAtEnd(); ++sit )
+    {
+    long sum = 0;
+    long count = 0;
+    for( unsigned k=0; k<kernel.Size(); k++ )
+      {
+      const IType::IndexType idx = sit.GetIndex() + kernel.GetOffset( k );
+      if( region.IsInside( idx ) && mreader->GetOutput()->GetPixel( idx ) == itk::NumericTraits< MPType >::max() )
+        {
+        sum += reader->GetOutput()->GetPixel( idx );
+        count++;
+        }
+      }
+    sit.Set( sum );
+    counts->SetPixel( sit.GetIndex(), count );
+    }
+
+  // the moving window and the separable filter are compared inside the
+  // mask, outside the mask, and on the union, and to the reference
+  const char * modes[3] = { "inside", "outside", "union" };
+  for( unsigned m=0; m<3; m++ )
+    {
+    itk::TimeProbe HTime, STime;
+
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetInput( reader->GetOutput() );
+    filter->SetMaskImage( mreader->GetOutput() );
+    filter->SetKernel( kernel );
+    filter->SetWriteInsideMask( m == 0 );
+    filter->SetReturnUnion( m == 2 );
+    for (unsigned i=0;i<repeats; i++)
+      {
+      HTime.Start();
+      filter->Modified();
+      filter->Update();
+      HTime.Stop();
+      }
+
+    writer->SetInput( filter->GetOutput() );
+    writer->SetFileName( argv[4 + 2 * m] );
+    writer->Update();
+
+    SepFilterType::Pointer sep = SepFilterType::New();
+    sep->SetInput( reader->GetOutput() );
+    sep->SetMaskImage( mreader->GetOutput() );
+    sep->SetRadius( kernel.GetRadius() );
+    sep->SetWriteInsideMask( m == 0 );
+    sep->SetReturnUnion( m == 2 );
+    for (unsigned i=0;i<repeats; i++)
+      {
+      STime.Start();
+      sep->Modified();
+      sep->Update();
+      STime.Stop();
+      }
+
+    writer->SetInput( sep->GetOutput() );
+    writer->SetFileName( argv[5 + 2 * m] );
+    writer->Update();
+
+    // the mean rounded to the nearest value, where the mode writes it and
+    // where the kernel contains a pixel of the mask, and 0 elsewhere
+    IType::Pointer reference = IType::New();
+    reference->SetRegions( region );
+    reference->Allocate();
+    itk::ImageRegionIteratorWithIndex< IType > rit( reference, region );
+    for( rit.GoToBegin(); !rit.IsAtEnd(); ++rit )
+      {
+      const IType::IndexType idx = rit.GetIndex();
+      const bool inMask = mreader->GetOutput()->GetPixel( idx ) == itk::NumericTraits< MPType >::max();
+      const long sum = sums->GetPixel( idx );
+      const long count = counts->GetPixel( idx );
+      const bool write = inMask ? m != 1 : m != 0;
+      rit.Set( write && count > 0 ? (PType)( ( 2 * sum + count ) / ( 2 * count ) ) : 0 );
+      }
+    writer->SetInput( reference );
+    writer->SetFileName( argv[10 + m] );
+    writer->Update();
+
+    std::cout << "Mask " << modes[m] << std::endl;
+    std::cout << "Moving window time " << HTime.GetMeanTime() << std::endl;
+    std::cout << "Separable time " << STime.GetMeanTime() << std::endl;
+    }
+
+  return 0;
+}
+
@@ -0,0 +1,81 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkCommand.h"
+#include "itkSimpleFilterWatcher.h"
+#include "itkNeighborhood.h"
+#include "itkMovingWindowMeanImageFilter.h"
+#include "itkTimeProbe.h"
+
+int main(int, char * argv[])
+{
+  const int dim = 2;
+  
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  unsigned repeats = (unsigned)atoi(argv[1]);
+  itk::TimeProbe OneTime, ManyTime;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[2] );
+  reader->Update();
+  typedef itk::Neighborhood<bool, dim> KType;
+
+  KType kernel;
+  kernel.SetRadius(7);
+  for( KType::Iterator kit=kernel.Begin(); kit!=kernel.End(); kit++ )
+    {
+    *kit=1;
+    }
+
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+
+  // the rounded mean is the same with one thread or several ones, with
+  // the moving window or with the summed area table
+  typedef itk::MovingWindowMeanImageFilter< IType, IType, KType > FilterType;
+  FilterType::Pointer one = FilterType::New();
+  one->SetInput( reader->GetOutput() );
+  one->SetKernel( kernel );
+  one->SetUseSummedAreaTable( false );
+  one->SetNumberOfThreads( 1 );
+  for (unsigned i=0;i<repeats; i++)
+    {
+    OneTime.Start();
+    one->Modified();
+    one->Update();
+    OneTime.Stop();
+    }
+  writer->SetInput( one->GetOutput() );
+  writer->SetFileName( argv[3] );
+  writer->Update();
+
+  FilterType::Pointer many = FilterType::New();
+  many->SetInput( reader->GetOutput() );
+  many->SetKernel( kernel );
+  many->SetUseSummedAreaTable( false );
+  many->SetNumberOfThreads( 7 );
+  for (unsigned i=0;i<repeats; i++)
+    {
+    ManyTime.Start();
+    many->Modified();
+    many->Update();
+    ManyTime.Stop();
+    }
+  writer->SetInput( many->GetOutput() );
+  writer->SetFileName( argv[4] );
+  writer->Update();
+
+  FilterType::Pointer sat = FilterType::New();
+  sat->SetInput( reader->GetOutput() );
+  sat->SetKernel( kernel );
+  sat->SetNumberOfThreads( 3 );
+  writer->SetInput( sat->GetOutput() );
+  writer->SetFileName( argv[5] );
+  writer->Update();
+
+  std::cout << "One thread time " << OneTime.GetMeanTime() << std::endl;
+  std::cout << "Seven threads time " << ManyTime.GetMeanTime() << std::endl;
+  return 0;
+}
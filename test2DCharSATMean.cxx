@@ -0,0 +1,79 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkCommand.h"
+#include "itkSimpleFilterWatcher.h"
+#include "itkNeighborhood.h"
+#include "itkMovingWindowMeanImageFilter.h"
+#include "itkTimeProbe.h"
+
+int main(int, char * argv[])
+{
+  const int dim = 2;
+  
+  unsigned repeats = (unsigned)atoi(argv[1]);
+
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[2] );
+  reader->Update();
+  typedef itk::Neighborhood<bool, dim> KType;
+
+  typedef itk::MovingWindowMeanImageFilter< IType, IType, KType > FilterType;
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+
+  // the summed area table is compared to the moving histogram, with a
+  // small kernel and with a kernel larger than the tiles of the table
+  unsigned radii[2] = { 3, 40 };
+  for( unsigned r=0; r<2; r++ )
+    {
+    KType kernel;
+    kernel.SetRadius(radii[r]);
+    for( KType::Iterator kit=kernel.Begin(); kit!=kernel.End(); kit++ )
+      {
+      *kit=1;
+      }
+
+    itk::TimeProbe STime, HTime;
+
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetInput( reader->GetOutput() );
+    filter->SetKernel( kernel );
+    filter->SetUseSummedAreaTable( true );
+    for (unsigned i=0;i<repeats; i++)
+      {
+      STime.Start();
+      filter->Modified();
+      filter->Update();
+      STime.Stop();
+      }
+
+    writer->SetInput( filter->GetOutput() );
+    writer->SetFileName( argv[3 + 2 * r] );
+    writer->Update();
+
+    FilterType::Pointer hist = FilterType::New();
+    hist->SetInput( reader->GetOutput() );
+    hist->SetKernel( kernel );
+    hist->SetUseSummedAreaTable( false );
+    for (unsigned i=0;i<repeats; i++)
+      {
+      HTime.Start();
+      hist->Modified();
+      hist->Update();
+      HTime.Stop();
+      }
+
+    writer->SetInput( hist->GetOutput() );
+    writer->SetFileName( argv[4 + 2 * r] );
+    writer->Update();
+
+    std::cout << "Radius " << radii[r] << std::endl;
+    std::cout << "Histogram time " << HTime.GetMeanTime() << std::endl;
+    std::cout << "Summed area table time " << STime.GetMeanTime() << std::endl;
+    }
+  return 0;
+}
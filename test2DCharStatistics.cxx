@@ -0,0 +1,117 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkCommand.h"
+#include "itkSimpleFilterWatcher.h"
+#include "itkNeighborhood.h"
+#include "itkVector.h"
+#include "itkVectorIndexSelectionCastImageFilter.h"
+#include "itkMovingWindowStatisticsImageFilter.h"
+#include "itkSeparableStatisticsImageFilter.h"
+#include "itkMovingWindowMeanImageFilter.h"
+#include "itkRankImageFilter.h"
+#include "itkTimeProbe.h"
+
+int main(int, char * argv[])
+{
+  const int dim = 2;
+  
+  unsigned repeats = (unsigned)atoi(argv[1]);
+
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  // mean, variance, sigma, minimum and maximum
+  typedef itk::Vector< double, 5 > SType;
+  typedef itk::Image< SType, dim > SIType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[2] );
+  reader->Update();
+  typedef itk::Neighborhood<bool, dim> KType;
+
+  KType kernel;
+  kernel.SetRadius(5);
+  for( KType::Iterator kit=kernel.Begin(); kit!=kernel.End(); kit++ )
+    {
+    *kit=1;
+    }
+
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+
+  typedef itk::MovingWindowStatisticsImageFilter< IType, SIType, KType > FilterType;
+  typedef FilterType::ComponentsType ComponentsType;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( reader->GetOutput() );
+  filter->SetKernel( kernel );
+
+  itk::TimeProbe STime, SepTime;
+  for (unsigned i=0;i<repeats; i++)
+    {
+    STime.Start();
+    filter->Modified();
+    filter->Update();
+    STime.Stop();
+    }
+
+  typedef itk::VectorIndexSelectionCastImageFilter< SIType, IType > SelectType;
+  SelectType::Pointer select = SelectType::New();
+  select->SetInput( filter->GetOutput() );
+  select->SetIndex( ComponentsType::Mean );
+  writer->SetInput( select->GetOutput() );
+  writer->SetFileName( argv[3] );
+  writer->Update();
+
+  // the mean is the one of the moving window mean
+  typedef itk::MovingWindowMeanImageFilter< IType, IType, KType > MeanFilterType;
+  MeanFilterType::Pointer mean = MeanFilterType::New();
+  mean->SetInput( reader->GetOutput() );
+  mean->SetKernel( kernel );
+  // the selection of the component truncates the mean
+  mean->RoundOutputOff();
+  writer->SetInput( mean->GetOutput() );
+  writer->SetFileName( argv[4] );
+  writer->Update();
+
+  // and the maximum the one of the rank filter
+  SelectType::Pointer selectMax = SelectType::New();
+  selectMax->SetInput( filter->GetOutput() );
+  selectMax->SetIndex( ComponentsType::Maximum );
+  writer->SetInput( selectMax->GetOutput() );
+  writer->SetFileName( argv[5] );
+  writer->Update();
+
+  typedef itk::RankImageFilter< IType, IType, KType > RankFilterType;
+  RankFilterType::Pointer rank = RankFilterType::New();
+  rank->SetInput( reader->GetOutput() );
+  rank->SetKernel( kernel );
+  rank->SetRank( 1 );
+  writer->SetInput( rank->GetOutput() );
+  writer->SetFileName( argv[6] );
+  writer->Update();
+
+  // the separable maximum is exact
+  typedef itk::SeparableStatisticsImageFilter< IType, SIType > SepFilterType;
+  SepFilterType::Pointer sep = SepFilterType::New();
+  sep->SetInput( reader->GetOutput() );
+  sep->SetRadius( kernel.GetRadius() );
+  for (unsigned i=0;i<repeats; i++)
+    {
+    SepTime.Start();
+    sep->Modified();
+    sep->Update();
+    SepTime.Stop();
+    }
+
+  SelectType::Pointer selectSepMax = SelectType::New();
+  selectSepMax->SetInput( sep->GetOutput() );
+  selectSepMax->SetIndex( ComponentsType::Maximum );
+  writer->SetInput( selectSepMax->GetOutput() );
+  writer->SetFileName( argv[7] );
+  writer->Update();
+
+  std::cout << "Statistics time " << STime.GetMeanTime() << std::endl;
+  std::cout << "Separable statistics time " << SepTime.GetMeanTime() << std::endl;
+  return 0;
+}
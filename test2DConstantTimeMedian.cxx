@@ -0,0 +1,109 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkCommand.h"
+#include "itkSimpleFilterWatcher.h"
+#include "itkNeighborhood.h"
+#include "itkRankImageFilter.h"
+#include "itkConstantTimeRankImageFilter.h"
+#include "itkRegionOfInterestImageFilter.h"
+#include "itkTimeProbe.h"
+
+int main(int, char * argv[])
+{
+  const int dim = 2;
+  
+  unsigned repeats = (unsigned)atoi(argv[1]);
+
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[2] );
+  reader->Update();
+  typedef itk::Neighborhood<bool, dim> KType;
+
+  itk::TimeProbe CTime, RTime;
+
+  // a large radius, where the column histograms are the most useful
+  KType kernel;
+  kernel.SetRadius(20);
+  for( KType::Iterator kit=kernel.Begin(); kit!=kernel.End(); kit++ )
+    {
+    *kit=1;
+    }
+
+  typedef itk::ConstantTimeRankImageFilter< IType, IType > FilterType;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( reader->GetOutput() );
+  filter->SetRadius( kernel.GetRadius() );
+  filter->SetRank( 0.5 );
+  for (unsigned i=0;i<repeats; i++)
+    {
+    CTime.Start();
+    filter->Modified();
+    filter->Update();
+    CTime.Stop();
+    }
+
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( filter->GetOutput() );
+  writer->SetFileName( argv[3] );
+  writer->Update();
+
+  typedef itk::RankImageFilter< IType, IType, KType > RankFilterType;
+  RankFilterType::Pointer rank = RankFilterType::New();
+  rank->SetInput(reader->GetOutput());
+  rank->SetKernel(kernel);
+  rank->SetRank( 0.5 );
+  for (unsigned i=0;i<repeats; i++)
+    {
+    RTime.Start();
+    rank->Modified();
+    rank->Update();
+    RTime.Stop();
+    }
+
+  writer->SetInput( rank->GetOutput() );
+  writer->SetFileName( argv[4] );
+  writer->Update();
+
+  // an output region away from the left border of the image: the column
+  // histograms start before the output region
+  IType::RegionType roi = reader->GetOutput()->GetLargestPossibleRegion();
+  IType::IndexType roiIndex;
+  IType::SizeType roiSize;
+  for( unsigned d=0; d<dim; d++ )
+    {
+    roiIndex[d] = roi.GetIndex()[d] + roi.GetSize()[d] / 3;
+    roiSize[d] = roi.GetSize()[d] / 2;
+    }
+  roi.SetIndex( roiIndex );
+  roi.SetSize( roiSize );
+
+  FilterType::Pointer roiFilter = FilterType::New();
+  roiFilter->SetInput( reader->GetOutput() );
+  roiFilter->SetRadius( kernel.GetRadius() );
+  roiFilter->SetRank( 0.5 );
+  typedef itk::RegionOfInterestImageFilter< IType, IType > ROIType;
+  ROIType::Pointer crop = ROIType::New();
+  crop->SetInput( roiFilter->GetOutput() );
+  crop->SetRegionOfInterest( roi );
+  crop->Update();
+  writer->SetInput( crop->GetOutput() );
+  writer->SetFileName( argv[5] );
+  writer->Update();
+
+  ROIType::Pointer rankCrop = ROIType::New();
+  rankCrop->SetInput( rank->GetOutput() );
+  rankCrop->SetRegionOfInterest( roi );
+  rankCrop->Update();
+  writer->SetInput( rankCrop->GetOutput() );
+  writer->SetFileName( argv[6] );
+  writer->Update();
+
+  std::cout << "Rank time " << RTime.GetMeanTime() << std::endl;
+  std::cout << "ConstantTimeRank time " << CTime.GetMeanTime() << std::endl;
+  return 0;
+}
@@ -0,0 +1,161 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkCommand.h"
+#include "itkSimpleFilterWatcher.h"
+#include "itkNeighborhood.h"
+#include "itkRankImageFilter.h"
+#include "itkFastApproxRankImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include <limits>
+#include "itkTimeProbe.h"
+
+int main(int, char * argv[])
+{
+  const int dim = 2;
+  
+  unsigned repeats = (unsigned)atoi(argv[1]);
+
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[2] );
+  reader->Update();
+  typedef itk::Neighborhood<bool, dim> KType;
+
+  KType kernel;
+  kernel.SetRadius(5);
+  for( KType::Iterator kit=kernel.Begin(); kit!=kernel.End(); kit++ )
+    {
+    *kit=1;
+    }
+
+  typedef itk::RankImageFilter< IType, IType, KType > FilterType;
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+
+  // the minimum and the maximum, with van Herk/Gil-Werman and with the
+  // moving histogram
+  for( unsigned r=0; r<=1; r++ )
+    {
+    itk::TimeProbe VTime, HTime;
+
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetInput( reader->GetOutput() );
+    filter->SetKernel( kernel );
+    filter->SetRank( r );
+    filter->SetUseVanHerkGilWerman( true );
+    for (unsigned i=0;i<repeats; i++)
+      {
+      VTime.Start();
+      filter->Modified();
+      filter->Update();
+      VTime.Stop();
+      }
+
+    writer->SetInput( filter->GetOutput() );
+    writer->SetFileName( argv[3 + 2 * r] );
+    writer->Update();
+
+    FilterType::Pointer hist = FilterType::New();
+    hist->SetInput( reader->GetOutput() );
+    hist->SetKernel( kernel );
+    hist->SetRank( r );
+    hist->SetUseVanHerkGilWerman( false );
+    for (unsigned i=0;i<repeats; i++)
+      {
+      HTime.Start();
+      hist->Modified();
+      hist->Update();
+      HTime.Stop();
+      }
+
+    writer->SetInput( hist->GetOutput() );
+    writer->SetFileName( argv[4 + 2 * r] );
+    writer->Update();
+
+    std::cout << "Rank " << r << std::endl;
+    std::cout << "Histogram time " << HTime.GetMeanTime() << std::endl;
+    std::cout << "van Herk/Gil-Werman time " << VTime.GetMeanTime() << std::endl;
+    }
+
+  // the separable maximum is exact
+  typedef itk::FastApproxRankImageFilter< IType, IType > SepFilterType;
+  SepFilterType::Pointer sep = SepFilterType::New();
+  sep->SetInput( reader->GetOutput() );
+  sep->SetRadius( kernel.GetRadius() );
+  sep->SetRank( 1 );
+  writer->SetInput( sep->GetOutput() );
+  writer->SetFileName( argv[7] );
+  writer->Update();
+
+  // on a float image, the windows of the border containing only
+  // infinite values have an infinite minimum or maximum
+  typedef itk::Image< float, dim > FType;
+  FType::Pointer floatImage = FType::New();
+  floatImage->SetRegions( reader->GetOutput()->GetLargestPossibleRegion() );
+  floatImage->Allocate();
+  const FType::IndexType start = floatImage->GetLargestPossibleRegion().GetIndex();
+  const FType::SizeType size = floatImage->GetLargestPossibleRegion().GetSize();
+  itk::ImageRegionIteratorWithIndex< FType > fit( floatImage, floatImage->GetLargestPossibleRegion() );
+  for( fit.GoToBegin(); !fit.IsAtEnd(); ++fit )
+    {
+    const FType::IndexType idx = fit.GetIndex();
+    if( idx[0] - start[0] < 8 && idx[1] - start[1] < 8 )
+      {
+      fit.Set( std::numeric_limits< float >::infinity() );
+      }
+    else if( start[0] + (long)size[0] - idx[0] <= 8 && start[1] + (long)size[1] - idx[1] <= 8 )
+      {
+      fit.Set( -std::numeric_limits< float >::infinity() );
+      }
+    else
+      {
+      fit.Set( reader->GetOutput()->GetPixel( idx ) );
+      }
+    }
+
+  typedef itk::RankImageFilter< FType, FType, KType > FloatFilterType;
+  typedef itk::FastApproxRankImageFilter< FType, FType > FloatSepFilterType;
+  unsigned long errors = 0;
+  for( unsigned r=0; r<=1; r++ )
+    {
+    FloatFilterType::Pointer filter = FloatFilterType::New();
+    filter->SetInput( floatImage );
+    filter->SetKernel( kernel );
+    filter->SetRank( r );
+    filter->SetUseVanHerkGilWerman( true );
+    filter->Update();
+
+    FloatFilterType::Pointer hist = FloatFilterType::New();
+    hist->SetInput( floatImage );
+    hist->SetKernel( kernel );
+    hist->SetRank( r );
+    hist->SetUseVanHerkGilWerman( false );
+    hist->Update();
+
+    FloatSepFilterType::Pointer fsep = FloatSepFilterType::New();
+    fsep->SetInput( floatImage );
+    fsep->SetRadius( kernel.GetRadius() );
+    fsep->SetRank( r );
+    fsep->Update();
+
+    for( fit.GoToBegin(); !fit.IsAtEnd(); ++fit )
+      {
+      const float expected = hist->GetOutput()->GetPixel( fit.GetIndex() );
+      if( filter->GetOutput()->GetPixel( fit.GetIndex() ) != expected
+          || fsep->GetOutput()->GetPixel( fit.GetIndex() ) != expected )
+        {
+        errors++;
+        }
+      }
+    }
+  if( errors > 0 )
+    {
+    std::cerr << errors << " differences on the float image with infinite values" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return 0;
+}
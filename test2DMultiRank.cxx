@@ -0,0 +1,92 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkCommand.h"
+#include "itkSimpleFilterWatcher.h"
+#include "itkNeighborhood.h"
+#include "itkVectorImage.h"
+#include "itkVectorIndexSelectionCastImageFilter.h"
+#include "itkRankImageFilter.h"
+#include "itkMultiRankImageFilter.h"
+#include "itkTimeProbe.h"
+
+int main(int, char * argv[])
+{
+  const int dim = 2;
+  
+  unsigned repeats = (unsigned)atoi(argv[1]);
+
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+  typedef itk::VectorImage< PType, dim > VIType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[2] );
+  reader->Update();
+  typedef itk::Neighborhood<bool, dim> KType;
+
+
+  itk::TimeProbe MTime, RTime;
+
+  KType kernel;
+  kernel.SetRadius(5);
+  for( KType::Iterator kit=kernel.Begin(); kit!=kernel.End(); kit++ )
+    {
+    *kit=1;
+    }
+
+  // the 10th, 50th and 90th percentiles in a single pass
+  typedef itk::MultiRankImageFilter< IType, VIType, KType > FilterType;
+  FilterType::RanksType ranks;
+  ranks.push_back( 0.1 );
+  ranks.push_back( 0.5 );
+  ranks.push_back( 0.9 );
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( reader->GetOutput() );
+  filter->SetKernel(kernel);
+  filter->SetRanks(ranks);
+  for (unsigned i=0;i<repeats; i++)
+    {
+    MTime.Start();
+    filter->Modified();
+    filter->Update();
+    MTime.Stop();
+    }
+
+  // the same percentiles with one filter per rank, compared to the
+  // components of the multi rank output
+  typedef itk::VectorIndexSelectionCastImageFilter< VIType, IType > SelectType;
+  typedef itk::RankImageFilter< IType, IType, KType > RankFilterType;
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  for (unsigned r=0;r<ranks.size(); r++)
+    {
+    SelectType::Pointer select = SelectType::New();
+    select->SetInput( filter->GetOutput() );
+    select->SetIndex( r );
+    writer->SetInput( select->GetOutput() );
+    writer->SetFileName( argv[3 + 2 * r] );
+    writer->Update();
+
+    RankFilterType::Pointer rank = RankFilterType::New();
+    rank->SetInput(reader->GetOutput());
+    rank->SetKernel(kernel);
+    rank->SetRank( ranks[r] );
+    for (unsigned i=0;i<repeats; i++)
+      {
+      RTime.Start();
+      rank->Modified();
+      rank->Update();
+      RTime.Stop();
+      }
+    writer->SetInput( rank->GetOutput() );
+    writer->SetFileName( argv[4 + 2 * r] );
+    writer->Update();
+    }
+
+  // RTime measures one rank at a time
+  std::cout << "Rank time " << RTime.GetMeanTime() * ranks.size() << std::endl;
+  std::cout << "MultiRank time " << MTime.GetMeanTime() << std::endl;
+  return 0;
+}
+
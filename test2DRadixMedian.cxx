@@ -0,0 +1,127 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkCommand.h"
+#include "itkSimpleFilterWatcher.h"
+#include "itkNeighborhood.h"
+#include "itkRankImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTimeProbe.h"
+
+int main(int, char * argv[])
+{
+  const int dim = 2;
+
+  unsigned repeats = (unsigned)atoi(argv[1]);
+
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+  typedef itk::Image< int, dim > IntType;
+  typedef itk::Image< float, dim > FloatType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[2] );
+  reader->Update();
+  typedef itk::Neighborhood<bool, dim> KType;
+
+  // the int image spreads the input values over the whole 32 bits range,
+  // and the float image adds a fraction to them, so the radix histograms
+  // see much more than the 256 values of the input. The order of the
+  // pixels with different input values is unchanged, so the ranks map
+  // back to the ones of the input.
+  const int step = 16777213;
+  IntType::Pointer intImage = IntType::New();
+  intImage->SetRegions( reader->GetOutput()->GetLargestPossibleRegion() );
+  intImage->Allocate();
+  FloatType::Pointer floatImage = FloatType::New();
+  floatImage->SetRegions( reader->GetOutput()->GetLargestPossibleRegion() );
+  floatImage->Allocate();
+  itk::ImageRegionIteratorWithIndex< IType > it( reader->GetOutput(), reader->GetOutput()->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const IType::IndexType idx = it.GetIndex();
+    const long hash = ( idx[0] * 7919L + idx[1] * 104729L ) % 4096;
+    intImage->SetPixel( idx, ( (int)it.Get() - 128 ) * step + (int)( hash * ( step / 4096 ) ) );
+    floatImage->SetPixel( idx, it.Get() + hash / 8192.0f );
+    }
+
+  itk::TimeProbe ITime, FTime;
+
+  KType kernel;
+  kernel.SetRadius(3);
+  for( KType::Iterator kit=kernel.Begin(); kit!=kernel.End(); kit++ )
+    {
+    *kit=1;
+    }
+
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+
+  // the radix histogram on the 32 bits values
+  typedef itk::RankImageFilter< IntType, IntType, KType > IntFilterType;
+  IntFilterType::Pointer intFilter = IntFilterType::New();
+  intFilter->SetInput( intImage );
+  intFilter->SetKernel( kernel );
+  intFilter->SetUseSelectionNetwork( false );
+  for (unsigned i=0;i<repeats; i++)
+    {
+    ITime.Start();
+    intFilter->Modified();
+    intFilter->Update();
+    ITime.Stop();
+    }
+
+  IType::Pointer intResult = IType::New();
+  intResult->SetRegions( reader->GetOutput()->GetLargestPossibleRegion() );
+  intResult->Allocate();
+  itk::ImageRegionIteratorWithIndex< IType > iit( intResult, intResult->GetLargestPossibleRegion() );
+  for( iit.GoToBegin(); !iit.IsAtEnd(); ++iit )
+    {
+    const long long v = intFilter->GetOutput()->GetPixel( iit.GetIndex() );
+    iit.Set( (PType)( ( v + 128LL * step ) / step ) );
+    }
+  writer->SetInput( intResult );
+  writer->SetFileName( argv[3] );
+  writer->Update();
+
+  // the radix histogram on the positions of the float values
+  typedef itk::RankImageFilter< FloatType, FloatType, KType > FloatFilterType;
+  FloatFilterType::Pointer floatFilter = FloatFilterType::New();
+  floatFilter->SetInput( floatImage );
+  floatFilter->SetKernel( kernel );
+  floatFilter->SetUseSelectionNetwork( false );
+  floatFilter->SetUseRankRemapping( true );
+  for (unsigned i=0;i<repeats; i++)
+    {
+    FTime.Start();
+    floatFilter->Modified();
+    floatFilter->Update();
+    FTime.Stop();
+    }
+
+  IType::Pointer floatResult = IType::New();
+  floatResult->SetRegions( reader->GetOutput()->GetLargestPossibleRegion() );
+  floatResult->Allocate();
+  itk::ImageRegionIteratorWithIndex< IType > fit( floatResult, floatResult->GetLargestPossibleRegion() );
+  for( fit.GoToBegin(); !fit.IsAtEnd(); ++fit )
+    {
+    fit.Set( (PType)floatFilter->GetOutput()->GetPixel( fit.GetIndex() ) );
+    }
+  writer->SetInput( floatResult );
+  writer->SetFileName( argv[4] );
+  writer->Update();
+
+  // the reference, on the input values
+  typedef itk::RankImageFilter< IType, IType, KType > FilterType;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( reader->GetOutput() );
+  filter->SetKernel( kernel );
+  writer->SetInput( filter->GetOutput() );
+  writer->SetFileName( argv[5] );
+  writer->Update();
+
+  std::cout << "Int radix time " << ITime.GetMeanTime() << std::endl;
+  std::cout << "Float remap radix time " << FTime.GetMeanTime() << std::endl;
+  return 0;
+}
+
@@ -0,0 +1,112 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkCommand.h"
+#include "itkSimpleFilterWatcher.h"
+#include "itkNeighborhood.h"
+#include "itkSeparableMeanImageFilter.h"
+#include "itkMovingWindowMeanImageFilter.h"
+#include "itkFastApproxRankImageFilter.h"
+#include "itkTimeProbe.h"
+
+int main(int, char * argv[])
+{
+  const int dim = 2;
+  
+  unsigned repeats = (unsigned)atoi(argv[1]);
+
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[2] );
+  reader->Update();
+  typedef itk::Neighborhood<bool, dim> KType;
+
+  KType kernel;
+  kernel.SetRadius(5);
+  for( KType::Iterator kit=kernel.Begin(); kit!=kernel.End(); kit++ )
+    {
+    *kit=1;
+    }
+
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+
+  itk::TimeProbe FMTime, PMTime, FRTime, PRTime;
+
+  // the fused separable mean is the mean of the box
+  typedef itk::SeparableMeanImageFilter< IType, IType > SepMeanType;
+  SepMeanType::Pointer sepMean = SepMeanType::New();
+  sepMean->SetInput( reader->GetOutput() );
+  sepMean->SetRadius( kernel.GetRadius() );
+  for (unsigned i=0;i<repeats; i++)
+    {
+    FMTime.Start();
+    sepMean->Modified();
+    sepMean->Update();
+    FMTime.Stop();
+    }
+  writer->SetInput( sepMean->GetOutput() );
+  writer->SetFileName( argv[3] );
+  writer->Update();
+
+  typedef itk::MovingWindowMeanImageFilter< IType, IType, KType > MeanType;
+  MeanType::Pointer mean = MeanType::New();
+  mean->SetInput( reader->GetOutput() );
+  mean->SetKernel( kernel );
+  writer->SetInput( mean->GetOutput() );
+  writer->SetFileName( argv[4] );
+  writer->Update();
+
+  SepMeanType::Pointer pipeMean = SepMeanType::New();
+  pipeMean->SetInput( reader->GetOutput() );
+  pipeMean->SetRadius( kernel.GetRadius() );
+  pipeMean->SetUseFusedAxes( false );
+  for (unsigned i=0;i<repeats; i++)
+    {
+    PMTime.Start();
+    pipeMean->Modified();
+    pipeMean->Update();
+    PMTime.Stop();
+    }
+
+  // the fused separable median is the one of the pipeline
+  typedef itk::FastApproxRankImageFilter< IType, IType > SepRankType;
+  SepRankType::Pointer sepRank = SepRankType::New();
+  sepRank->SetInput( reader->GetOutput() );
+  sepRank->SetRadius( kernel.GetRadius() );
+  sepRank->SetRank( 0.5 );
+  for (unsigned i=0;i<repeats; i++)
+    {
+    FRTime.Start();
+    sepRank->Modified();
+    sepRank->Update();
+    FRTime.Stop();
+    }
+  writer->SetInput( sepRank->GetOutput() );
+  writer->SetFileName( argv[5] );
+  writer->Update();
+
+  SepRankType::Pointer pipeRank = SepRankType::New();
+  pipeRank->SetInput( reader->GetOutput() );
+  pipeRank->SetRadius( kernel.GetRadius() );
+  pipeRank->SetRank( 0.5 );
+  pipeRank->SetUseFusedAxes( false );
+  for (unsigned i=0;i<repeats; i++)
+    {
+    PRTime.Start();
+    pipeRank->Modified();
+    pipeRank->Update();
+    PRTime.Stop();
+    }
+  writer->SetInput( pipeRank->GetOutput() );
+  writer->SetFileName( argv[6] );
+  writer->Update();
+
+  std::cout << "Fused mean time " << FMTime.GetMeanTime() << std::endl;
+  std::cout << "Pipeline mean time " << PMTime.GetMeanTime() << std::endl;
+  std::cout << "Fused median time " << FRTime.GetMeanTime() << std::endl;
+  std::cout << "Pipeline median time " << PRTime.GetMeanTime() << std::endl;
+  return 0;
+}
@@ -0,0 +1,76 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkCommand.h"
+#include "itkSimpleFilterWatcher.h"
+#include "itkStreamingImageFilter.h"
+#include "itkFastApproxRankImageFilter.h"
+#include "itkTimeProbe.h"
+
+int main(int, char * argv[])
+{
+  const int dim = 2;
+  
+  unsigned repeats = (unsigned)atoi(argv[1]);
+
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[2] );
+  reader->Update();
+
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+
+  itk::TimeProbe PTime, STime;
+
+  // the median computed slab by slab is the one computed at once
+  typedef itk::FastApproxRankImageFilter< IType, IType > SepRankType;
+  SepRankType::Pointer streamRank = SepRankType::New();
+  streamRank->SetInput( reader->GetOutput() );
+  streamRank->SetRadius( 5 );
+  streamRank->SetRank( 0.5 );
+  streamRank->SetUseFusedAxes( false );
+  streamRank->SetNumberOfStreamDivisions( 7 );
+  for (unsigned i=0;i<repeats; i++)
+    {
+    STime.Start();
+    streamRank->Modified();
+    streamRank->Update();
+    STime.Stop();
+    }
+  writer->SetInput( streamRank->GetOutput() );
+  writer->SetFileName( argv[3] );
+  writer->Update();
+
+  SepRankType::Pointer pipeRank = SepRankType::New();
+  pipeRank->SetInput( reader->GetOutput() );
+  pipeRank->SetRadius( 5 );
+  pipeRank->SetRank( 0.5 );
+  pipeRank->SetUseFusedAxes( false );
+  for (unsigned i=0;i<repeats; i++)
+    {
+    PTime.Start();
+    pipeRank->Modified();
+    pipeRank->Update();
+    PTime.Stop();
+    }
+  writer->SetInput( pipeRank->GetOutput() );
+  writer->SetFileName( argv[4] );
+  writer->Update();
+
+  // and the slabs still work when the output of the filter is itself
+  // requested by pieces
+  typedef itk::StreamingImageFilter< IType, IType > StreamingType;
+  StreamingType::Pointer streaming = StreamingType::New();
+  streaming->SetInput( streamRank->GetOutput() );
+  streaming->SetNumberOfStreamDivisions( 3 );
+  writer->SetInput( streaming->GetOutput() );
+  writer->SetFileName( argv[5] );
+  writer->Update();
+
+  std::cout << "Pipeline median time " << PTime.GetMeanTime() << std::endl;
+  std::cout << "Streamed median time " << STime.GetMeanTime() << std::endl;
+  return 0;
+}
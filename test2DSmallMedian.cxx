@@ -0,0 +1,80 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkCommand.h"
+#include "itkSimpleFilterWatcher.h"
+#include "itkNeighborhood.h"
+#include "itkRankImageFilter.h"
+#include "itkTimeProbe.h"
+
+int main(int, char * argv[])
+{
+  const int dim = 2;
+  
+  unsigned repeats = (unsigned)atoi(argv[1]);
+
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[2] );
+  reader->Update();
+  typedef itk::Neighborhood<bool, dim> KType;
+
+  typedef itk::RankImageFilter< IType, IType, KType > FilterType;
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+
+  // the 3x3 median uses the sorted columns, the 5x5 one the generic
+  // network. Both are compared to the moving histogram.
+  for( unsigned radius=1; radius<=2; radius++ )
+    {
+    KType kernel;
+    kernel.SetRadius(radius);
+    for( KType::Iterator kit=kernel.Begin(); kit!=kernel.End(); kit++ )
+      {
+      *kit=1;
+      }
+
+    itk::TimeProbe NTime, HTime;
+
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetInput( reader->GetOutput() );
+    filter->SetKernel( kernel );
+    filter->SetRank( 0.5 );
+    filter->SetUseSelectionNetwork( true );
+    for (unsigned i=0;i<repeats; i++)
+      {
+      NTime.Start();
+      filter->Modified();
+      filter->Update();
+      NTime.Stop();
+      }
+
+    writer->SetInput( filter->GetOutput() );
+    writer->SetFileName( argv[1 + 2 * radius] );
+    writer->Update();
+
+    FilterType::Pointer hist = FilterType::New();
+    hist->SetInput( reader->GetOutput() );
+    hist->SetKernel( kernel );
+    hist->SetRank( 0.5 );
+    hist->SetUseSelectionNetwork( false );
+    for (unsigned i=0;i<repeats; i++)
+      {
+      HTime.Start();
+      hist->Modified();
+      hist->Update();
+      HTime.Stop();
+      }
+
+    writer->SetInput( hist->GetOutput() );
+    writer->SetFileName( argv[2 + 2 * radius] );
+    writer->Update();
+
+    std::cout << "Radius " << radius << std::endl;
+    std::cout << "Histogram time " << HTime.GetMeanTime() << std::endl;
+    std::cout << "Network time " << NTime.GetMeanTime() << std::endl;
+    }
+  return 0;
+}